@@ -51,6 +51,7 @@
 #include <sys/types.h>
 #include "record_manager.h"
 #include "random.h"
+#include "node_key_search.h"
 #include "descriptors.h"
 
 // define BEFORE including rq_provider.h
@@ -168,23 +169,15 @@ namespace bslack_ns {
         inline int getABDegree() {
             return size;
         }
+        // keys are sorted, so both searches count the keys that pass their
+        // test, with SIMD instructions if possible (see node_key_search.h)
         template <class Compare>
         inline int getChildIndex(const K& key, Compare cmp) {
-            int nkeys = getKeyCount();
-            int retval = 0;
-            while (retval < nkeys && !cmp(key, (const K&) keys[retval])) {
-                ++retval;
-            }
-            return retval;
+            return NodeKeySearch<K,Compare>::countNotGreater(keys, getKeyCount(), key, cmp);
         }
         template <class Compare>
         inline int getKeyIndex(const K& key, Compare cmp) {
-            int nkeys = getKeyCount();
-            int retval = 0;
-            while (retval < nkeys && cmp((const K&) keys[retval], key)) {
-                ++retval;
-            }
-            return retval;
+            return NodeKeySearch<K,Compare>::countLess(keys, getKeyCount(), key, cmp);
 
     //        // useful if we have unordered key/value pairs in leaves
     //        for (int i=0;i<nkeys;++i) {
@@ -155,13 +155,10 @@ int bslack_ns::bslack<DEGREE,K,Compare,RecManager>::rangeQuery(const int tid, co
         // else if internal node, explore its children
         } else {
             // find right-most sub-tree that could contain a key in [lo, hi]
-            int nkeys = node->getKeyCount();
-            int r = nkeys;
-            while (r > 0 && cmp(hi, (const K&) node->keys[r-1])) --r;           // subtree rooted at node->ptrs[r] contains only keys > hi
+            int r = node->getChildIndex(hi, cmp);   // subtree rooted at node->ptrs[r+1] contains only keys > hi
 
             // find left-most sub-tree that could contain a key in [lo, hi]
-            int l = 0;
-            while (l < nkeys && !cmp(lo, (const K&) node->keys[l])) ++l;        // subtree rooted at node->ptrs[l] contains only keys < lo
+            int l = node->getChildIndex(lo, cmp);   // subtree rooted at node->ptrs[l-1] contains only keys < lo
 
             // perform DFS from left to right (so push onto stack from right to left)
             for (int i=r;i>=l; --i) stack.push(rqProvider->read_addr(tid, &node->ptrs[i]));
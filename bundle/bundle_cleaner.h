@@ -0,0 +1,261 @@
+// Jacob Nelson
+//
+// This file implements the background cleanup of bundle entries. A pool of
+// BUNDLE_CLEANUP_THREADS workers splits the key range of the data structure
+// into one shard per worker. Each worker cleans its shard incrementally, a
+// batch of B nodes at a time (BUNDLE_CLEANUP_BATCH by default), and remembers the key at
+// which it stopped so that the next batch resumes there instead of starting
+// over from the head of the data structure. Shards are recomputed from the
+// smallest and largest keys in the data structure every time a worker wraps
+// around its shard.
+//
+// A batch cannot resume from the node at which the last one stopped: the
+// worker leaves its epoch between batches, so that node may have been freed,
+// and pinning it would mean holding the epoch (and delaying all reclamation)
+// while the worker sleeps. Trees and skip-lists search for the key in
+// logarithmic time, but a linked list must walk from its head, so a pass of
+// n nodes over a list in batches of B costs O(n^2 / B). For data structures
+// whose CLEANUP_SEEKS_FROM_HEAD is true, B is therefore chosen from the
+// length of the last pass, so that a pass takes at most about
+// BUNDLE_CLEANUP_PASS_BATCHES batches and costs O(n) in total.
+//
+// Workers sleep between batches. The pause is derived from the rate at which
+// updates create bundle entries: if entries are created at rate R and spread
+// over the nodes of the data structure, then visiting every node once every
+// (BUNDLE_CLEANUP_TARGET_LENGTH - 1) * nodes / R seconds keeps the average
+// bundle at roughly BUNDLE_CLEANUP_TARGET_LENGTH entries. Since each worker
+// owns 1 / BUNDLE_CLEANUP_THREADS of the nodes, a batch of B nodes must be
+// cleaned every (BUNDLE_CLEANUP_TARGET_LENGTH - 1) * B *
+// BUNDLE_CLEANUP_THREADS / R seconds. The pause is bounded by
+// BUNDLE_CLEANUP_MIN_SLEEP and BUNDLE_CLEANUP_SLEEP (in microseconds).
+//
+// The data structure must provide:
+//   bool getKeyBounds(int tid, K &lo, K &hi), which returns the smallest and
+//     largest keys it contains, or false if it is empty; and
+//   bool cleanup(int tid, K &cursor, const K &last, int budget), which cleans
+//     the bundles of up to budget nodes with keys in [cursor, last] and
+//     returns true if it reached last, or otherwise sets cursor to the key of
+//     the first node it did not clean; and
+//   static const bool CLEANUP_SEEKS_FROM_HEAD, which is true if cleanup walks
+//     from the head of the data structure to cursor.
+
+#ifndef BUNDLE_BUNDLE_CLEANER_H
+#define BUNDLE_BUNDLE_CLEANER_H
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#include "plaf.h"
+
+// Number of background cleanup threads. Each one needs its own thread id, so
+// data structures must be constructed for BUNDLE_CLEANUP_THREADS more threads
+// than the application uses.
+#ifndef BUNDLE_CLEANUP_THREADS
+#define BUNDLE_CLEANUP_THREADS 1
+#endif
+
+// Number of nodes a worker cleans before pausing.
+#ifndef BUNDLE_CLEANUP_BATCH
+#define BUNDLE_CLEANUP_BATCH 1024
+#endif
+
+// For data structures that seek from their head, the number of batches a
+// pass over a shard is split into. Batches are never smaller than
+// BUNDLE_CLEANUP_BATCH nodes.
+#ifndef BUNDLE_CLEANUP_PASS_BATCHES
+#define BUNDLE_CLEANUP_PASS_BATCHES 16
+#endif
+
+// Shortest pause between batches, in microseconds.
+#ifndef BUNDLE_CLEANUP_MIN_SLEEP
+#define BUNDLE_CLEANUP_MIN_SLEEP 10
+#endif
+
+// Average number of entries per bundle the workers try to maintain.
+#ifndef BUNDLE_CLEANUP_TARGET_LENGTH
+#define BUNDLE_CLEANUP_TARGET_LENGTH 2.0
+#endif
+
+template <typename K, typename DataStructure, typename Provider>
+class BundleCleaner {
+ private:
+  typedef std::chrono::steady_clock clock;
+
+  struct worker {
+    BundleCleaner *cleaner;
+    int shard;
+    int tid;
+    pthread_t thread;
+    // Written by the worker and read when reporting.
+    std::atomic<long long> batches;
+    std::atomic<long long> reclaimed;
+    std::atomic<long long> cleaned;    // Number of bundles cleaned.
+    std::atomic<long long> remaining;  // Entries left in cleaned bundles.
+    volatile char pad[PREFETCH_SIZE_BYTES];
+  };
+
+  DataStructure *const ds_;
+  Provider *const provider_;
+  const int first_tid_;
+  worker workers_[BUNDLE_CLEANUP_THREADS];
+  std::atomic<bool> stop_;
+  clock::time_point start_;
+
+  static void *run(void *args) {
+    worker *w = (worker *)args;
+    w->cleaner->clean(w);
+    pthread_exit(nullptr);
+  }
+
+  // Computes the keys of the shard of a worker. The first and last shards are
+  // unbounded so that sentinel nodes are cleaned as well.
+  void getShard(worker *const w, K &first, K &last) {
+    K lo, hi;
+    first = std::numeric_limits<K>::min();
+    last = std::numeric_limits<K>::max();
+    if (BUNDLE_CLEANUP_THREADS == 1 || !ds_->getKeyBounds(w->tid, lo, hi)) {
+      if (w->shard != 0) {
+        last = first;  // Worker 0 handles everything.
+      }
+      return;
+    }
+    const K span = (hi - lo) / BUNDLE_CLEANUP_THREADS + 1;
+    if (w->shard > 0) {
+      first = lo + span * w->shard;
+    }
+    if (w->shard < BUNDLE_CLEANUP_THREADS - 1) {
+      last = lo + span * (w->shard + 1) - 1;
+    }
+  }
+
+  void clean(worker *const w) {
+    K first, last, cursor;
+    bool wrapped = true;
+    int budget = BUNDLE_CLEANUP_BATCH;
+    long long pass_batches = 0;  // Batches in the current pass.
+    useconds_t sleep = BUNDLE_CLEANUP_SLEEP;
+    long long created = provider_->get_entries_created();
+    clock::time_point then = clock::now();
+    while (!stop_) {
+      usleep(sleep);
+      if (stop_) {
+        break;
+      }
+      if (wrapped) {
+        getShard(w, first, last);
+        cursor = first;
+      }
+      wrapped = ds_->cleanup(w->tid, cursor, last, budget);
+      w->batches.fetch_add(1, std::memory_order_relaxed);
+      ++pass_batches;
+      if (wrapped) {
+        if (DataStructure::CLEANUP_SEEKS_FROM_HEAD) {
+          // The pass visited at most pass_batches * budget nodes.
+          budget = (int)std::max<long long>(
+              BUNDLE_CLEANUP_BATCH,
+              pass_batches * budget / BUNDLE_CLEANUP_PASS_BATCHES);
+        }
+        pass_batches = 0;
+      }
+
+      // Pace the next batch according to the creation rate since this one.
+      const clock::time_point now = clock::now();
+      const long long now_created = provider_->get_entries_created();
+      const double elapsed =
+          std::chrono::duration<double, std::micro>(now - then).count();
+      const double rate = (now_created - created) / std::max(elapsed, 1.0);
+      double pause = (rate <= 0 ? BUNDLE_CLEANUP_SLEEP
+                                : (BUNDLE_CLEANUP_TARGET_LENGTH - 1) *
+                                      budget * BUNDLE_CLEANUP_THREADS / rate);
+      pause = std::min<double>(pause, BUNDLE_CLEANUP_SLEEP);
+      sleep = (useconds_t)std::max<double>(pause, BUNDLE_CLEANUP_MIN_SLEEP);
+      created = now_created;
+      then = now;
+    }
+  }
+
+ public:
+  BundleCleaner(DataStructure *const ds, Provider *const provider,
+                const int first_tid)
+      : ds_(ds), provider_(provider), first_tid_(first_tid) {
+    stop_ = false;
+    start_ = clock::now();
+    for (int i = 0; i < BUNDLE_CLEANUP_THREADS; ++i) {
+      worker *w = &workers_[i];
+      w->cleaner = this;
+      w->shard = i;
+      w->tid = first_tid + i;
+      w->batches = 0;
+      w->reclaimed = 0;
+      w->cleaned = 0;
+      w->remaining = 0;
+      if (pthread_create(&w->thread, nullptr, run, (void *)w)) {
+        std::cerr << "ERROR: could not create thread" << std::endl;
+        exit(-1);
+      }
+    }
+    std::stringstream ss;
+    ss << "Cleanup started: " << BUNDLE_CLEANUP_THREADS << " thread(s)"
+       << std::endl;
+    std::cout << ss.str() << std::flush;
+  }
+
+  ~BundleCleaner() {
+    std::cout << "Stopping cleanup..." << std::endl << std::flush;
+    stop_ = true;
+    for (int i = 0; i < BUNDLE_CLEANUP_THREADS; ++i) {
+      if (pthread_join(workers_[i].thread, nullptr)) {
+        std::cerr << "ERROR: could not join thread" << std::endl;
+        exit(-1);
+      }
+    }
+    std::cout << getStatsString() << std::flush;
+  }
+
+  // Returns true if tid belongs to a cleanup thread.
+  inline bool isCleanupThread(const int tid) {
+    return tid >= first_tid_ && tid < first_tid_ + BUNDLE_CLEANUP_THREADS;
+  }
+
+  // Records that the bundle cleaned by tid had reclaimed entries reclaimed and
+  // remaining entries left.
+  inline void record(const int tid, const int reclaimed, const int remaining) {
+    worker *w = &workers_[tid - first_tid_];
+    w->reclaimed.store(w->reclaimed.load(std::memory_order_relaxed) + reclaimed,
+                       std::memory_order_relaxed);
+    w->cleaned.store(w->cleaned.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+    w->remaining.store(w->remaining.load(std::memory_order_relaxed) + remaining,
+                       std::memory_order_relaxed);
+  }
+
+  std::string getStatsString() {
+    long long batches = 0, reclaimed = 0, cleaned = 0, remaining = 0;
+    for (int i = 0; i < BUNDLE_CLEANUP_THREADS; ++i) {
+      batches += workers_[i].batches;
+      reclaimed += workers_[i].reclaimed;
+      cleaned += workers_[i].cleaned;
+      remaining += workers_[i].remaining;
+    }
+    const double seconds =
+        std::chrono::duration<double>(clock::now() - start_).count();
+    std::stringstream ss;
+    ss << "cleanup batches               : " << batches << std::endl;
+    ss << "cleanup entries reclaimed     : " << reclaimed << std::endl;
+    ss << "cleanup entries reclaimed/s   : " << (long long)(reclaimed / seconds)
+       << std::endl;
+    ss << "cleanup avg bundle length     : "
+       << (cleaned == 0 ? 0 : (reclaimed + remaining) / (double)cleaned)
+       << std::endl;
+    return ss.str();
+  }
+};
+
+#endif  // BUNDLE_BUNDLE_CLEANER_H
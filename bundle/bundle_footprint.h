@@ -0,0 +1,180 @@
+// Jacob Nelson
+//
+// This file defines the memory footprint report of a bundled data structure.
+// Bundles are embedded in the nodes that own them, while their older entries
+// are separate records of the data structure's record manager (or, for the
+// circular bundle, buffers owned by the bundle). A footprint accounts for:
+//   - the reachable nodes, whose size includes the bundles embedded in them;
+//   - the entries of the bundles of those nodes, and the memory they occupy
+//     outside of the nodes;
+//   - records retired but not yet reclaimed, which wait in epoch bags; and
+//   - records held by the record manager's pools for reuse;
+// along with a histogram of the lengths of the bundles.
+//
+// Counting reachable nodes and entries traverses the data structure, so it
+// must not run concurrently with updates. Retired and pooled records are
+// approximate counters that may be read at any time (see record_manager.h).
+
+#ifndef BUNDLE_BUNDLE_FOOTPRINT_H
+#define BUNDLE_BUNDLE_FOOTPRINT_H
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Bucket 0 counts empty bundles, and bucket b > 0 counts bundles whose length
+// is in [2^(b-1), 2^b). The last bucket also counts every longer bundle.
+#ifndef BUNDLE_LENGTH_HISTOGRAM_BUCKETS
+#define BUNDLE_LENGTH_HISTOGRAM_BUCKETS 12
+#endif
+
+class BundleLengthHistogram {
+ public:
+  long long counts[BUNDLE_LENGTH_HISTOGRAM_BUCKETS];
+
+  BundleLengthHistogram() { clear(); }
+
+  void clear() {
+    for (int b = 0; b < BUNDLE_LENGTH_HISTOGRAM_BUCKETS; ++b) {
+      counts[b] = 0;
+    }
+  }
+
+  static inline int bucketOf(const int length) {
+    if (length <= 0) return 0;
+    return std::min(BUNDLE_LENGTH_HISTOGRAM_BUCKETS - 1,
+                    32 - __builtin_clz((unsigned int)length));
+  }
+
+  // Returns the range of lengths counted by bucket b, e.g., "4-7".
+  static std::string bucketName(const int b) {
+    std::stringstream ss;
+    const long long lo = (b == 0 ? 0 : 1LL << (b - 1));
+    const long long hi = (b == 0 ? 0 : (1LL << b) - 1);
+    if (b == BUNDLE_LENGTH_HISTOGRAM_BUCKETS - 1) {
+      ss << lo << "+";
+    } else if (lo == hi) {
+      ss << lo;
+    } else {
+      ss << lo << "-" << hi;
+    }
+    return ss.str();
+  }
+
+  inline void record(const int length) { ++counts[bucketOf(length)]; }
+
+  void merge(const BundleLengthHistogram &other) {
+    for (int b = 0; b < BUNDLE_LENGTH_HISTOGRAM_BUCKETS; ++b) {
+      counts[b] += other.counts[b];
+    }
+  }
+
+  long long count() const {
+    long long total = 0;
+    for (int b = 0; b < BUNDLE_LENGTH_HISTOGRAM_BUCKETS; ++b) {
+      total += counts[b];
+    }
+    return total;
+  }
+};
+
+// Number and total size of a kind of record.
+struct FootprintUsage {
+  long long records = 0;
+  long long bytes = 0;
+
+  inline void add(const long long n, const long long size) {
+    records += n;
+    bytes += n * size;
+  }
+};
+
+class BundleFootprint {
+ public:
+  FootprintUsage nodes;      // Reachable nodes, with their embedded bundles.
+  FootprintUsage bundles;    // Bundles embedded in reachable nodes.
+  FootprintUsage entries;    // Entries of those bundles (bytes outside nodes).
+  FootprintUsage retired_nodes;
+  FootprintUsage retired_entries;
+  FootprintUsage retired_other;  // e.g., descriptors.
+  FootprintUsage pooled_nodes;
+  FootprintUsage pooled_entries;
+  FootprintUsage pooled_other;
+  BundleLengthHistogram lengths;  // Lengths of the bundles counted above.
+
+  // Counts a reachable node of the given size.
+  inline void addNode(const size_t size) { nodes.add(1, size); }
+
+  // Counts a bundle embedded in a reachable node, along with its entries.
+  template <typename Bundle>
+  inline void addBundle(Bundle *const bundle) {
+    const int length = bundle->size();
+    bundles.add(1, sizeof(Bundle));
+    entries.records += length;
+    entries.bytes += bundle->entryBytes();
+    lengths.record(length);
+  }
+
+  // Reads the retired and pooled records of the record manager of a data
+  // structure whose nodes are NodeType and whose bundle entries are EntryType.
+  template <typename NodeType, typename EntryType, typename RecordManager>
+  void addRecords(RecordManager *const recmgr) {
+    auto *node_mgr = recmgr->get((NodeType *)nullptr);
+    auto *entry_mgr = recmgr->get((EntryType *)nullptr);
+    retired_nodes.add(node_mgr->getApproxRetired(), sizeof(NodeType));
+    retired_entries.add(entry_mgr->getApproxRetired(), sizeof(EntryType));
+    pooled_nodes.add(node_mgr->getApproxPooled(), sizeof(NodeType));
+    pooled_entries.add(entry_mgr->getApproxPooled(), sizeof(EntryType));
+    retired_other.bytes = recmgr->getApproxRetiredBytes() -
+                          retired_nodes.bytes - retired_entries.bytes;
+    retired_other.records = recmgr->getApproxRetired() -
+                            retired_nodes.records - retired_entries.records;
+    pooled_other.bytes = recmgr->getApproxPooledBytes() - pooled_nodes.bytes -
+                         pooled_entries.bytes;
+    pooled_other.records = recmgr->getApproxPooled() - pooled_nodes.records -
+                           pooled_entries.records;
+  }
+
+  // Bytes of reachable nodes and entries, and of retired and pooled records.
+  long long totalBytes() const {
+    return nodes.bytes + entries.bytes + retired_nodes.bytes +
+           retired_entries.bytes + retired_other.bytes + pooled_nodes.bytes +
+           pooled_entries.bytes + pooled_other.bytes;
+  }
+
+  // Prints one CSV row per kind of memory (preceded by a header row), each
+  // starting with "memory_footprint,", then the histogram of bundle lengths as
+  // a header row and a row of counts, each starting with "bundle_lengths,".
+  void print(std::ostream &out) const {
+    out << "memory_footprint,kind,records,bytes" << std::endl;
+    printRow(out, "nodes", nodes);
+    printRow(out, "bundles", bundles);
+    printRow(out, "bundle_entries", entries);
+    printRow(out, "retired_nodes", retired_nodes);
+    printRow(out, "retired_entries", retired_entries);
+    printRow(out, "retired_other", retired_other);
+    printRow(out, "pooled_nodes", pooled_nodes);
+    printRow(out, "pooled_entries", pooled_entries);
+    printRow(out, "pooled_other", pooled_other);
+    out << "memory_footprint,total,," << totalBytes() << std::endl;
+    out << "bundle_lengths";
+    for (int b = 0; b < BUNDLE_LENGTH_HISTOGRAM_BUCKETS; ++b) {
+      out << "," << BundleLengthHistogram::bucketName(b);
+    }
+    out << std::endl << "bundle_lengths";
+    for (int b = 0; b < BUNDLE_LENGTH_HISTOGRAM_BUCKETS; ++b) {
+      out << "," << lengths.counts[b];
+    }
+    out << std::endl;
+  }
+
+ private:
+  static void printRow(std::ostream &out, const char *kind,
+                       const FootprintUsage &usage) {
+    out << "memory_footprint," << kind << "," << usage.records << ","
+        << usage.bytes << std::endl;
+  }
+};
+
+#endif  // BUNDLE_BUNDLE_FOOTPRINT_H
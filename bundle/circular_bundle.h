@@ -1,339 +1,276 @@
+// Jacob Nelson
+//
+// This file implements a bundle as a circular buffer of (timestamp, pointer)
+// entries. Entries are addressed by a logical index that only ever grows. The
+// newest entry sits at index head_ - 1 and the oldest one that a range query
+// may still need at index tail_. An entry is stored in slot (index mod
+// capacity), so trimming a bundle only advances tail_ and the slots it frees
+// are overwritten by later updates. Keeping the entries of a node contiguous
+// favors long-lived, frequently updated nodes (e.g., the head of a skiplist or
+// the top of a tree), whose bundles a linked bundle would scatter across many
+// separately allocated entries.
+//
+// When an update finds the buffer full, it doubles the capacity by copying the
+// live entries into a new buffer. Range queries that already loaded the old
+// buffer may still be reading it, so replaced buffers are kept until the
+// memory of the node owning the bundle is reused (see init()) or destroyed.
+// The bundle therefore owns its buffer for as long as the node's memory
+// exists, which requires the allocator to construct and destruct records
+// (i.e., allocator_new).
+
 #ifndef BUNDLE_CIRCULAR_BUNDLE_H
 #define BUNDLE_CIRCULAR_BUNDLE_H
 
 #include <pthread.h>
 #include <sys/types.h>
+
+#include <algorithm>
 #include <atomic>
-#include <mutex>
 
+#include "common_bundle.h"
+#include "linked_bundle.h"
 #include "plaf.h"
-#include "rq_debugging.h"
-
-#define CPU_RELAX asm volatile("pause\n" ::: "memory")
-#define BUNDLE_INIT_CAPACITY 5
-
-// Valid bundle states:
-// ----------------------
-// NORMAL_STATE -- No operations being performed on bundle.
-// PENDING_STATE -- An update is pending.
-// RECLAIM_STATE -- Bundle entries are being reclaimed.
-// RQ_STATE -- A range query is reading the bundle.
-// PENDING_STATE | RESIZE_STATE -- A pending update is resizing the bundle.
-// PENDING_STATE | RECLAIM_STATE -- An update and cleanup are concurrent.
-// PENDING_STATE | RQ_STATE -- An update and range query are concurrent.
-// PENDING_STATE | RECLAIM_STATE | RQ_STATE -- An update, cleanup and rangequery
-// are concurrent. RECLAIM_STATE | RQ_STATE -- Cleanup and a range query are
-// concurrent.
 
-#define NORMAL_STATE 0
-#define PENDING_STATE 1
-#define RESIZE_STATE 2
-#define RECLAIM_STATE 4
-#define RQ_STATE (~7)
-
-#define DEBUG_PRINT(str)                         \
-  if ((i + 1) % 10000 == 0) {                    \
-    std::cout << str << std::endl << std::flush; \
-  }                                              \
-  ++i;
-
-enum op { NOP, INSERT, REMOVE };
-// Stores pointers to nodes and associated timestamps.
+// Number of entries of a newly allocated buffer. Must be a power of two.
+#ifndef BUNDLE_CIRCULAR_INIT_CAPACITY
+#define BUNDLE_CIRCULAR_INIT_CAPACITY 4
+#endif
 
-template <typename NodeType>
-class BundleEntry : public BundleEntryBase<NodeType> {};
+static_assert((BUNDLE_CIRCULAR_INIT_CAPACITY &
+               (BUNDLE_CIRCULAR_INIT_CAPACITY - 1)) == 0,
+              "BUNDLE_CIRCULAR_INIT_CAPACITY must be a power of two");
 
 template <typename NodeType>
-class Bundle : public Bundle<NodeType> {
+class CircularBundle {
  private:
-  // The lower three bits are reserved for marking an ongoing update, resize or
-  // reclaimer. The remaining bits are devoted to keeping track of the number of
-  // concurrent range queries.
-  std::atomic<unsigned int> state_;
-  int volatile base_;      // Index of oldest entry.
-  int volatile curr_;      // Index of newest entry.
-  int volatile capacity_;  // Maximum number of entries.
-  // Entry array and metadata.
-  BundleEntry<NodeType> *volatile entries_;  // Bundle entry array
-
-#ifdef BUNDLE_DEBUG
-  int its_;
-  int last_base_;
-  int updates_;
-#endif
-
-  inline void start_rq() {
-    unsigned int expected_state, upper, lower, new_state;
-    while (true) {
-      expected_state = state_ & ~RESIZE_STATE;
-      upper = expected_state >> 3;             // Get the upper bits of state.
-      lower = expected_state & 7;              // Get lower bits.
-      new_state = ((upper + 1) << 3) | lower;  // Increment number of rqs.
-      if (state_.compare_exchange_weak(expected_state, new_state)) {
-        assert(state_ & RQ_STATE && state_ & ~RESIZE_STATE);
-        break;
-      }
+  struct Entry {
+    std::atomic<timestamp_t> ts_;
+    NodeType *volatile ptr_;
+  };
+
+  struct Buffer {
+    const long long capacity_;  // Always a power of two.
+    Entry *const entries_;
+    Buffer *older_;  // Buffer this one replaced, if any.
+
+    Buffer(const long long capacity, Buffer *const older)
+        : capacity_(capacity), entries_(new Entry[capacity]), older_(older) {}
+    ~Buffer() { delete[] entries_; }
+
+    inline Entry &at(const long long index) {
+      return entries_[index & (capacity_ - 1)];
     }
+  };
+
+  // The buffer is only ever replaced by an update holding the lock of the node
+  // owning the bundle. Readers must load head_ before buf_ so that every entry
+  // below the head they observed is present in the buffer they read.
+  std::atomic<Buffer *> buf_{nullptr};
+  std::atomic<long long> head_;  // One past the newest entry.
+  std::atomic<long long> tail_;  // Oldest entry that may still be needed.
+
+  static inline bool visible(const timestamp_t entry_ts, const timestamp_t ts) {
+    return entry_ts != BUNDLE_PENDING_TIMESTAMP &&
+           entry_ts != BUNDLE_NULL_TIMESTAMP && entry_ts <= ts;
   }
 
-  inline void end_rq() {
-    unsigned int expected_state, upper, lower, new_state;
-    while (true) {
-      expected_state = state_ & ~RESIZE_STATE;
-      assert(state_ & RQ_STATE);
-      upper = expected_state >> 3;             // Get the upper bits of state.
-      lower = expected_state & 7;              // Get lower bits.
-      new_state = ((upper - 1) << 3) | lower;  // Increment number of rqs.
-      if (state_.compare_exchange_weak(expected_state, new_state)) {
-        break;
-      }
+  static void freeBuffers(Buffer *buf) {
+    Buffer *older;
+    while (buf != nullptr) {
+      older = buf->older_;
+      delete buf;
+      buf = older;
     }
   }
 
-  // Doubles the capacity of the bundle. Only called when a new entry is added,
-  // meaning no updates will be lost although some cleanup may be missed.
-  void grow() {
-    unsigned int expected;
-    while (true) {
-      while (state_ & (RECLAIM_STATE | RQ_STATE))
-        ;  // Wait for a concurrent reclaimer or rq.
-      // Move state from pending to pending and resizing to block reclaimers and
-      // range queries.
-      expected = PENDING_STATE;
-      if (state_.compare_exchange_weak(expected, expected | RESIZE_STATE)) {
-        break;
-      }
+  // Doubles the capacity of the bundle. Only called by a prepare, so no entry
+  // is added concurrently, although a concurrent cleanup may advance tail_
+  // while the live entries are copied. Copying entries it trims is harmless.
+  Buffer *grow(Buffer *const old_buf, const long long head) {
+    Buffer *new_buf = new Buffer(old_buf->capacity_ * 2, old_buf);
+    for (long long i = tail_; i < head; ++i) {
+      new_buf->at(i).ts_.store(old_buf->at(i).ts_, std::memory_order_relaxed);
+      new_buf->at(i).ptr_ = old_buf->at(i).ptr_;
     }
-    assert(state_ & (PENDING_STATE | RESIZE_STATE));
-
-    BundleEntry<NodeType> *new_entries =
-        new BundleEntry<NodeType>[capacity_ * 2];
-    int i = base_;
-    int end = curr_;
-    if (i > end) {
-      // Buffer wraps so take into account.
-      end = capacity_ + end;
-    }
-    for (; i <= end; ++i) {
-      // Copy entries to new array.
-      new_entries[i] = entries_[i % capacity_];
-      if (i >= capacity_) {
-        new_entries[i % capacity_] = entries_[i % capacity_];
-      }
-    }
-
-    // Finish the resize.
-    capacity_ = capacity_ * 2;
-    curr_ = end;
-    SOFTWARE_BARRIER;
-    BundleEntry<NodeType> *old_entries = entries_;  // Swap entry arrays.
-    entries_ = new_entries;
-    delete[] old_entries;
-
-    state_.fetch_and(~RESIZE_STATE);
-  }
-
-  void shrink() {
-    // TODO: If the capacity is much larger than the number of valid entries, we
-    // may want to reduce the size.
+    buf_ = new_buf;
+    return new_buf;
   }
 
  public:
-  ~Bundle() { delete[] entries_; }
+  ~CircularBundle() { freeBuffers(buf_); }
 
+  // Buffers survive the node they belong to being retired and reused, so a
+  // reused bundle keeps its (possibly grown) buffer. By now no range query can
+  // still be reading the buffers it replaced.
   void init() {
-    state_ = NORMAL_STATE;
-    base_ = 0;
-    curr_ = -1;
-    capacity_ = BUNDLE_INIT_CAPACITY;
-    entries_ = new BundleEntry<NodeType>[BUNDLE_INIT_CAPACITY];
+    Buffer *buf = buf_.load(std::memory_order_relaxed);
+    if (buf == nullptr) {
+      buf = new Buffer(BUNDLE_CIRCULAR_INIT_CAPACITY, nullptr);
+    } else {
+      freeBuffers(buf->older_);
+      buf->older_ = nullptr;
+    }
+    buf_.store(buf, std::memory_order_relaxed);
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
   }
 
-  // Returns a reference to the node that satisfies the snapshot at the given
-  // timestamp. If all
-  inline NodeType *getPtrByTimestamp(timestamp_t ts) override {
-    // NOTE: Range queries may continuously block updaters from resizing, but
-    // this is expected to be common.
-    start_rq();
-
-    int i = curr_;
-    int end = base_;  // NOTE: We don't have to worry about the base changing
-                      // because we will always find our entry before the base,
-                      // or the base will not be changed.
-
-    // Locate first entry that satisfies snapshot, starting from newest.
-    NodeType *ptr = nullptr;
-    if (i != -1) {
-      // If an entry exists in this bundle.
-      if (end > i) {
-        // Buffer wraps so take into account.
-        i = capacity_ + i;
-      }
-      for (; i >= end; --i) {
-        if (entries_[i % capacity_].ts_ <= ts) {
-          ptr = entries_[i % capacity_].ptr_;
-          break;
-        }
-      }
+  // Appends a pending entry, growing the buffer if every slot is still needed.
+  // Must be called while holding the lock of the node owning the bundle.
+  template <typename RecordManager>
+  inline void prepare(const int tid, NodeType *const ptr,
+                      RecordManager *const recmgr) {
+    const long long head = head_.load(std::memory_order_relaxed);
+    Buffer *buf = buf_.load(std::memory_order_relaxed);
+    if (head - tail_ >= buf->capacity_) {
+      buf = grow(buf, head);
     }
+    // The slot may still be read by a cleanup that has not observed the new
+    // tail, so it becomes pending before its pointer changes.
+    Entry &entry = buf->at(head);
+    entry.ts_ = BUNDLE_PENDING_TIMESTAMP;
+    entry.ptr_ = ptr;
+    head_ = head + 1;
+  }
 
-    end_rq();
-    return ptr;
+  // Labels the pending entry to make it visible to range queries.
+  inline void finalize(timestamp_t ts) {
+    assert(ts != BUNDLE_PENDING_TIMESTAMP);
+    Entry &entry = buf_.load()->at(head_ - 1);
+    assert(entry.ts_ == BUNDLE_PENDING_TIMESTAMP);
+    entry.ts_ = ts;
   }
 
-  inline void reclaimEntries(timestamp_t ts) {
-    unsigned int expected;
-    while (true) {
-      while (state_ & (RESIZE_STATE | RECLAIM_STATE))
-        ;  // Wait until resize is done.
-      expected = (state_ & ~RESIZE_STATE & ~RECLAIM_STATE);
-      // Move state to reclaim only if it is not resizing.
-      if (state_.compare_exchange_weak(expected, expected | RECLAIM_STATE)) {
-        break;
+  // Returns a reference to the node that immediately followed at timestamp ts.
+  inline NodeType *getPtrByTimestamp(timestamp_t ts) {
+    const long long head = head_;
+    Buffer *const buf = buf_;
+    long long i = head - 1;
+    if (unlikely(i < 0)) {
+      return nullptr;
+    }
+    while (unlikely(buf->at(i).ts_ == BUNDLE_PENDING_TIMESTAMP)) {
+      CPU_RELAX;
+    }
+    // Entries older than tail_ may have been overwritten, but the entry this
+    // range query needs is never older than tail_.
+    const long long end = std::max((long long)tail_, head - buf->capacity_);
+    for (; i >= end; --i) {
+      Entry &entry = buf->at(i);
+      if (likely(visible(entry.ts_, ts))) {
+        return entry.ptr_;
       }
     }
-    assert(state_ & (~RESIZE_STATE));
-    assert(state_ & RECLAIM_STATE);
+    return nullptr;
+  }
 
-    int i = curr_;
-    int end = base_;
-    if (i == end || i == -1) {
-      state_.fetch_and(~RECLAIM_STATE);
-      return;
+  // Reclaims any entries that are older than the newest entry that is at least
+  // as old as ts by advancing the tail. The newest finalized entry is always
+  // kept. Nothing is freed since slots are reused in place. Returns the number
+  // of entries reclaimed.
+  template <typename RecordManager>
+  inline int reclaimEntries(const int tid, timestamp_t ts,
+                            RecordManager *const recmgr) {
+    const long long head = head_;
+    Buffer *const buf = buf_;
+    long long tail = tail_;
+    long long i = head - 1;
+    if (i >= tail && buf->at(i).ts_ == BUNDLE_PENDING_TIMESTAMP) {
+      --i;  // Skip the entry of an ongoing update.
     }
-
-    // Handle wrapping.
-    if (end > i) {
-      i = capacity_ + i;
+    if (i <= tail) {
+      return 0;  // Nothing to do.
     }
 
-    if (ts == BUNDLE_NULL_TIMESTAMP) {
-      // No active range queries.
-      base_ = curr_;
-      for (i = i - 1; i >= end; --i) {
-        entries_[i % capacity_].marked_ = true;
-      }
-    } else {
-      // Locate reclaimable entries.
-      bool set = false;
-      for (; i >= end; --i) {
-        if (entries_[i % capacity_].ts_ != BUNDLE_NULL_TIMESTAMP &&
-            entries_[i % capacity_].ts_ <= ts) {
-          // Found first entry to retire at index i - 1, so set base to i.
-          if (!set) {
-#ifdef BUNDLE_DEBUG
-            last_base_ = base_;
-#endif
-            base_ = i % capacity_;
-            assert(base_ >= 0);
-            assert(entries_[base_].marked_ == false);
-            set = true;
-          } else {
-            entries_[i % capacity_].marked_ = true;
-          }
-        }
+    // If there are no active RQs then every entry but the newest can be
+    // reclaimed. Otherwise keep the first entry the oldest RQ may need.
+    if (ts != BUNDLE_NULL_TIMESTAMP) {
+      while (i > tail && !visible(buf->at(i).ts_, ts)) {
+        --i;
       }
     }
 
-    state_.fetch_and(~RECLAIM_STATE);
+    // Several cleanups may race, so the tail only moves forward.
+    while (i > tail && !tail_.compare_exchange_weak(tail, i))
+      ;
+    return (i > tail ? (int)(i - tail) : 0);
   }
 
-  inline void prepare(NodeType *const ptr) {
-    unsigned int expected;
-    while (true) {
-      while (state_ & PENDING_STATE)
-        ;  // Wait for ongoing op to finish.
-      expected = state_ & ~PENDING_STATE;
-      if (state_.compare_exchange_weak(expected, expected | PENDING_STATE)) {
-        break;
-      }
-    }
-    assert(state_ & PENDING_STATE);
+  // The buffer belongs to the memory of the node owning the bundle, so there
+  // is nothing to retire.
+  template <typename RecordManager>
+  inline void retireEntries(const int tid, RecordManager *const recmgr) {}
 
-    if (curr_ != -1 && (curr_ + 1) % capacity_ == base_) {
-      // Resize if we have run out of room.
-      grow();
-    }
-    SOFTWARE_BARRIER;
-    entries_[(curr_ + 1) % capacity_].ptr_ = ptr;
-  }
+  // Returns true if the bundle holds more than length entries. Must be called
+  // while holding the lock of the node owning the bundle.
+  inline bool longerThan(const int length) { return head_ - tail_ > length; }
 
-  inline void finalize(timestamp_t ts) {
-    // Assumes the bundles are in the pending state.
-    assert(state_ & PENDING_STATE && !(state_ & (RESIZE_STATE)));
-    assert(curr_ == -1 || (curr_ + 1) % capacity_ != base_);
-#ifdef BUNDLE_DEBUG
-    if (curr_ == -1) {
-      its_ = ts;
-      assert(its_ != 0);
-    }
-    ++updates_;
-#endif
-    entries_[(curr_ + 1) % capacity_].ts_ = ts;
-    entries_[(curr_ + 1) % capacity_].marked_ = false;
-    SOFTWARE_BARRIER;
-    curr_ = (curr_ + 1) % capacity_;
-    state_.fetch_and(~PENDING_STATE);
-  }
+  // [UNSAFE] Returns the number of bundle entries.
+  int size() { return head_ - tail_; }
 
-  // [UNSAFE]. Returns the number of entries in the bundle.
-  inline int size() override {
-    if (curr_ == -1) {
-      return 0;
-    } else if (base_ > curr_) {
-      return (capacity_ - base_) + curr_;
-    } else {
-      return curr_ - base_;
+  // [UNSAFE] Returns the number of bytes of the buffers, including those that
+  // were replaced but not yet freed.
+  long long entryBytes() {
+    long long bytes = 0;
+    for (Buffer *buf = buf_; buf != nullptr; buf = buf->older_) {
+      bytes += sizeof(Buffer) + buf->capacity_ * sizeof(Entry);
     }
+    return bytes;
   }
 
-  NodeType *first(timestamp_t &ts) override {
-    // If the bundle has no entries, return nullptr.
-    if (curr_ == -1) {
-      ts = -1;
+  inline NodeType *first(timestamp_t &ts) {
+    const long long head = head_;
+    if (head == 0) {
+      ts = BUNDLE_NULL_TIMESTAMP;
       return nullptr;
     }
-    ts = entries_[curr_].ts_;
-    return entries_[curr_].ptr_;
+    Entry &entry = buf_.load()->at(head - 1);
+    ts = entry.ts_;
+    return entry.ptr_;
   }
 
-  // [UNSAFE]
-  std::pair<NodeType *, timestamp_t> *get(int &length) override {
+  // [UNSAFE] Returns the entries from newest to oldest.
+  std::pair<NodeType *, timestamp_t> *get(int &length) {
+    const long long head = head_;
+    const long long tail = tail_;
+    Buffer *const buf = buf_;
     std::pair<NodeType *, timestamp_t> *retarr =
-        new std::pair<NodeType *, timestamp_t>[capacity_];
-    if (curr_ == -1) {
-      length = 0;
-      return retarr;
-    }
-    NodeType *ptr;
-    timestamp_t ts;
+        new std::pair<NodeType *, timestamp_t>[head - tail];
     int pos = 0;
-    for (int i = base_; i <= (base_ > curr_ ? capacity_ + curr_ : curr_);
-         ++i, ++pos) {
-      ptr = entries_[i % capacity_].ptr_;
-      ts = entries_[i % capacity_].ts_;
-      retarr[pos] = std::pair<NodeType *, timestamp_t>(ptr, ts);
+    for (long long i = head - 1; i >= tail; --i) {
+      retarr[pos++] = std::pair<NodeType *, timestamp_t>(buf->at(i).ptr_,
+                                                         buf->at(i).ts_);
     }
     length = pos;
     return retarr;
   }
 
-  string __attribute__((noinline)) dump(timestamp_t ts) override {
+  // [UNSAFE] Checks that no entry is pending and that timestamps do not
+  // increase from the newest entry to the oldest.
+  bool validate() {
+    Buffer *const buf = buf_;
+    for (long long i = head_ - 1; i >= tail_; --i) {
+      timestamp_t ts = buf->at(i).ts_;
+      if (ts == BUNDLE_PENDING_TIMESTAMP || ts == BUNDLE_NULL_TIMESTAMP ||
+          (i > tail_ && buf->at(i - 1).ts_ > ts)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  string __attribute__((noinline)) dump(timestamp_t ts) {
     std::stringstream ss;
+    Buffer *const buf = buf_;
     ss << "(ts=" << ts << ") : ";
-    long i = 0;
-    for (int i = 0; i < capacity_; ++i) {
-      ss << "<" << entries_[i].ts_ << "," << entries_[i].ptr_ << ","
-         << entries_[i].marked_ << ">"
-         << ", ";
+    for (long long i = head_ - 1; i >= tail_; --i) {
+      ss << "<" << buf->at(i).ts_ << "," << buf->at(i).ptr_ << ">"
+         << "-->";
     }
-    ss << " [curr_ = " << curr_ << ", base_ = " << base_
-#ifdef BUNDLE_DEBUG
-       << ", updates_ = " << updates_ << ", last_base_ = " << last_base_
-#endif
-       << "]" << std::endl;
+    ss << "(end) [head=" << head_ << ", tail=" << tail_
+       << ", capacity=" << buf->capacity_ << "]" << std::endl;
     return ss.str();
   }
 };
 
-#endif  // BUNDLE_CIRCULAR_BUNDLE_H
\ No newline at end of file
+#endif  // BUNDLE_CIRCULAR_BUNDLE_H
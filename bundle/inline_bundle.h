@@ -0,0 +1,279 @@
+// Jacob Nelson
+//
+// This file implements a bundle whose newest entry is embedded in the bundle
+// itself (and therefore in the node). Older entries are kept in a linked list
+// of bundle entries, exactly like LinkedBundle. Since a bundle rarely holds
+// more than one live entry once stale entries are cleaned up, a range query
+// can usually resolve a hop by reading the node it is already visiting instead
+// of dereferencing a separately allocated entry.
+//
+// Only range queries read a bundle concurrently with its writers. prepare,
+// finalize and reclaimEntries must be called while holding the lock of the
+// node owning the bundle, so this bundle does not support data structures
+// that prepare bundles without locking nodes (such as the bundled BST).
+
+#ifndef BUNDLE_INLINE_BUNDLE_H
+#define BUNDLE_INLINE_BUNDLE_H
+
+#include <atomic>
+
+#include "common_bundle.h"
+#include "linked_bundle.h"
+#include "plaf.h"
+
+template <typename NodeType>
+class InlineBundle {
+ private:
+  // Newest entry. A pending timestamp blocks readers until the update that
+  // prepared it is finalized.
+  std::atomic<timestamp_t> ts_;
+  NodeType *volatile ptr_;
+  // Older entries, newest first. Each one is a previous value of the inline
+  // entry that was pushed down when the bundle was prepared.
+  std::atomic<BundleEntry<NodeType> *> next_;
+
+  // An initialized bundle that was never prepared holds no entry.
+  inline bool empty() { return ts_ == BUNDLE_NULL_TIMESTAMP && ptr_ == nullptr; }
+
+ public:
+  ~InlineBundle() {}
+
+  void init() {
+    ts_ = BUNDLE_NULL_TIMESTAMP;
+    ptr_ = nullptr;
+    next_ = nullptr;
+  }
+
+  // Pushes the current inline entry onto the list of older entries and
+  // replaces it with a pending one. Must be called while holding the lock of
+  // the node owning the bundle.
+  template <typename RecordManager>
+  inline void prepare(const int tid, NodeType *const ptr,
+                      RecordManager *const recmgr) {
+    if (!empty()) {
+      BundleEntry<NodeType> *old_entry =
+          recmgr->template allocate<BundleEntry<NodeType>>(tid);
+      if (old_entry == nullptr) {
+        std::cerr << "ERROR: could not allocate bundle entry" << std::endl;
+        exit(-1);
+      }
+      old_entry->init(ts_, ptr_, next_);
+      next_ = old_entry;
+    }
+    // Readers that observed the old timestamp revalidate it after reading the
+    // pointer, so the timestamp must become pending before the pointer moves.
+    ts_ = BUNDLE_PENDING_TIMESTAMP;
+    ptr_ = ptr;
+  }
+
+  // Labels the pending entry to make it visible to range queries.
+  inline void finalize(timestamp_t ts) {
+    assert(ts != BUNDLE_PENDING_TIMESTAMP);
+    assert(ts_ == BUNDLE_PENDING_TIMESTAMP);
+    ts_ = ts;
+  }
+
+  // Returns a reference to the node that immediately followed at timestamp ts.
+  inline NodeType *getPtrByTimestamp(timestamp_t ts) {
+    // Common case: the inline entry satisfies the range query.
+    while (true) {
+      timestamp_t inline_ts = ts_;
+      if (unlikely(inline_ts == BUNDLE_PENDING_TIMESTAMP)) {
+        CPU_RELAX;
+        continue;
+      }
+      if (likely(inline_ts <= ts)) {
+        NodeType *ptr = ptr_;
+        SOFTWARE_BARRIER;
+        if (likely(ts_ == inline_ts)) {
+          return ptr;
+        }
+        continue;  // Raced with an update; try again.
+      }
+      break;
+    }
+
+    // The inline entry is newer than ts. Older entries are only ever removed
+    // once no active range query needs them, so the list can be walked.
+    BundleEntry<NodeType> *curr = next_;
+    while (curr != nullptr && curr->ts_ > ts) {
+      curr = curr->next_;
+    }
+    return (curr == nullptr ? nullptr : curr->ptr_);
+  }
+
+  // Reclaims any entries that are older than the newest entry that is at least
+  // as old as ts. The inline entry is never reclaimed. Must be called while
+  // holding the lock of the node owning the bundle, so that no prepare moves
+  // the inline entry between reading its timestamp and cutting the list.
+  // Returns the number of entries reclaimed.
+  template <typename RecordManager>
+  inline int reclaimEntries(const int tid, timestamp_t ts,
+                            RecordManager *const recmgr) {
+    std::atomic<BundleEntry<NodeType> *> *link;
+    const timestamp_t inline_ts = ts_;
+    timestamp_t pred_ts = inline_ts;
+    if (pred_ts == BUNDLE_PENDING_TIMESTAMP) {
+      // The newest visible entry is the first older entry.
+      BundleEntry<NodeType> *pred = next_;
+      if (pred == nullptr) {
+        return 0;  // Nothing to do.
+      }
+      pred_ts = pred->ts_;
+      link = &pred->next_;
+    } else {
+      link = &next_;
+    }
+    SOFTWARE_BARRIER;
+    BundleEntry<NodeType> *curr = *link;
+    if (curr == nullptr) {
+      return 0;  // Nothing to do.
+    }
+
+    // If there are no active RQs, or the oldest active RQ is newer than the
+    // newest entry, then every older entry can be reclaimed. Otherwise keep
+    // the first entry the oldest RQ may need.
+    if (ts != BUNDLE_NULL_TIMESTAMP && pred_ts > ts) {
+      while (curr != nullptr && curr->ts_ > ts) {
+        link = &curr->next_;
+        curr = curr->next_;
+      }
+      if (curr == nullptr) {
+        return 0;  // Nothing to do.
+      }
+      link = &curr->next_;
+      curr = curr->next_;
+      if (curr == nullptr) {
+        return 0;  // Nothing to do.
+      }
+    }
+    // A prepare would have changed the inline timestamp.
+    assert(ts_ == inline_ts);
+    *link = nullptr;
+
+    BundleEntry<NodeType> *next;
+    int reclaimed = 0;
+    while (curr != nullptr) {
+      next = curr->next_;
+      curr->mark(ts);
+#ifndef BUNDLE_CLEANUP_NO_FREE
+      recmgr->retire(tid, curr);
+#endif
+      curr = next;
+      ++reclaimed;
+    }
+    return reclaimed;
+  }
+
+  // Retires every older entry. Called when the node owning the bundle is
+  // retired. The entries are left linked for range queries still traversing
+  // the node.
+  template <typename RecordManager>
+  inline void retireEntries(const int tid, RecordManager *const recmgr) {
+#ifndef BUNDLE_CLEANUP_NO_FREE
+    BundleEntry<NodeType> *curr = next_;
+    BundleEntry<NodeType> *next;
+    while (curr != nullptr) {
+      next = curr->next_;
+      recmgr->retire(tid, curr);
+      curr = next;
+    }
+#endif
+  }
+
+  // Returns true if the bundle holds more than length entries. Visits at most
+  // length + 1 entries. Must be called while holding the lock of the node
+  // owning the bundle.
+  inline bool longerThan(int length) {
+    if (empty()) {
+      return false;
+    } else if (length-- == 0) {
+      return true;  // The inline entry alone is too many.
+    }
+    BundleEntry<NodeType> *curr = next_;
+    while (curr != nullptr) {
+      if (length-- == 0) {
+        return true;
+      }
+      curr = curr->next_;
+    }
+    return false;
+  }
+
+  // [UNSAFE] Returns the number of bundle entries.
+  int size() {
+    int size = (empty() ? 0 : 1);
+    BundleEntry<NodeType> *curr = next_;
+    while (curr != nullptr) {
+      ++size;
+      curr = curr->next_;
+    }
+    return size;
+  }
+
+  // [UNSAFE] Returns the number of bytes of the older entries. The newest one
+  // is part of the bundle itself.
+  long long entryBytes() {
+    const int size = this->size();
+    return (size > 1 ? size - 1 : 0) * sizeof(BundleEntry<NodeType>);
+  }
+
+  inline NodeType *first(timestamp_t &ts) {
+    ts = ts_;
+    return ptr_;
+  }
+
+  std::pair<NodeType *, timestamp_t> *get(int &length) {
+    int size = this->size();
+    std::pair<NodeType *, timestamp_t> *retarr =
+        new std::pair<NodeType *, timestamp_t>[size];
+    int pos = 0;
+    if (!empty()) {
+      retarr[pos++] = std::pair<NodeType *, timestamp_t>(ptr_, ts_);
+    }
+    BundleEntry<NodeType> *curr = next_;
+    while (curr != nullptr && pos < size) {
+      retarr[pos++] = std::pair<NodeType *, timestamp_t>(curr->ptr_, curr->ts_);
+      curr = curr->next_;
+    }
+    length = pos;
+    return retarr;
+  }
+
+  // [UNSAFE] Checks that no entry is pending and that timestamps do not
+  // increase from the newest entry to the oldest.
+  bool validate() {
+    if (empty()) {
+      return next_ == nullptr;
+    }
+    timestamp_t newer_ts = ts_;
+    if (newer_ts == BUNDLE_PENDING_TIMESTAMP) {
+      return false;
+    }
+    BundleEntry<NodeType> *curr = next_;
+    while (curr != nullptr) {
+      if (curr->ts_ == BUNDLE_PENDING_TIMESTAMP ||
+          curr->ts_ == BUNDLE_NULL_TIMESTAMP || curr->ts_ > newer_ts) {
+        return false;
+      }
+      newer_ts = curr->ts_;
+      curr = curr->next_;
+    }
+    return true;
+  }
+
+  string __attribute__((noinline)) dump(timestamp_t ts) {
+    std::stringstream ss;
+    ss << "(ts=" << ts << ") : (inline)<" << ts_ << "," << ptr_ << ">-->";
+    BundleEntry<NodeType> *curr = next_;
+    while (curr != nullptr) {
+      ss << "<" << curr->ts_ << "," << curr->ptr_ << "," << curr->next_ << ">"
+         << "-->";
+      curr = curr->next_;
+    }
+    ss << "(end)" << std::endl;
+    return ss.str();
+  }
+};
+
+#endif  // BUNDLE_INLINE_BUNDLE_H
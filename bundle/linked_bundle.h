@@ -1,7 +1,11 @@
 // Jacob Nelson
 //
 // This file implements a bundle as a linked list of bundle entries. A bundle is
-// prepared by CASing the head of the bundle to a pending entry.
+// prepared by CASing the head of the bundle to a pending entry. Bundle entries
+// are records of the data structure's record manager. They are taken from its
+// per-thread pools when a bundle is prepared and retired (i.e., handed back to
+// the pool once no active operation can still reach them) when they are
+// trimmed or when the node owning the bundle is retired.
 
 #ifndef BUNDLE_LINKED_BUNDLE_H
 #define BUNDLE_LINKED_BUNDLE_H
@@ -45,6 +49,15 @@ class BundleEntry {
     deleted_ts_ = BUNDLE_NULL_TIMESTAMP;
   }
 
+  // Record managers do not run constructors, so entries taken from a pool are
+  // (re)initialized here instead.
+  inline void init(timestamp_t ts, NodeType *ptr, BundleEntry *next) {
+    ts_.store(ts, std::memory_order_relaxed);
+    ptr_ = ptr;
+    next_.store(next, std::memory_order_relaxed);
+    deleted_ts_ = BUNDLE_NULL_TIMESTAMP;
+  }
+
   void set_ts(const timestamp_t ts) { ts_ = ts; }
   void set_ptr(NodeType *const ptr) { this->ptr_ = ptr; }
   void set_next(BundleEntry *const next) { next_ = next; }
@@ -52,7 +65,7 @@ class BundleEntry {
   timestamp_t marked() { return deleted_ts_; }
 
   inline void validate() {
-    if (ts_ < next_->ts_) {
+    if (next_ != nullptr && ts_ < next_.load()->ts_) {
       std::cout << "Invalid bundle" << std::endl;
       exit(1);
     }
@@ -62,8 +75,9 @@ class BundleEntry {
 template <typename NodeType>
 class LinkedBundle {
  private:
+  // The oldest entry of a bundle points to nullptr, which stands for the
+  // reference held by the node before its first update.
   std::atomic<BundleEntry<NodeType> *> head_;
-  BundleEntry<NodeType> *volatile tail_;
 
 #ifdef BUNDLE_DEBUG
   volatile int updates = 0;
@@ -72,32 +86,29 @@ class LinkedBundle {
 #endif
 
  public:
-  ~LinkedBundle() {
-    BundleEntry<NodeType> *curr = head_;
-    BundleEntry<NodeType> *next;
-    while (curr != tail_) {
-      assert(curr != nullptr);
-      next = curr->next_;
-      delete curr;
-      curr = next;
-    }
-    delete tail_;
-  }
+  // Entries belong to the record manager, which releases them when the owning
+  // node is retired (see retireEntries()). Nothing is left to free here.
+  ~LinkedBundle() {}
 
-  void init() {
-    tail_ = new BundleEntry<NodeType>(BUNDLE_NULL_TIMESTAMP, nullptr, nullptr);
-    head_ = tail_;
-  }
+  void init() { head_ = nullptr; }
 
   // Inserts a new rq_bundle_node at the head of the bundle.
-  inline void prepare(NodeType *const ptr) {
+  template <typename RecordManager>
+  inline void prepare(const int tid, NodeType *const ptr,
+                      RecordManager *const recmgr) {
     BundleEntry<NodeType> *new_entry =
-        new BundleEntry<NodeType>(BUNDLE_PENDING_TIMESTAMP, ptr, nullptr);
+        recmgr->template allocate<BundleEntry<NodeType>>(tid);
+    if (new_entry == nullptr) {
+      std::cerr << "ERROR: could not allocate bundle entry" << std::endl;
+      exit(-1);
+    }
+    new_entry->init(BUNDLE_PENDING_TIMESTAMP, ptr, nullptr);
 
 #ifdef BUNDLE_LOCKFREE
     while (true) {
       BundleEntry<NodeType> *expected = head_;
-      if (expected->ts_ != BUNDLE_PENDING_TIMESTAMP &&
+      if ((expected == nullptr ||
+           expected->ts_ != BUNDLE_PENDING_TIMESTAMP) &&
           head_.compare_exchange_weak(expected, new_entry)) {
         new_entry->next_ = expected;
 #ifdef BUNDLE_DEBUG
@@ -106,7 +117,8 @@ class LinkedBundle {
         return;
       }
       // long i = 0;
-      while (expected->ts_ == BUNDLE_PENDING_TIMESTAMP) {
+      while (expected != nullptr &&
+             expected->ts_ == BUNDLE_PENDING_TIMESTAMP) {
         // DEBUG_PRINT("insertAtHead");
         CPU_RELAX;
       }
@@ -130,19 +142,33 @@ class LinkedBundle {
     head_.load()->ts_ = ts;
   }
 
+  // Points the pending entry to ptr instead. Used by an update that prepared
+  // the bundle but then failed to change the reference it tracks, so that
+  // the entry it must still finalize repeats the current reference.
+  inline void redirect(NodeType *const ptr) {
+    assert(head_.load()->ts_ == BUNDLE_PENDING_TIMESTAMP);
+    head_.load()->ptr_ = ptr;
+  }
+
   // Returns a reference to the node that immediately followed at timestamp ts.
   inline NodeType *getPtrByTimestamp(timestamp_t ts) {
     // Start at head and work backwards until edge is found.
     BundleEntry<NodeType> *curr = head_;
     long i = 0;
+    if (unlikely(curr == nullptr)) {
+      return nullptr;
+    }
     while (unlikely(curr->ts_ == BUNDLE_PENDING_TIMESTAMP)) {
       // DEBUG_PRINT("getPtrByTimestamp");
       CPU_RELAX;
     }
-    while (unlikely(curr != tail_ && curr->ts_ > ts)) {
+    while (unlikely(curr != nullptr && curr->ts_ > ts)) {
       assert(curr->ts_ != BUNDLE_NULL_TIMESTAMP);
       curr = curr->next_;
     }
+    if (unlikely(curr == nullptr)) {
+      return nullptr;
+    }
 #ifdef BUNDLE_DEBUG
     if (curr->marked()) {
       std::cout << dump(0) << std::flush;
@@ -153,39 +179,46 @@ class LinkedBundle {
   }
 
   // Reclaims any edges that are older than ts. At the moment this should be
-  // ordered before adding a new entry to the bundle.
-  inline void reclaimEntries(timestamp_t ts) {
+  // ordered before adding a new entry to the bundle. Trimmed entries are
+  // retired rather than freed since concurrent range queries may still be
+  // reading them. Returns the number of entries reclaimed.
+  template <typename RecordManager>
+  inline int reclaimEntries(const int tid, timestamp_t ts,
+                            RecordManager *const recmgr) {
     // Obtain a reference to the pred non-reclaimable entry and first
     // reclaimable one.
     BundleEntry<NodeType> *pred = head_;
     long i = 0;
-    if (pred->ts_ == BUNDLE_PENDING_TIMESTAMP) {
+    if (pred != nullptr && pred->ts_ == BUNDLE_PENDING_TIMESTAMP) {
       // DEBUG_PRINT("reclaimEntries");
       pred = pred->next_;
     }
     SOFTWARE_BARRIER;
+    if (pred == nullptr) {
+      return 0;  // Nothing to do.
+    }
     BundleEntry<NodeType> *curr = pred->next_;
-    if (pred == tail_ || curr == tail_) {
-      return;  // Nothing to do.
+    if (curr == nullptr) {
+      return 0;  // Nothing to do.
     }
 
     // If there are no active RQs then we can recycle all edges, but the
     // newest (i.e., head). Similarly if the oldest active RQ is newer than
     // the newest entry, we can reclaim all older entries.
     if (ts == BUNDLE_NULL_TIMESTAMP || pred->ts_ <= ts) {
-      pred->next_ = tail_;
+      pred->next_ = nullptr;
     } else {
       // Traverse from head and remove nodes that are lower than ts.
-      while (curr != tail_ && curr->ts_ > ts) {
+      while (curr != nullptr && curr->ts_ > ts) {
         pred = curr;
         curr = curr->next_;
       }
-      if (curr != tail_) {
+      if (curr != nullptr) {
         // Curr points to the entry required by the oldest timestamp. This entry
         // will become the last entry in the bundle.
         pred = curr;
         curr = curr->next_;
-        pred->next_ = tail_;
+        pred->next_ = nullptr;
       }
     }
 #ifdef BUNDLE_DEBUG
@@ -194,29 +227,56 @@ class LinkedBundle {
 #endif
 
     // Reclaim nodes.
-    assert(curr != head_ && pred->next_ == tail_);
-    while (curr != tail_) {
+    assert(curr != head_ && pred->next_ == nullptr);
+    int reclaimed = 0;
+    while (curr != nullptr) {
       pred = curr;
       curr = curr->next_;
       pred->mark(ts);
 #ifndef BUNDLE_CLEANUP_NO_FREE
-      delete pred;
+      recmgr->retire(tid, pred);
 #endif
+      ++reclaimed;
     }
-#ifdef BUNDLE_DEBUG
-    if (curr != tail_) {
-      std::cout << curr << std::endl;
-      std::cout << dump(ts) << std::flush;
-      exit(1);
+    return reclaimed;
+  }
+
+  // Retires every entry of the bundle. Called when the node owning the bundle
+  // is retired, at which point no update can prepare the bundle again. The
+  // entries are left linked so that range queries which are still traversing
+  // the node can follow them until the record manager recycles them.
+  template <typename RecordManager>
+  inline void retireEntries(const int tid, RecordManager *const recmgr) {
+#ifndef BUNDLE_CLEANUP_NO_FREE
+    BundleEntry<NodeType> *curr = head_;
+    BundleEntry<NodeType> *next;
+    while (curr != nullptr) {
+      next = curr->next_;
+      recmgr->retire(tid, curr);
+      curr = next;
     }
 #endif
   }
 
+  // Returns true if the bundle holds more than length entries. Visits at most
+  // length + 1 entries. Must be called while holding the lock of the node
+  // owning the bundle.
+  inline bool longerThan(int length) {
+    BundleEntry<NodeType> *curr = head_;
+    while (curr != nullptr) {
+      if (length-- == 0) {
+        return true;
+      }
+      curr = curr->next_;
+    }
+    return false;
+  }
+
   // [UNSAFE] Returns the number of bundle entries.
   int size() {
     int size = 0;
     BundleEntry<NodeType> *curr = head_;
-    while (curr != tail_) {
+    while (curr != nullptr) {
 #ifdef BUNDLE_DEBUG
       if (curr->marked()) {
         std::cout << dump(0) << std::flush;
@@ -225,18 +285,19 @@ class LinkedBundle {
 #endif
       ++size;
       curr = curr->next_;
-#ifdef BUNDLE_DEBUG
-      if (curr == nullptr) {
-        std::cout << dump(0) << std::flush;
-        exit(1);
-      }
-#endif
     }
     return size;
   }
 
+  // [UNSAFE] Returns the number of bytes of the bundle entries.
+  long long entryBytes() { return size() * sizeof(BundleEntry<NodeType>); }
+
   inline NodeType *first(timestamp_t &ts) {
     BundleEntry<NodeType> *entry = head_;
+    if (entry == nullptr) {
+      ts = BUNDLE_NULL_TIMESTAMP;
+      return nullptr;
+    }
     ts = entry->ts_;
     return entry->ptr_;
   }
@@ -245,7 +306,7 @@ class LinkedBundle {
     // Find the number of entries in the list.
     BundleEntry<NodeType> *curr_entry = head_;
     int size = 0;
-    while (curr_entry != tail_) {
+    while (curr_entry != nullptr) {
       ++size;
       curr_entry = curr_entry->next_;
     }
@@ -257,7 +318,7 @@ class LinkedBundle {
     NodeType *ptr;
     timestamp_t ts;
     curr_entry = head_;
-    while (curr_entry != tail_) {
+    while (curr_entry != nullptr) {
       ptr = curr_entry->ptr_;
       ts = curr_entry->ts_;
       retarr[pos++] = std::pair<NodeType *, timestamp_t>(ptr, ts);
@@ -267,23 +328,33 @@ class LinkedBundle {
     return retarr;
   }
 
+  // [UNSAFE] Checks that no entry is pending and that timestamps do not
+  // increase from the newest entry to the oldest.
+  bool validate() {
+    BundleEntry<NodeType> *curr = head_;
+    while (curr != nullptr) {
+      BundleEntry<NodeType> *next = curr->next_;
+      if (curr->ts_ == BUNDLE_PENDING_TIMESTAMP ||
+          curr->ts_ == BUNDLE_NULL_TIMESTAMP ||
+          (next != nullptr && next->ts_ > curr->ts_)) {
+        return false;
+      }
+      curr = next;
+    }
+    return true;
+  }
+
   string __attribute__((noinline)) dump(timestamp_t ts) {
     BundleEntry<NodeType> *curr = head_;
     std::stringstream ss;
     ss << "(ts=" << ts << ") : ";
     long i = 0;
-    while (curr != nullptr && curr != tail_) {
+    while (curr != nullptr) {
       ss << "<" << curr->ts_ << "," << curr->ptr_ << "," << curr->next_ << ">"
          << "-->";
       curr = curr->next_;
     }
-    if (curr == tail_) {
-      ss << "(tail)<" << curr->ts_ << "," << curr->ptr_ << ","
-         << reinterpret_cast<long>(curr->next_.load(std::memory_order_relaxed))
-         << ">";
-    } else {
-      ss << "(unexpected end)";
-    }
+    ss << "(end)";
 #ifdef BUNDLE_DEBUG
     ss << " [updates=" << updates << ", last_recycled=" << last_recycled
        << ", oldest_edge=" << oldest_edge << "]" << std::endl;
@@ -294,4 +365,4 @@ class LinkedBundle {
   }
 };
 
-#endif  // BUNDLE_LINKED_BUNDLE_H
\ No newline at end of file
+#endif  // BUNDLE_LINKED_BUNDLE_H
@@ -0,0 +1,185 @@
+// Jacob Nelson
+//
+// This file implements the announcements of active range queries, which
+// cleanup uses to determine the oldest timestamp any range query may still
+// read at. A scan of every announcement is linear in the number of threads, so
+// its result is cached and only one thread refreshes it at a time. Everyone
+// else uses the cached value, which is always safe since it can only be older
+// than the true oldest active range query (bundles are then trimmed less).
+//
+// The cache stays a lower bound without waiting on range queries that are
+// between reading the clock and announcing their timestamp. Before scanning, a
+// refresh publishes the clock value it is computing the minimum against (the
+// horizon). After announcing, a range query rereads the horizon and restarts
+// with a fresh timestamp if it was passed. Either the scan observes the
+// announcement or the range query observes the new horizon, so a range query
+// that is descheduled at any point never delays cleanup.
+//
+// A thread may also pin its announcement, e.g., for the duration of a
+// transaction. Every range query it starts until it unpins then reads at the
+// pinned timestamp, so they all observe the same snapshot.
+
+#ifndef BUNDLE_RQ_ANNOUNCEMENTS_H
+#define BUNDLE_RQ_ANNOUNCEMENTS_H
+
+#include <atomic>
+#include <cassert>
+
+#include "common_bundle.h"
+#include "plaf.h"
+#include "timestamp_provider.h"
+
+#ifndef likely
+#define likely(x) __builtin_expect((x), 1)
+#endif
+#ifndef unlikely
+#define unlikely(x) __builtin_expect((x), 0)
+#endif
+
+// Number of calls to oldest() a thread makes before it refreshes its snapshot
+// of the oldest active range query.
+#ifndef BUNDLE_RQ_REFRESH_PERIOD
+#define BUNDLE_RQ_REFRESH_PERIOD 64
+#endif
+
+class RQAnnouncements {
+ private:
+  union announcement {
+    std::atomic<timestamp_t> ts;  // BUNDLE_NULL_TIMESTAMP if inactive.
+    volatile char bytes[PREFETCH_SIZE_BYTES];
+  };
+
+  // Only accessed by its owner.
+  union snapshot {
+    struct {
+      long calls;  // Left before the next refresh.
+      timestamp_t oldest;
+      bool pinned;
+    } data;
+    volatile char bytes[PREFETCH_SIZE_BYTES];
+  };
+
+  TimestampProvider *const timestamps_;
+  const int num_processes_;
+  announcement *announcements_;
+  snapshot *snapshots_;
+
+  volatile char pad0[PREFETCH_SIZE_BYTES];
+  std::atomic<bool> refreshing_;
+  volatile char pad1[PREFETCH_SIZE_BYTES];
+  std::atomic<timestamp_t> horizon_;  // Only grows.
+  volatile char pad2[PREFETCH_SIZE_BYTES];
+  std::atomic<timestamp_t> oldest_;  // Cached oldest active range query.
+  volatile char pad3[PREFETCH_SIZE_BYTES];
+
+ public:
+  RQAnnouncements(TimestampProvider *const timestamps, const int num_processes)
+      : timestamps_(timestamps), num_processes_(num_processes) {
+    announcements_ = new announcement[num_processes];
+    snapshots_ = new snapshot[num_processes];
+    for (int i = 0; i < num_processes; ++i) {
+      announcements_[i].ts = BUNDLE_NULL_TIMESTAMP;
+      snapshots_[i].data.calls = 0;
+      snapshots_[i].data.oldest = BUNDLE_MIN_TIMESTAMP;
+      snapshots_[i].data.pinned = false;
+    }
+    refreshing_ = false;
+    horizon_ = BUNDLE_MIN_TIMESTAMP;
+    oldest_ = BUNDLE_MIN_TIMESTAMP;
+  }
+
+  ~RQAnnouncements() {
+    delete[] announcements_;
+    delete[] snapshots_;
+  }
+
+  // Obtains and announces the timestamp of a range query.
+  inline timestamp_t announce(const int tid) {
+    if (unlikely(snapshots_[tid].data.pinned)) {
+      return announcements_[tid].ts;
+    }
+    while (true) {
+      const timestamp_t ts = timestamps_->range_query(tid);
+      announcements_[tid].ts = ts;
+      if (likely(horizon_ <= ts)) {
+        return ts;
+      }
+      // A refresh may have missed the announcement, so try again with a
+      // timestamp it could not have skipped.
+    }
+  }
+
+  inline void retract(const int tid) {
+    if (unlikely(snapshots_[tid].data.pinned)) {
+      return;  // Retracted by unpin().
+    }
+    announcements_[tid].ts.store(BUNDLE_NULL_TIMESTAMP,
+                                 std::memory_order_release);
+  }
+
+  // Announces a timestamp that the calling thread's range queries read at
+  // until it calls unpin(). Pins do not nest.
+  inline timestamp_t pin(const int tid) {
+    assert(!snapshots_[tid].data.pinned);
+    const timestamp_t ts = announce(tid);
+    snapshots_[tid].data.pinned = true;
+    return ts;
+  }
+
+  inline void unpin(const int tid) {
+    assert(snapshots_[tid].data.pinned);
+    snapshots_[tid].data.pinned = false;
+    retract(tid);
+  }
+
+  // Returns the calling thread's snapshot of the oldest active range query,
+  // refreshing it every BUNDLE_RQ_REFRESH_PERIOD calls. Like the shared
+  // cache, an old snapshot remains a lower bound.
+  inline timestamp_t oldest(const int tid) {
+    snapshot &local = snapshots_[tid];
+    if (unlikely(--local.data.calls <= 0)) {
+      local.data.calls = BUNDLE_RQ_REFRESH_PERIOD;
+      local.data.oldest = refresh();
+    }
+    return local.data.oldest;
+  }
+
+  // Recomputes the oldest active range query, unless another thread is
+  // already doing so, in which case the cached value is returned.
+  timestamp_t refresh() {
+    if (refreshing_ || refreshing_.exchange(true)) {
+      return oldest_;
+    }
+    timestamp_t oldest = timestamps_->current();
+    if (oldest > horizon_) {
+      horizon_ = oldest;
+    } else {
+      oldest = horizon_;
+    }
+    for (int i = 0; i < num_processes_; ++i) {
+      const timestamp_t ts = announcements_[i].ts;
+      if (ts != BUNDLE_NULL_TIMESTAMP && ts < oldest) {
+        oldest = ts;
+      }
+    }
+    oldest_ = oldest;
+    refreshing_.store(false, std::memory_order_release);
+    return oldest;
+  }
+};
+
+// With BUNDLE_SHARED_TIMESTAMPS, every range query provider uses the following
+// clock and announcements instead of its own, so range queries over different
+// data structures can read at the same snapshot.
+inline TimestampProvider &shared_bundle_timestamps() {
+  static TimestampProvider timestamps(default_timestamp_policy());
+  return timestamps;
+}
+
+inline RQAnnouncements &shared_bundle_announcements() {
+  static RQAnnouncements announcements(&shared_bundle_timestamps(),
+                                       MAX_TID_POW2);
+  return announcements;
+}
+
+#endif  // BUNDLE_RQ_ANNOUNCEMENTS_H
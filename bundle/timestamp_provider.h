@@ -0,0 +1,326 @@
+// Jacob Nelson
+//
+// This file implements the sources of timestamps used by the bundle range query
+// provider. Updates label bundle entries with the timestamp returned by
+// update() and range queries read at the timestamp returned by range_query().
+// Each policy guarantees the two properties the bundles rely on:
+//
+//   1. If a range query obtains a timestamp at least as large as an update's,
+//      then it obtained it after the update prepared its bundles, so it is
+//      guaranteed to find the pending entries and wait for them.
+//   2. If a range query obtains a timestamp smaller than an update's, then it
+//      obtained it before the update's linearizing write, which update() is
+//      always ordered before.
+//
+// The policy is chosen when the provider is constructed, so benchmarks can
+// select it at runtime (see default_timestamp_policy()).
+
+#ifndef BUNDLE_TIMESTAMP_PROVIDER_H
+#define BUNDLE_TIMESTAMP_PROVIDER_H
+
+#include <cpuid.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+
+#include "common_bundle.h"
+#include "plaf.h"
+
+#ifndef CPU_RELAX
+#define CPU_RELAX asm volatile("pause\n" ::: "memory")
+#endif
+
+// Maximum number of NUMA nodes with their own batching slot. Threads on nodes
+// beyond this share slots.
+#ifndef BUNDLE_TS_MAX_NUMA_NODES
+#define BUNDLE_TS_MAX_NUMA_NODES 8
+#endif
+
+// Number of clock exchanges per pair of CPUs when calibrating the TSC
+// uncertainty window.
+#ifndef BUNDLE_TSC_CALIBRATION_ROUNDS
+#define BUNDLE_TSC_CALIBRATION_ROUNDS 100
+#endif
+
+// Compile-time default policy, overridden at runtime by the benchmarks.
+#ifndef BUNDLE_TIMESTAMP_POLICY
+#define BUNDLE_TIMESTAMP_POLICY "global"
+#endif
+
+enum timestamp_policy_t {
+  // Updates increment a single global counter. Range queries read it.
+  BUNDLE_TS_GLOBAL,
+  // Updates try to CAS the global counter forward once. An update whose CAS
+  // fails adopts the value installed by the update that beat it, which was
+  // also produced after this update prepared its bundles.
+  BUNDLE_TS_CAS,
+  // Range queries increment the global counter and updates only read it, which
+  // favors update-heavy workloads.
+  BUNDLE_TS_RQ,
+  // Updates running on the same NUMA node combine their increments of the
+  // global counter. A batch leader increments it once on behalf of every
+  // update that arrived on its node before the batch started.
+  BUNDLE_TS_NUMA,
+  // Updates and range queries read the invariant TSC. Clocks of different
+  // cores are only synchronized up to an uncertainty window, so updates pad
+  // their timestamp with it and then wait it out before linearizing.
+  BUNDLE_TS_TSC,
+  BUNDLE_TS_INVALID
+};
+
+inline const char *timestamp_policy_name(const timestamp_policy_t policy) {
+  switch (policy) {
+    case BUNDLE_TS_GLOBAL:
+      return "global";
+    case BUNDLE_TS_CAS:
+      return "cas";
+    case BUNDLE_TS_RQ:
+      return "rq";
+    case BUNDLE_TS_NUMA:
+      return "numa";
+    case BUNDLE_TS_TSC:
+      return "tsc";
+    default:
+      return "invalid";
+  }
+}
+
+inline timestamp_policy_t timestamp_policy_from_name(const char *name) {
+  for (int i = 0; i < BUNDLE_TS_INVALID; ++i) {
+    if (strcmp(name, timestamp_policy_name((timestamp_policy_t)i)) == 0) {
+      return (timestamp_policy_t)i;
+    }
+  }
+  return BUNDLE_TS_INVALID;
+}
+
+// Policy used by every provider constructed afterwards.
+inline timestamp_policy_t &default_timestamp_policy() {
+  static timestamp_policy_t policy =
+      timestamp_policy_from_name(BUNDLE_TIMESTAMP_POLICY);
+  return policy;
+}
+
+// Returns the NUMA node of the CPU the calling thread is running on.
+inline int current_numa_node() {
+  unsigned cpu, node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+    return 0;
+  }
+  return (int)node;
+}
+
+inline bool tsc_is_invariant() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  return (edx & (1 << 8)) != 0;
+}
+
+inline timestamp_t read_invariant_tsc() {
+  unsigned int aux;
+  return (timestamp_t)__rdtscp(&aux);
+}
+
+// Measures how far apart the TSCs of two CPUs can appear to be. A thread on
+// one CPU publishes its clock and a thread on the other reads its own clock as
+// soon as it sees it. The smallest difference observed over many rounds bounds
+// the skew between the two clocks from above (plus the one-way latency).
+struct tsc_calibration_args {
+  int cpu;
+  bool writer;
+  std::atomic<timestamp_t> *mailbox;
+  std::atomic<int> *round;
+  timestamp_t min_offset;
+};
+
+inline void *tsc_calibration_run(void *arg) {
+  tsc_calibration_args *args = (tsc_calibration_args *)arg;
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(args->cpu, &cpuset);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+  args->min_offset = BUNDLE_MAX_TIMESTAMP;
+  for (int i = 0; i < BUNDLE_TSC_CALIBRATION_ROUNDS; ++i) {
+    if (args->writer) {
+      while (args->round->load() != 2 * i) CPU_RELAX;
+      args->mailbox->store(read_invariant_tsc());
+      args->round->store(2 * i + 1);
+    } else {
+      while (args->round->load() != 2 * i + 1) CPU_RELAX;
+      timestamp_t offset = read_invariant_tsc() - args->mailbox->load();
+      if (offset < args->min_offset) args->min_offset = offset;
+      args->round->store(2 * i + 2);
+    }
+  }
+  return nullptr;
+}
+
+inline timestamp_t tsc_measure_offset(const int from, const int to) {
+  std::atomic<timestamp_t> mailbox(0);
+  std::atomic<int> round(0);
+  tsc_calibration_args args[2] = {{from, true, &mailbox, &round, 0},
+                                  {to, false, &mailbox, &round, 0}};
+  pthread_t threads[2];
+  for (int i = 0; i < 2; ++i) {
+    if (pthread_create(&threads[i], nullptr, tsc_calibration_run, &args[i])) {
+      std::cerr << "ERROR: could not create thread" << std::endl;
+      exit(-1);
+    }
+  }
+  for (int i = 0; i < 2; ++i) {
+    pthread_join(threads[i], nullptr);
+  }
+  return args[1].min_offset;
+}
+
+// Returns the uncertainty window of the TSC, in cycles, measured between the
+// first CPU and every other one in both directions. Calibrated once.
+inline timestamp_t tsc_uncertainty() {
+  static timestamp_t uncertainty = [] {
+    timestamp_t max_offset = 0;
+    const int num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int cpu = 1; cpu < num_cpus; ++cpu) {
+      max_offset = std::max(max_offset, tsc_measure_offset(0, cpu));
+      max_offset = std::max(max_offset, tsc_measure_offset(cpu, 0));
+    }
+    return max_offset;
+  }();
+  return uncertainty;
+}
+
+class TimestampProvider {
+ private:
+  struct numa_slot {
+    std::atomic<long> started;        // Number of batches started.
+    std::atomic<long> finished;       // Number of batches finished.
+    std::atomic<timestamp_t> latest;  // Timestamp of the last finished batch.
+    volatile char pad[PREFETCH_SIZE_BYTES];
+  };
+
+  const timestamp_policy_t policy_;
+  volatile char pad0[PREFETCH_SIZE_BYTES];
+  std::atomic<timestamp_t> curr_timestamp_;
+  volatile char pad1[PREFETCH_SIZE_BYTES];
+  numa_slot numa_slots_[BUNDLE_TS_MAX_NUMA_NODES];
+  int numa_node_[MAX_TID_POW2];
+  timestamp_t tsc_uncertainty_;
+
+  // Returns the timestamp of a batch of the caller's node that started after
+  // the caller arrived, leading one if no other update does.
+  inline timestamp_t numa_update(const int tid) {
+    if (numa_node_[tid] < 0) {
+      numa_node_[tid] = current_numa_node() % BUNDLE_TS_MAX_NUMA_NODES;
+    }
+    numa_slot &slot = numa_slots_[numa_node_[tid]];
+    const long arrival = slot.started;
+    while (true) {
+      long started = slot.started;
+      if (slot.finished > arrival) {
+        // Timestamps only grow, so a later batch works as well.
+        return slot.latest;
+      }
+      if (started == slot.finished &&
+          slot.started.compare_exchange_strong(started, started + 1)) {
+        timestamp_t ts = curr_timestamp_.fetch_add(1) + 1;
+        slot.latest = ts;
+        slot.finished = started + 1;
+        return ts;
+      }
+      CPU_RELAX;
+    }
+  }
+
+  inline timestamp_t tsc_update() {
+    // Prepared bundle entries must be visible before the clock is read.
+    __sync_synchronize();
+    const timestamp_t ts = read_invariant_tsc() + tsc_uncertainty_;
+    // No clock may still read below ts once the update linearizes.
+    while (read_invariant_tsc() < ts + tsc_uncertainty_) {
+      CPU_RELAX;
+    }
+    return ts;
+  }
+
+ public:
+  TimestampProvider(timestamp_policy_t policy) : policy_(policy) {
+    if (policy_ == BUNDLE_TS_INVALID) {
+      std::cerr << "ERROR: invalid timestamp policy" << std::endl;
+      exit(-1);
+    }
+    if (policy_ == BUNDLE_TS_TSC && !tsc_is_invariant()) {
+      std::cerr << "ERROR: the TSC is not invariant on this machine"
+                << std::endl;
+      exit(-1);
+    }
+    curr_timestamp_ = BUNDLE_MIN_TIMESTAMP;
+    for (int i = 0; i < BUNDLE_TS_MAX_NUMA_NODES; ++i) {
+      numa_slots_[i].started = 0;
+      numa_slots_[i].finished = 0;
+      numa_slots_[i].latest = BUNDLE_MIN_TIMESTAMP;
+    }
+    for (int i = 0; i < MAX_TID_POW2; ++i) {
+      numa_node_[i] = -1;
+    }
+    tsc_uncertainty_ = (policy_ == BUNDLE_TS_TSC ? tsc_uncertainty() : 0);
+  }
+
+  timestamp_policy_t policy() { return policy_; }
+  timestamp_t uncertainty() { return tsc_uncertainty_; }
+
+  // Returns the linearization timestamp of an update whose bundles are
+  // prepared. The update must perform its linearizing write afterwards.
+  inline timestamp_t update(const int tid) {
+    switch (policy_) {
+      case BUNDLE_TS_CAS: {
+        timestamp_t ts = curr_timestamp_;
+        if (curr_timestamp_.compare_exchange_strong(ts, ts + 1)) {
+          return ts + 1;
+        }
+        return ts;  // Installed by the update that won.
+      }
+      case BUNDLE_TS_RQ:
+        return curr_timestamp_;
+      case BUNDLE_TS_NUMA:
+        return numa_update(tid);
+      case BUNDLE_TS_TSC:
+        return tsc_update();
+      default:
+        return curr_timestamp_.fetch_add(1) + 1;
+    }
+  }
+
+  // Returns the timestamp a range query reads at.
+  inline timestamp_t range_query(const int tid) {
+    switch (policy_) {
+      case BUNDLE_TS_RQ:
+        return curr_timestamp_.fetch_add(1);
+      case BUNDLE_TS_TSC: {
+        timestamp_t ts = read_invariant_tsc();
+        _mm_lfence();  // Bundles must be read after the clock.
+        return ts;
+      }
+      default:
+        return curr_timestamp_;
+    }
+  }
+
+  // Returns a lower bound on the timestamp of any range query that has not
+  // announced itself yet.
+  inline timestamp_t current() {
+    if (policy_ == BUNDLE_TS_TSC) {
+      return read_invariant_tsc() - tsc_uncertainty_;
+    }
+    return curr_timestamp_;
+  }
+};
+
+#endif  // BUNDLE_TIMESTAMP_PROVIDER_H
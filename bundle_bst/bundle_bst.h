@@ -20,6 +20,7 @@
 #include <iostream>
 #include <set>
 #include <sstream>
+#include <stack>
 #include <stdexcept>
 #include <string>
 
@@ -34,6 +35,12 @@
 #endif
 #include "rq_provider.h"
 
+// Updates prepare bundles without locking nodes (see scx()), so a bundle
+// must tolerate concurrent prepares.
+#if !defined BUNDLE_LINKED_BUNDLE || !defined BUNDLE_LOCKFREE
+#error "bundle_bst needs BUNDLE_LINKED_BUNDLE and BUNDLE_LOCKFREE"
+#endif
+
 using namespace std;
 
 namespace bundle_bst_ns {
@@ -155,6 +162,16 @@ class bundle_bst {
   const V doInsert(const int tid, const K &key, const V &val,
                    bool onlyIfAbsent);
 
+  // Links the children of an internal node built by a bulk load.
+  inline void bulkLoadLink(const int tid, Node<K, V> *node, Node<K, V> *left,
+                           Node<K, V> *right);
+  // Builds a balanced subtree whose leaves hold the n > 0 sorted keys.
+  Node<K, V> *bulkLoadSubtree(const int tid, const K *keys, const V *values,
+                              const int n);
+  // Joins subtrees[a..b) into a balanced tree, routing by their smallest keys.
+  Node<K, V> *bulkLoadJoin(const int tid, Node<K, V> **subtrees,
+                           const K *minKeys, const int a, const int b);
+
   int init[MAX_TID_POW2] = {
       0,
   };
@@ -242,9 +259,9 @@ class bundle_bst {
 
     BUNDLE_TYPE_DECL<Node<K, V>> *bundles[] = {&(_root->left_bundle), nullptr};
     Node<K, V> *ptrs[] = {rootleft, nullptr};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
     timestamp_t ts = rqProvider->linearize_update_at_write(tid, &root, _root);
-    rqProvider->finalize_bundles(bundles, tid);
+    rqProvider->finalize_bundles(bundles, ts);
   }
 
   Node<K, V> *debug_getEntryPoint() { return root; }
@@ -275,6 +292,7 @@ class bundle_bst {
       dfsDeallocateBottomUp(u->right, numNodes);
     }
     MEMORY_STATS++(*numNodes);
+    retireBundles(0 /* tid */, u);
     recmgr->deallocate(0 /* tid */, u);
   }
   ~bundle_bst() {
@@ -290,6 +308,7 @@ class bundle_bst {
     VERBOSE DEBUG COUTATOMIC(" deallocated nodes " << numNodes << endl);
     for (int tid = 0; tid < recmgr->NUM_PROCESSES; ++tid) {
       for (int i = 0; i < MAX_NODES; ++i) {
+        retireBundles(tid, GET_ALLOCATED_NODE_PTR(tid, i));
         recmgr->deallocate(tid, GET_ALLOCATED_NODE_PTR(tid, i));
       }
     }
@@ -309,10 +328,32 @@ class bundle_bst {
   const pair<V, bool> find(const int tid, const K &key);
   int rangeQuery(const int tid, const K &lo, const K &hi, K *const resultKeys,
                  V *const resultValues);
+  // Calls visit(key, value) on each key in [lo, hi], in increasing order and
+  // as of the same snapshot a range query would return, without collecting
+  // them in an array. Stops early once visit returns false or limit keys have
+  // been visited (a negative limit visits every key). The range query stays
+  // announced until it returns, so visit should be short and must not call
+  // back into the data structure. Returns the number of keys visited.
+  template <typename Visitor>
+  int visitRange(const int tid, const K &lo, const K &hi, Visitor visit,
+                 const int limit = -1);
   bool contains(const int tid, const K &key);
   int size(void); /** warning: size is a LINEAR time operation, and does not
                      return consistent results with concurrency **/
 
+  // Bulk loading of an empty tree that no other thread is using yet. Several
+  // threads may each build a part from a batch of sorted, distinct keys, then
+  // one thread joins the parts, given in increasing order of their keys, into
+  // a balanced tree. Every bundle of an internal node holds a single entry, as
+  // if each leaf had been inserted before the first range query.
+  struct BulkLoadPart {
+    Node<K, V> *subtree;
+    K minKey;
+  };
+  BulkLoadPart bulkLoadPart(const int tid, const K *keys, const V *values,
+                            const int n);
+  void bulkLoadFinish(const int tid, BulkLoadPart *parts, const int numParts);
+
   /**
    * BEGIN FUNCTIONS FOR RANGE QUERY SUPPORT
    */
@@ -342,6 +383,12 @@ class bundle_bst {
     return (key != NO_KEY && !cmp(key, lo) && !cmp(hi, key));
   }
 
+  // Retires the bundle entries of a node that is being retired.
+  inline void retireBundles(const int tid, Node<K, V> *node) {
+    node->left_bundle.retireEntries(tid, recmgr);
+    node->right_bundle.retireEntries(tid, recmgr);
+  }
+
   /**
    * END FUNCTIONS FOR RANGE QUERY SUPPORT
    */
@@ -418,6 +465,35 @@ class bundle_bst {
   bool validate(const long long keysum, const bool checkkeysum);
   long long debugKeySum() { return debugKeySum((root->left)->left); }
 
+  // Sum and number of the bundle lengths sampled by updates so far.
+  void getBundleLengthSamples(long long &sum, long long &count) {
+    rqProvider->get_bundle_length_samples(sum, count);
+  }
+
+  // Histogram of the bundle lengths sampled by updates so far.
+  void getBundleLengthHistogram(BundleLengthHistogram &histogram) {
+    rqProvider->get_bundle_length_histogram(histogram);
+  }
+
+  // [UNSAFE] Memory used by the tree, including its sentinels. Must not run
+  // concurrently with updates (see bundle_footprint.h).
+  void getFootprint(BundleFootprint &footprint) {
+    stack<Node<K, V> *> s;
+    s.push(root);
+    while (!s.empty()) {
+      Node<K, V> *curr = s.top();
+      s.pop();
+      footprint.addNode(sizeof(Node<K, V>));
+      footprint.addBundle(&curr->left_bundle);
+      footprint.addBundle(&curr->right_bundle);
+      Node<K, V> *left = curr->left;
+      Node<K, V> *right = curr->right;
+      if (left != NULL) s.push(left);
+      if (right != NULL) s.push(right);
+    }
+    footprint.addRecords<Node<K, V>, BundleEntry<Node<K, V>>>(recmgr);
+  }
+
   string getBundleStatsString() {
     return "getBundleStatsString not implemented";
   }
@@ -157,6 +157,167 @@ int bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::rangeQuery(
   }
 }
 
+template <class K, class V, class Compare, class RecManager>
+template <typename Visitor>
+int bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::visitRange(
+    const int tid, const K &lo, const K &hi, Visitor visit, const int limit) {
+  block<Node<K, V>> stack(NULL);
+  recmgr->leaveQuiescentState(tid, true);
+  timestamp_t ts = rqProvider->start_traversal(tid);
+
+  // Phase 1. Pre-range traversal
+  Node<K, V> *prev = root;
+  Node<K, V> *curr = root->left;
+  bool is_left_child = false;
+  while (curr != nullptr) {
+    if (curr->key != this->NO_KEY && !cmp(curr->key, lo) &&
+        !cmp(hi, curr->key)) {
+      // Phase 2. Enter range
+      if (is_left_child) {
+        curr = prev->left_bundle.getPtrByTimestamp(ts);
+      } else {
+        curr = prev->right_bundle.getPtrByTimestamp(ts);
+      }
+      break;
+    } else if (curr->key != this->NO_KEY && !cmp(hi, curr->key)) {
+      // curr is larger than hi, go left
+      prev = curr;
+      curr = rqProvider->read_addr(tid, &curr->right);
+      is_left_child = false;
+    } else if (curr->key == this->NO_KEY || cmp(lo, curr->key)) {
+      // curr is lower than lo, go right
+      prev = curr;
+      curr = rqProvider->read_addr(tid, &curr->left);
+      is_left_child = true;
+    } else {
+      assert(false);
+    }
+  }
+
+  // Phase 3. Range visit. Right children are pushed before left ones, so
+  // leaves are visited in increasing key order and the stack never grows
+  // beyond the height of the tree.
+  int cnt = 0;
+  if (curr != nullptr) {
+    stack.push(curr);
+  }
+  while (!stack.isEmpty() && cnt != limit) {
+    Node<K, V> *node = stack.pop();
+    assert(node);
+
+    Node<K, V> *left = node->left_bundle.getPtrByTimestamp(ts);
+    // if internal node, explore its children
+    if (left != NULL) {
+      if (node->key != this->NO_KEY && !cmp(hi, node->key)) {
+        Node<K, V> *right = node->right_bundle.getPtrByTimestamp(ts);
+        assert(right);
+        stack.push(right);
+      }
+      if (node->key == this->NO_KEY || cmp(lo, node->key)) {
+        stack.push(left);
+      }
+    } else if (isInRange(node->key, lo, hi)) {
+      ++cnt;
+      if (!visit(node->key, node->value)) {
+        break;
+      }
+    }
+  }
+  while (!stack.isEmpty()) {
+    stack.pop();
+  }
+  rqProvider->end_traversal(tid);
+  recmgr->enterQuiescentState(tid);
+  return cnt;
+}
+
+template <class K, class V, class Compare, class RecManager>
+inline void bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::bulkLoadLink(
+    const int tid, Node<K, V> *node, Node<K, V> *left, Node<K, V> *right) {
+  rqProvider->write_addr(tid, &node->left, left);
+  rqProvider->write_addr(tid, &node->right, right);
+  rqProvider->init_bundle(tid, &node->left_bundle, left);
+  rqProvider->init_bundle(tid, &node->right_bundle, right);
+}
+
+template <class K, class V, class Compare, class RecManager>
+bundle_bst_ns::Node<K, V>
+    *bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::bulkLoadSubtree(
+        const int tid, const K *keys, const V *values, const int n) {
+  if (n == 1) {
+    return initializeNode(tid, allocateNode(tid), keys[0], values[0], NULL,
+                          NULL);
+  }
+  // Keys smaller than the router go left, as in a search.
+  const int mid = n / 2;
+  Node<K, V> *node = initializeNode(tid, allocateNode(tid), keys[mid],
+                                    values[mid], NULL, NULL);
+  bulkLoadLink(tid, node, bulkLoadSubtree(tid, keys, values, mid),
+               bulkLoadSubtree(tid, keys + mid, values + mid, n - mid));
+  return node;
+}
+
+template <class K, class V, class Compare, class RecManager>
+bundle_bst_ns::Node<K, V>
+    *bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::bulkLoadJoin(
+        const int tid, Node<K, V> **subtrees, const K *minKeys, const int a,
+        const int b) {
+  if (b - a == 1) return subtrees[a];
+  const int mid = (a + b) / 2;
+  Node<K, V> *node = initializeNode(tid, allocateNode(tid), minKeys[mid],
+                                    NO_VALUE, NULL, NULL);
+  bulkLoadLink(tid, node, bulkLoadJoin(tid, subtrees, minKeys, a, mid),
+               bulkLoadJoin(tid, subtrees, minKeys, mid, b));
+  return node;
+}
+
+template <class K, class V, class Compare, class RecManager>
+typename bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::BulkLoadPart
+bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::bulkLoadPart(
+    const int tid, const K *keys, const V *values, const int n) {
+  BulkLoadPart part;
+  part.subtree = NULL;
+  if (n > 0) {
+    part.subtree = bulkLoadSubtree(tid, keys, values, n);
+    part.minKey = keys[0];
+  }
+  return part;
+}
+
+template <class K, class V, class Compare, class RecManager>
+void bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::bulkLoadFinish(
+    const int tid, BulkLoadPart *parts, const int numParts) {
+  Node<K, V> *rootleft = root->left;
+  assert(rootleft->left == NULL);
+  Node<K, V> **subtrees = new Node<K, V> *[numParts];
+  K *minKeys = new K[numParts];
+  int m = 0;
+  for (int i = 0; i < numParts; ++i) {
+    if (parts[i].subtree == NULL) continue;
+    subtrees[m] = parts[i].subtree;
+    minKeys[m] = parts[i].minKey;
+    ++m;
+  }
+  if (m > 0) {
+    // As after the first insert, the loaded keys sit left of a router with
+    // key infinity whose right child is the sentinel leaf.
+    Node<K, V> *router = initializeNode(tid, allocateNode(tid), NO_KEY,
+                                        NO_VALUE, NULL, NULL);
+    bulkLoadLink(tid, router, bulkLoadJoin(tid, subtrees, minKeys, 0, m),
+                 rootleft);
+
+    // Link the loaded nodes in as a single insertion below the root.
+    BUNDLE_TYPE_DECL<Node<K, V>> *bundles[] = {&root->left_bundle, nullptr};
+    Node<K, V> *ptrs[] = {router, nullptr};
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
+    timestamp_t ts =
+        rqProvider->linearize_update_at_write(tid, &root->left, router);
+    rqProvider->finalize_bundles(bundles, ts);
+  }
+  delete[] subtrees;
+  delete[] minKeys;
+}
+
 template <class K, class V, class Compare, class RecManager>
 const pair<V, bool> bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::find(
     const int tid, const K &key) {
@@ -367,7 +528,7 @@ inline bool bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::
         (l->key == NO_KEY || cmp(key, l->key)) ? l
                                                : GET_ALLOCATED_NODE_PTR(tid, 0),
         GET_ALLOCATED_NODE_PTR(tid, 1), nullptr};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
     timestamp_t ts = rqProvider->get_update_lin_time(tid);
 
     bool retval =
@@ -472,7 +633,7 @@ inline bool bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::
         &GET_ALLOCATED_NODE_PTR(tid, 0)->right_bundle,
         p == gpleft ? &gp->left_bundle : &gp->right_bundle, nullptr};
     Node<K, V> *ptrs[] = {sleft, sright, GET_ALLOCATED_NODE_PTR(tid, 0), NULL};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
     timestamp_t ts = rqProvider->get_update_lin_time(tid);
 
     Node<K, V> *insertedNodes[] = {GET_ALLOCATED_NODE_PTR(tid, 0), NULL};
@@ -502,6 +663,9 @@ bundle_bst_ns::Node<K, V>
   newnode->scxRecord.store((uintptr_t)DUMMY_SCXRECORD, memory_order_relaxed);
   newnode->marked.store(false, memory_order_relaxed);
 
+  // A preallocated node is reused after a failed SCX, so release whatever its
+  // bundles were prepared with before resetting them.
+  retireBundles(tid, newnode);
   newnode->left_bundle.init();
   newnode->right_bundle.init();
   return newnode;
@@ -13,7 +13,6 @@
 #include <iostream>
 #include <set>
 
-#include "linked_bundle.h"
 #include "rq_provider.h"
 #include "scxrecord.h"
 #ifdef USE_RECLAIMER_RCU
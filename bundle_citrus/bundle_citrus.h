@@ -28,6 +28,7 @@
 #include <signal.h>
 #include <stdbool.h>
 
+#include <algorithm>
 #include <sstream>
 #include <stack>
 #include <unordered_set>
@@ -99,6 +100,16 @@ class bundle_citrustree {
 #endif
 
   inline nodeptr newNode(const int tid, K key, V value);
+  // Links the children of a node built by a bulk load.
+  inline void bulkLoadLink(const int tid, nodeptr node, nodeptr left,
+                           nodeptr right);
+  // Builds a balanced subtree of nodes for the n sorted keys.
+  nodeptr bulkLoadSubtree(const int tid, const K* keys, const V* values,
+                          const int n);
+  // Joins subtrees[a..b] into a balanced tree using pivots[a+1..b], where
+  // pivots[i] separates subtrees[i-1] from subtrees[i].
+  nodeptr bulkLoadJoin(const int tid, nodeptr* pivots, nodeptr* subtrees,
+                       const int a, const int b);
   long long debugKeySum(nodeptr root);
 
   bool validate(const int tid, nodeptr prev, int tag, nodeptr curr,
@@ -109,12 +120,32 @@ class bundle_citrustree {
     if (u->child[0]) dfsDeallocateBottomUp(u->child[0], numNodes);
     if (u->child[1]) dfsDeallocateBottomUp(u->child[1], numNodes);
     MEMORY_STATS++(*numNodes);
+    retireBundles(0 /* tid */, u);
     // recordmgr->deallocate(0 /* tid */, u);
     delete u;
   }
 
   const V doInsert(const int tid, const K& key, const V& value,
                    bool onlyIfAbsent);
+
+  // Node locks may be held by a deferred unlink (see unlinkSuccessor()), so a
+  // thread waiting for one helps run deferred callbacks.
+  static inline void lockNode(volatile int* lock);
+
+#ifndef BUNDLE_CITRUS_SYNCHRONIZE
+  // A delete of a node with two children replaces it with a copy of its
+  // successor, but may only unlink the old successor once no reader can still
+  // be on its way to it. Rather than waiting in synchronize(), the delete
+  // returns and the unlink runs after a grace period, holding the locks it
+  // needs until then. Define BUNDLE_CITRUS_SYNCHRONIZE to wait instead.
+  struct deferred_unlink {
+    bundle_citrustree<K, V, RecManager>* tree;
+    nodeptr nnode;     // Copy of the successor.
+    nodeptr prevSucc;  // Parent of the successor, or nnode.
+    nodeptr succ;
+  };
+  static void unlinkSuccessor(const int tid, void* arg);
+#endif
   int init[MAX_TID_POW2] = {
       0,
   };
@@ -131,7 +162,56 @@ class bundle_citrustree {
   const pair<V, bool> find(const int tid, const K& key);
   int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
                  V* const resultValues);
-  void cleanup(int tid);
+  // Calls visit(key, value) on each key in [lo, hi], in increasing order and
+  // as of the same snapshot a range query would return, without collecting
+  // them in an array. Stops early once visit returns false or limit keys have
+  // been visited (a negative limit visits every key). The range query stays
+  // announced until it returns, so visit should be short and must not call
+  // back into the data structure. Returns the number of keys visited.
+  template <typename Visitor>
+  int visitRange(const int tid, const K& lo, const K& hi, Visitor visit,
+                 const int limit = -1);
+  // Answers the n ranges [los[i], his[i]] at a single snapshot, calling
+  // visit(i, key, value) on the keys of range i like visitRange does. Ranges
+  // are answered in increasing order of their lower bounds, each one resuming
+  // from where the previous one started instead of from the root. Returning
+  // false from visit skips the rest of range i. Returns the number of keys
+  // visited.
+  template <typename Visitor>
+  int visitRanges(const int tid, const int n, const K* const los,
+                  const K* const his, Visitor visit);
+  // Like rangeQuery, for the n ranges [los[i], his[i]] at a single snapshot
+  // (see visitRanges). The keys of range i are saved in resultKeys[starts[i]]
+  // to resultKeys[starts[i] + counts[i] - 1], and likewise for values. Returns
+  // the total number of keys.
+  int multiRangeQuery(const int tid, const int n, const K* const los,
+                      const K* const his, K* const resultKeys,
+                      V* const resultValues, int* const starts,
+                      int* const counts);
+  // Cleans the bundles of up to budget nodes with keys in [cursor, last].
+  // Returns true if it reached last, otherwise sets cursor to the key of the
+  // first node it did not clean (see bundle_cleaner.h).
+  // Each call searches for cursor, so batches can stay short.
+  static const bool CLEANUP_SEEKS_FROM_HEAD = false;
+  bool cleanup(int tid, K& cursor, const K& last, int budget);
+  // Returns the smallest and largest keys, or false if there are none.
+  bool getKeyBounds(int tid, K& lo, K& hi);
+
+  // Bulk loading of an empty tree that no other thread is using yet. Several
+  // threads may each build a part from a batch of sorted, distinct keys, then
+  // one thread joins the parts, given in increasing order of their keys, into
+  // a balanced tree. A part is a balanced subtree of all but its smallest key,
+  // whose node is kept aside to join it with the other parts. Every bundle
+  // holds a single entry, as if each node had been inserted before the first
+  // range query.
+  struct BulkLoadPart {
+    nodeptr pivot;
+    nodeptr subtree;
+  };
+  BulkLoadPart bulkLoadPart(const int tid, const K* keys, const V* values,
+                            const int n);
+  void bulkLoadFinish(const int tid, BulkLoadPart* parts, const int numParts);
+
   void startCleanup() { rqProvider->startCleanup(); }
   void stopCleanup() { rqProvider->stopCleanup(); }
   bool contains(const int tid, const K& key);
@@ -160,6 +240,12 @@ class bundle_citrustree {
     return (key != NO_KEY && lo <= key && key <= hi);
   }
 
+  // Retires the bundle entries of a node that is being retired.
+  inline void retireBundles(const int tid, node_t<K, V>* node) {
+    node->rqbundle[0].retireEntries(tid, recordmgr);
+    node->rqbundle[1].retireEntries(tid, recordmgr);
+  }
+
   /**
    * END FUNCTIONS FOR RANGE QUERY SUPPORT
    */
@@ -192,6 +278,34 @@ class bundle_citrustree {
 
   bool validateBundles(int tid);
 
+  // Sum and number of the bundle lengths sampled by updates so far.
+  void getBundleLengthSamples(long long &sum, long long &count) {
+    rqProvider->get_bundle_length_samples(sum, count);
+  }
+
+  // Histogram of the bundle lengths sampled by updates so far.
+  void getBundleLengthHistogram(BundleLengthHistogram &histogram) {
+    rqProvider->get_bundle_length_histogram(histogram);
+  }
+
+  // [UNSAFE] Memory used by the tree, including its sentinels. Must not run
+  // concurrently with updates (see bundle_footprint.h).
+  void getFootprint(BundleFootprint &footprint) {
+    stack<node_t<K, V>*> s;
+    s.push(root);
+    while (!s.empty()) {
+      node_t<K, V>* curr = s.top();
+      s.pop();
+      footprint.addNode(sizeof(node_t<K, V>));
+      for (int i = 0; i < 2; ++i) {
+        footprint.addBundle(&curr->rqbundle[i]);
+        node_t<K, V>* child = curr->child[i];
+        if (child != nullptr) s.push(child);
+      }
+    }
+    footprint.addRecords<node_t<K, V>, BundleEntry<node_t<K, V>>>(recordmgr);
+  }
+
   string getBundleStatsString() {
     unsigned int max = 0;
     nodeptr max_node = nullptr;
@@ -294,6 +408,13 @@ class bundle_citrustree {
     else
       init[tid] = !init[tid];
 
+#ifndef BUNDLE_CITRUS_SYNCHRONIZE
+    // Finish the unlinks this thread deferred while it can still retire.
+    recordmgr->leaveQuiescentState(tid);
+    urcu::barrier();
+    recordmgr->enterQuiescentState(tid);
+#endif
+
     rqProvider->deinitThread(tid);
     recordmgr->deinitThread(tid);
   }
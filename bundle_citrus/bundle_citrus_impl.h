@@ -44,6 +44,41 @@
 using namespace std;
 using namespace urcu;
 
+template <typename K, typename V, class RecManager>
+inline void bundle_citrustree<K, V, RecManager>::lockNode(volatile int* lock) {
+#ifndef BUNDLE_CITRUS_SYNCHRONIZE
+  while (!tryAcquireLock(lock)) {
+    pollAll();
+  }
+#else
+  acquireLock(lock);
+#endif
+}
+
+#ifndef BUNDLE_CITRUS_SYNCHRONIZE
+template <typename K, typename V, class RecManager>
+void bundle_citrustree<K, V, RecManager>::unlinkSuccessor(const int tid,
+                                                         void* arg) {
+  deferred_unlink* u = (deferred_unlink*)arg;
+  nodeptr succ = u->succ;
+  succ->marked = true;
+  int direction = (u->prevSucc == u->nnode ? 1 : 0);
+  u->prevSucc->child[direction] = succ->child[1];
+  if (u->prevSucc->child[direction] == NULL) {
+    u->prevSucc->tag[direction]++;
+  }
+
+  releaseLock(&(u->nnode->lock));
+  if (u->prevSucc != u->nnode) releaseLock(&(u->prevSucc->lock));
+  releaseLock(&(succ->lock));
+
+  // The successor was reachable until now, so it is only retired now.
+  nodeptr deletedNodes[] = {succ, nullptr};
+  u->tree->rqProvider->physical_deletion_succeeded(tid, deletedNodes);
+  delete u;
+}
+#endif
+
 template <typename K, typename V, class RecManager>
 nodeptr bundle_citrustree<K, V, RecManager>::newNode(const int tid, K key,
                                                      V value) {
@@ -102,7 +137,7 @@ bundle_citrustree<K, V, RecManager>::bundle_citrustree(
   // Prepare bundles for "real" insertion.
   BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {&_root->rqbundle[0], nullptr};
   nodeptr ptrs[] = {_rootchild, nullptr};
-  rqProvider->prepare_bundles(bundles, ptrs);
+  rqProvider->prepare_bundles(tid, bundles, ptrs);
 
   // Perform linearization point.
   timestamp_t lin_time =
@@ -200,6 +235,9 @@ const V bundle_citrustree<K, V, RecManager>::doInsert(const int tid,
 
 retry:
   recordmgr->leaveQuiescentState(tid);
+#ifndef BUNDLE_CITRUS_SYNCHRONIZE
+  poll();
+#endif
   readLock();
   SEARCH;
   tag = prev->tag[direction];
@@ -218,17 +256,17 @@ retry:
     }
   }
 
-  acquireLock(&(prev->lock));
+  lockNode(&(prev->lock));
   if (validate(tid, prev, tag, curr, direction)) {
     nodeptr nnode = newNode(tid, key, value);
-    acquireLock(&(nnode->lock));
+    lockNode(&(nnode->lock));
 
     // Prepare the bundles.
     BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {
         &nnode->rqbundle[0], &nnode->rqbundle[1], &prev->rqbundle[direction],
         nullptr};
     nodeptr ptrs[] = {nullptr, nullptr, nnode, nullptr};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
 
     // Perform linearization.
     timestamp_t lin_time = rqProvider->linearize_update_at_write(
@@ -278,6 +316,9 @@ const pair<V, bool> bundle_citrustree<K, V, RecManager>::erase(const int tid,
 
 retry:
   recordmgr->leaveQuiescentState(tid);
+#ifndef BUNDLE_CITRUS_SYNCHRONIZE
+  poll();
+#endif
   readLock();
   SEARCH;
   readUnlock();
@@ -285,8 +326,8 @@ retry:
     recordmgr->enterQuiescentState(tid);
     return pair<V, bool>(NO_VALUE, false);
   }
-  acquireLock(&(prev->lock));
-  acquireLock(&(curr->lock));
+  lockNode(&(prev->lock));
+  lockNode(&(curr->lock));
   if (!validate(tid, prev, 0, curr, direction)) {
     releaseLock(&(prev->lock));
     releaseLock(&(curr->lock));
@@ -300,7 +341,7 @@ retry:
     BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {&prev->rqbundle[direction],
                                                  nullptr};
     nodeptr ptrs[] = {curr->child[1], nullptr};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
 
     // Perform linearization.
     timestamp_t lin_time = rqProvider->linearize_update_at_write(
@@ -330,7 +371,7 @@ retry:
     BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {&prev->rqbundle[direction],
                                                  nullptr};
     nodeptr ptrs[] = {curr->child[0], nullptr};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
 
     // Perform linearization.
     timestamp_t lin_time = rqProvider->linearize_update_at_write(
@@ -363,17 +404,17 @@ retry:
   }
   int succDirection = 1;
   if (prevSucc != curr) {
-    acquireLock(&(prevSucc->lock));
+    lockNode(&(prevSucc->lock));
     succDirection = 0;
   }
-  acquireLock(&(succ->lock));
+  lockNode(&(succ->lock));
   if (validate(tid, prevSucc, 0, succ, succDirection) &&
       validate(tid, succ, succ->tag[0], NULL, 0)) {
     curr->marked = true;
     nnode = newNode(tid, succ->key, succ->value);
     nnode->child[0] = curr->child[0];
     nnode->child[1] = curr->child[1];
-    acquireLock(&(nnode->lock));
+    lockNode(&(nnode->lock));
 
     // Prepare bundles. Note that if the successor's parent is the node being
     // deleted then the new node (which is a copy of the successor) needs to
@@ -387,7 +428,7 @@ retry:
     nodeptr ptrs[] = {nnode, curr->child[0],
                       (prevSucc != curr ? curr->child[1] : succ->child[1]),
                       (prevSucc != curr ? succ->child[1] : nullptr), nullptr};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
 
     // Perform linearization.
     timestamp_t lin_time = rqProvider->linearize_update_at_write(
@@ -396,6 +437,24 @@ retry:
     // Finalize bundles.
     rqProvider->finalize_bundles(bundles, lin_time);
 
+#ifndef BUNDLE_CITRUS_SYNCHRONIZE
+    // Readers cannot reach curr through prev anymore, so only the nodes the
+    // unlink modifies stay locked.
+    nodeptr deletedNodes[] = {curr, nullptr};
+    rqProvider->physical_deletion_succeeded(tid, deletedNodes);
+    V result = curr->value;
+    releaseLock(&(prev->lock));
+    releaseLock(&(curr->lock));
+
+    deferred_unlink* u = new deferred_unlink();
+    u->tree = this;
+    u->nnode = nnode;
+    u->prevSucc = (prevSucc == curr ? nnode : prevSucc);
+    u->succ = succ;
+    deferCall(unlinkSuccessor, u);
+    recordmgr->enterQuiescentState(tid);
+    return pair<V, bool>(result, true);
+#else
     nodeptr deletedNodes[] = {curr, succ, nullptr};
     rqProvider->physical_deletion_succeeded(tid, deletedNodes);
 
@@ -423,6 +482,7 @@ retry:
     releaseLock(&(succ->lock));
     recordmgr->enterQuiescentState(tid);
     return pair<V, bool>(result, true);
+#endif
   }
   releaseLock(&(prev->lock));
   releaseLock(&(curr->lock));
@@ -524,32 +584,355 @@ int bundle_citrustree<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
 }
 
 template <typename K, typename V, class RecManager>
-void bundle_citrustree<K, V, RecManager>::cleanup(int tid) {
+template <typename Visitor>
+int bundle_citrustree<K, V, RecManager>::visitRange(const int tid, const K& lo,
+                                                    const K& hi, Visitor visit,
+                                                    const int limit) {
+  // Traverse tree until the root of the subtree defining the range is found.
+  while (true) {
+    recordmgr->leaveQuiescentState(tid, true);
+    timestamp_t ts = rqProvider->start_traversal(tid);
+    nodeptr curr = root->child[0];
+    nodeptr pred = nullptr;
+    int direction = -1;
+    bool range_found = false;
+    while (curr != nullptr) {
+#ifndef BUNDLE_OPTIMIZE_RQ
+      if (curr->key >= lo && curr->key <= hi) {
+        range_found = true;
+        break;
+      } else if (curr->key < lo) {
+        curr = curr->rqbundle[1].getPtrByTimestamp(ts);
+      } else {
+        curr = curr->rqbundle[0].getPtrByTimestamp(ts);
+      }
+#else
+      if (curr->key >= lo && curr->key <= hi) {
+        // Phase 2. Enter the range.
+        range_found = true;
+        curr = pred->rqbundle[direction]->getPtrByTimestamp(ts);
+        break;
+      } else if (curr->key < lo) {
+        // Phase 1. Search right subtree.
+        pred = curr;
+        curr = curr->child[1];
+        direction = 1;
+      } else {
+        // Phase 1. Search left subtree.
+        pred = curr;
+        curr = curr->child[0];
+        direction = 0;
+      }
+#endif
+    }
+
+    if (curr == nullptr) {
+      rqProvider->end_traversal(tid);
+      recordmgr->enterQuiescentState(tid);
+      if (!range_found) {
+        // Return if no node was in the range.
+        return 0;
+      }
+      continue;
+    }
+
+    // Phase 3. Visit the subtree in key order, so that keys are visited in
+    // increasing order and a limit keeps the smallest ones. The stack holds
+    // the nodes whose key and right subtree are left to visit, so it never
+    // grows beyond the height of the tree.
+    block<node_t<K, V>> stack(nullptr);
+    int cnt = 0;
+    nodeptr node = curr;
+    while (true) {
+      while (node != nullptr) {
+        stack.push(node);
+        node = (lo < node->key ? node->rqbundle[0].getPtrByTimestamp(ts)
+                               : nullptr);
+      }
+      if (stack.isEmpty() || cnt == limit) {
+        break;
+      }
+      node = stack.pop();
+      if (isInRange(node->key, lo, hi)) {
+        ++cnt;
+        if (!visit(node->key, node->value)) {
+          break;
+        }
+      }
+      node = (hi > node->key ? node->rqbundle[1].getPtrByTimestamp(ts)
+                             : nullptr);
+    }
+    while (!stack.isEmpty()) {
+      stack.pop();
+    }
+    rqProvider->end_traversal(tid);
+    recordmgr->enterQuiescentState(tid);
+    return cnt;
+  }
+}
+
+template <typename K, typename V, class RecManager>
+template <typename Visitor>
+int bundle_citrustree<K, V, RecManager>::visitRanges(const int tid,
+                                                     const int n,
+                                                     const K* const los,
+                                                     const K* const his,
+                                                     Visitor visit) {
+  if (n <= 0) {
+    return 0;
+  }
+  int order[n];
+  for (int i = 0; i < n; ++i) {
+    order[i] = i;
+  }
+  std::sort(order, order + n,
+            [los](const int a, const int b) { return los[a] < los[b]; });
+
+  recordmgr->leaveQuiescentState(tid, true);
+  timestamp_t ts = rqProvider->start_traversal(tid);
+
+  // Visit the snapshot in key order. The stack holds the nodes whose key and
+  // right subtree are left to visit, smallest key on top, so every key larger
+  // than the ones visited so far is on it or in one of those subtrees.
+  block<node_t<K, V>> stack(nullptr);
+  auto seek = [&](nodeptr node, const K& lo) {
+    while (node != nullptr) {
+      if (lo <= node->key) {
+        stack.push(node);
+        node = node->rqbundle[0].getPtrByTimestamp(ts);
+      } else {
+        node = node->rqbundle[1].getPtrByTimestamp(ts);
+      }
+    }
+  };
+
+  int cnt = 0;
+  K max_hi = his[order[0]];
+  for (int i = 0; i < n; ++i) {
+    const int r = order[i];
+    const K lo = los[r];
+    const K hi = his[r];
+    nodeptr node;
+    if (i == 0 || lo <= max_hi) {
+      // The range may start among keys that were already visited, so start
+      // over from the root.
+      while (!stack.isEmpty()) {
+        stack.pop();
+      }
+      seek(root->child[0], lo);
+    } else {
+      // Resume from the previous range.
+      while (!stack.isEmpty()) {
+        node = stack.pop();
+        if (node->key >= lo) {
+          stack.push(node);
+          break;
+        }
+        seek(node->rqbundle[1].getPtrByTimestamp(ts), lo);
+      }
+    }
+    max_hi = std::max(max_hi, hi);
+
+    while (!stack.isEmpty()) {
+      node = stack.pop();
+      if (node->key > hi) {
+        stack.push(node);
+        break;
+      }
+      // The whole right subtree is larger than lo.
+      seek(node->rqbundle[1].getPtrByTimestamp(ts), lo);
+      if (isInRange(node->key, lo, hi)) {
+        ++cnt;
+        if (!visit(r, node->key, node->value)) {
+          break;
+        }
+      }
+    }
+  }
+  while (!stack.isEmpty()) {
+    stack.pop();
+  }
+  rqProvider->end_traversal(tid);
+  recordmgr->enterQuiescentState(tid);
+  return cnt;
+}
+
+template <typename K, typename V, class RecManager>
+int bundle_citrustree<K, V, RecManager>::multiRangeQuery(
+    const int tid, const int n, const K* const los, const K* const his,
+    K* const resultKeys, V* const resultValues, int* const starts,
+    int* const counts) {
+  for (int i = 0; i < n; ++i) {
+    starts[i] = 0;
+    counts[i] = 0;
+  }
+  int cnt = 0;
+  return visitRanges(tid, n, los, his,
+                     [&](const int r, const K& key, const V& value) {
+                       if (counts[r]++ == 0) {
+                         starts[r] = cnt;
+                       }
+                       resultKeys[cnt] = key;
+                       resultValues[cnt++] = value;
+                       return true;
+                     });
+}
+
+template <typename K, typename V, class RecManager>
+bool bundle_citrustree<K, V, RecManager>::cleanup(int tid, K& cursor,
+                                                  const K& last, int budget) {
   recordmgr->leaveQuiescentState(tid, true);
   BUNDLE_INIT_CLEANUP(rqProvider);
-  nodeptr curr = root->child[0];
 
+  // Visit the nodes in key order, starting from the first key that is at
+  // least cursor. The stack holds the nodes whose key and right subtree are
+  // left to visit.
   block<node_t<K, V>> stack(nullptr);
-  stack.push(curr);
+  nodeptr node = root->child[0];
+  while (node != nullptr) {
+    if (node->key >= cursor) {
+      stack.push(node);
+      node = node->child[0];
+    } else {
+      node = node->child[1];
+    }
+  }
+  bool done = true;
   while (!stack.isEmpty()) {
-    // Get the next node to process.
-    nodeptr node = stack.pop();
+    node = stack.pop();
+    if (node->key > last) {
+      break;
+    }
+    if (budget-- == 0) {
+      cursor = node->key;
+      done = false;
+      break;
+    }
 
-    // Add its children to the stack.
-    nodeptr left = node->child[0];
-    nodeptr right = node->child[1];
-    if (left != nullptr) {
-      stack.push(left);
+    // Clean up the bundles. Bundles of deleted nodes are retired along with
+    // the node, so the node must not be deleted meanwhile. Busy nodes are
+    // skipped.
+    if (tryAcquireLock(&(node->lock))) {
+      if (!node->marked) {
+        BUNDLE_CLEAN_BUNDLE(node->rqbundle[0]);
+        BUNDLE_CLEAN_BUNDLE(node->rqbundle[1]);
+      }
+      releaseLock(&(node->lock));
     }
-    if (right != nullptr) {
-      stack.push(right);
+
+    for (node = node->child[1]; node != nullptr; node = node->child[0]) {
+      stack.push(node);
     }
+  }
+  while (!stack.isEmpty()) {
+    stack.pop();
+  }
+  recordmgr->enterQuiescentState(tid);
+  return done;
+}
 
-    // Clean up the bundles.
-    BUNDLE_CLEAN_BUNDLE(node->rqbundle[0]);
-    BUNDLE_CLEAN_BUNDLE(node->rqbundle[1]);
+template <typename K, typename V, class RecManager>
+bool bundle_citrustree<K, V, RecManager>::getKeyBounds(int tid, K& lo, K& hi) {
+  recordmgr->leaveQuiescentState(tid, true);
+  // The sentinel below the root holds every key in its left subtree.
+  nodeptr curr = root->child[0]->child[0];
+  const bool empty = (curr == nullptr);
+  if (!empty) {
+    for (nodeptr next = curr; next != nullptr; next = next->child[0]) {
+      lo = next->key;
+    }
+    for (nodeptr next = curr; next != nullptr; next = next->child[1]) {
+      hi = next->key;
+    }
   }
   recordmgr->enterQuiescentState(tid);
+  return !empty;
+}
+
+template <typename K, typename V, class RecManager>
+inline void bundle_citrustree<K, V, RecManager>::bulkLoadLink(const int tid,
+                                                             nodeptr node,
+                                                             nodeptr left,
+                                                             nodeptr right) {
+  node->child[0] = left;
+  node->child[1] = right;
+  rqProvider->init_bundle(tid, &node->rqbundle[0], left);
+  rqProvider->init_bundle(tid, &node->rqbundle[1], right);
+}
+
+template <typename K, typename V, class RecManager>
+nodeptr bundle_citrustree<K, V, RecManager>::bulkLoadSubtree(const int tid,
+                                                            const K* keys,
+                                                            const V* values,
+                                                            const int n) {
+  if (n == 0) return nullptr;
+  const int mid = n / 2;
+  nodeptr node = newNode(tid, keys[mid], values[mid]);
+  nodeptr left = bulkLoadSubtree(tid, keys, values, mid);
+  nodeptr right =
+      bulkLoadSubtree(tid, keys + mid + 1, values + mid + 1, n - mid - 1);
+  bulkLoadLink(tid, node, left, right);
+  return node;
+}
+
+template <typename K, typename V, class RecManager>
+nodeptr bundle_citrustree<K, V, RecManager>::bulkLoadJoin(const int tid,
+                                                         nodeptr* pivots,
+                                                         nodeptr* subtrees,
+                                                         const int a,
+                                                         const int b) {
+  if (a == b) return subtrees[a];
+  const int mid = (a + b + 1) / 2;
+  bulkLoadLink(tid, pivots[mid], bulkLoadJoin(tid, pivots, subtrees, a, mid - 1),
+               bulkLoadJoin(tid, pivots, subtrees, mid, b));
+  return pivots[mid];
+}
+
+template <typename K, typename V, class RecManager>
+typename bundle_citrustree<K, V, RecManager>::BulkLoadPart
+bundle_citrustree<K, V, RecManager>::bulkLoadPart(const int tid, const K* keys,
+                                                  const V* values,
+                                                  const int n) {
+  BulkLoadPart part = {nullptr, nullptr};
+  if (n > 0) {
+    part.pivot = newNode(tid, keys[0], values[0]);
+    part.subtree = bulkLoadSubtree(tid, keys + 1, values + 1, n - 1);
+  }
+  return part;
+}
+
+template <typename K, typename V, class RecManager>
+void bundle_citrustree<K, V, RecManager>::bulkLoadFinish(const int tid,
+                                                         BulkLoadPart* parts,
+                                                         const int numParts) {
+  nodeptr rootchild = root->child[0];
+  assert(rootchild->child[0] == nullptr);
+  nodeptr* pivots = new nodeptr[numParts];
+  nodeptr* subtrees = new nodeptr[numParts];
+  int m = 0;
+  for (int i = 0; i < numParts; ++i) {
+    if (parts[i].pivot == nullptr) continue;
+    pivots[m] = parts[i].pivot;
+    subtrees[m] = parts[i].subtree;
+    ++m;
+  }
+  if (m > 0) {
+    // Nothing is smaller than the first pivot, so it heads its own subtree.
+    bulkLoadLink(tid, pivots[0], nullptr, subtrees[0]);
+    subtrees[0] = pivots[0];
+    nodeptr tree = bulkLoadJoin(tid, pivots, subtrees, 0, m - 1);
+
+    // Link the loaded nodes in as a single insertion below the sentinel.
+    BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {&rootchild->rqbundle[0],
+                                                 nullptr};
+    nodeptr ptrs[] = {tree, nullptr};
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
+    timestamp_t lin_time =
+        rqProvider->linearize_update_at_write(tid, &rootchild->child[0], tree);
+    rqProvider->finalize_bundles(bundles, lin_time);
+  }
+  delete[] pivots;
+  delete[] subtrees;
 }
 
 template <typename K, typename V, class RecManager>
@@ -562,6 +945,13 @@ bool bundle_citrustree<K, V, RecManager>::validateBundles(int tid) {
     nodeptr node = stack.pop();
 
     // Validate the bundles.
+    for (int i = 0; i < 2; ++i) {
+      if (!node->rqbundle[i].validate()) {
+        std::cout << "Invalid bundle! [key=" << node->key << ",child=" << i
+                  << "] " << node->rqbundle[i].dump(0) << std::flush;
+        valid = false;
+      }
+    }
     nodeptr ptr;
     timestamp_t ts;
     ptr = node->rqbundle[0].first(ts);
@@ -44,6 +44,7 @@ class bundle_lazylist {
                   const V NO_VALUE);
   ~bundle_lazylist();
   bool contains(const int tid, const K& key);
+  const pair<V, bool> find(const int tid, const K& key);
   V insert(const int tid, const K& key, const V& value) {
     return doInsert(tid, key, value, false);
   }
@@ -53,7 +54,38 @@ class bundle_lazylist {
   V erase(const int tid, const K& key);
   int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
                  V* const resultValues);
-  void cleanup(int tid);
+  // Calls visit(key, value) on each key in [lo, hi], in increasing order and
+  // as of the same snapshot a range query would return, without collecting
+  // them in an array. Stops early once visit returns false or limit keys have
+  // been visited (a negative limit visits every key). The range query stays
+  // announced until it returns, so visit should be short and must not call
+  // back into the data structure. Returns the number of keys visited.
+  template <typename Visitor>
+  int visitRange(const int tid, const K& lo, const K& hi, Visitor visit,
+                 const int limit = -1);
+  // Cleans the bundles of up to budget nodes with keys in [cursor, last].
+  // Returns true if it reached last, otherwise sets cursor to the key of the
+  // first node it did not clean (see bundle_cleaner.h).
+  // Each call walks the list from the head to cursor, so the cleaner sizes
+  // its batches from the length of the list (see bundle_cleaner.h).
+  static const bool CLEANUP_SEEKS_FROM_HEAD = true;
+  bool cleanup(int tid, K& cursor, const K& last, int budget);
+  // Returns the smallest and largest keys, or false if there are none.
+  bool getKeyBounds(int tid, K& lo, K& hi);
+
+  // Bulk loading of an empty list that no other thread is using yet. Several
+  // threads may each build a part from a batch of sorted, distinct keys, then
+  // one thread links the parts, given in increasing order of their keys. Every
+  // bundle holds a single entry, as if each node had been inserted before the
+  // first range query.
+  struct BulkLoadPart {
+    nodeptr first;
+    nodeptr last;
+  };
+  BulkLoadPart bulkLoadPart(const int tid, const K* keys, const V* values,
+                            const int n);
+  void bulkLoadFinish(const int tid, BulkLoadPart* parts, const int numParts);
+
   void startCleanup() { rqProvider->startCleanup(); }
   void stopCleanup() { rqProvider->stopCleanup(); }
   bool validateBundles(int tid);
@@ -106,6 +138,11 @@ class bundle_lazylist {
     return 1;
   }
 
+  // Retires the bundle entries of a node that is being retired.
+  inline void retireBundles(const int tid, node_t<K, V>* node) {
+    node->rqbundle.retireEntries(tid, recordmgr);
+  }
+
   bool isInRange(const K& key, const K& lo, const K& hi) {
     return (lo <= key && key <= hi);
   }
@@ -117,6 +154,27 @@ class bundle_lazylist {
 
   node_t<K, V>* debug_getEntryPoint() { return head; }
 
+  // Sum and number of the bundle lengths sampled by updates so far.
+  void getBundleLengthSamples(long long &sum, long long &count) {
+    rqProvider->get_bundle_length_samples(sum, count);
+  }
+
+  // Histogram of the bundle lengths sampled by updates so far.
+  void getBundleLengthHistogram(BundleLengthHistogram &histogram) {
+    rqProvider->get_bundle_length_histogram(histogram);
+  }
+
+  // [UNSAFE] Memory used by the list, including its sentinels. Must not run
+  // concurrently with updates (see bundle_footprint.h).
+  void getFootprint(BundleFootprint &footprint) {
+    for (nodeptr curr = head; curr != nullptr; curr = curr->next) {
+      footprint.addNode(sizeof(node_t<K, V>));
+      footprint.addBundle(&curr->rqbundle);
+      if (curr->key == KEY_MAX) break;
+    }
+    footprint.addRecords<node_t<K, V>, BundleEntry<node_t<K, V>>>(recordmgr);
+  }
+
   string getBundleStatsString() {
     unsigned int max = 0;
     nodeptr max_node = nullptr;
@@ -11,19 +11,24 @@
 #include <csignal>
 
 #include "bundle_lazylist.h"
-#include "locks_impl.h"
+#include "node_locks.h"
 
 #ifndef casword_t
 #define casword_t uintptr_t
 #endif
 
+// Lock of every node (see node_locks.h).
+#ifndef LAZYLIST_NODE_LOCK
+#define LAZYLIST_NODE_LOCK TTASNodeLock
+#endif
+
 template <typename K, typename V>
 class node_t {
  public:
   K key;
   volatile V val;
   node_t* volatile next;
-  volatile int lock;
+  NodeLock<LAZYLIST_NODE_LOCK> lock;
   volatile long long
       marked;  // is stored as a long long simply so it is large enough to be
                // used with the lock-free RQProvider (which requires all fields
@@ -75,7 +80,7 @@ bundle_lazylist<K, V, RecManager>::bundle_lazylist(const int numProcesses,
   // Perform linearization of max to ensure bundles correctly added.
   BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {&head->rqbundle, nullptr};
   nodeptr ptrs[] = {max, nullptr};
-  rqProvider->prepare_bundles(bundles, ptrs);
+  rqProvider->prepare_bundles(tid, bundles, ptrs);
   timestamp_t lin_time =
       rqProvider->linearize_update_at_write(tid, &head->next, max);
   rqProvider->finalize_bundles(bundles, lin_time);
@@ -87,9 +92,11 @@ bundle_lazylist<K, V, RecManager>::~bundle_lazylist() {
   nodeptr curr = head;
   while (curr->key < KEY_MAX) {
     nodeptr next = curr->next;
+    retireBundles(dummyTid, curr);
     recordmgr->deallocate(dummyTid, curr);
     curr = next;
   }
+  retireBundles(dummyTid, curr);
   recordmgr->deallocate(dummyTid, curr);
   delete rqProvider;
   recordmgr->printStatus();
@@ -134,7 +141,7 @@ nodeptr bundle_lazylist<K, V, RecManager>::new_node(const int tid, const K& key,
   nnode->val = val;
   nnode->next = next;
   nnode->marked = 0LL;
-  nnode->lock = false;
+  nnode->lock.init();
   nnode->rqbundle.init();
 #ifdef __HANDLE_STATS
   GSTATS_APPEND(tid, node_allocated_addresses, ((long long)nnode) % (1 << 12));
@@ -151,6 +158,12 @@ inline int bundle_lazylist<K, V, RecManager>::validateLinks(const int tid,
 
 template <typename K, typename V, class RecManager>
 bool bundle_lazylist<K, V, RecManager>::contains(const int tid, const K& key) {
+  return find(tid, key).second;
+}
+
+template <typename K, typename V, class RecManager>
+const pair<V, bool> bundle_lazylist<K, V, RecManager>::find(const int tid,
+                                                           const K& key) {
   recordmgr->leaveQuiescentState(tid, true);
   nodeptr curr = head;
   while (curr->key < key) {
@@ -162,7 +175,7 @@ bool bundle_lazylist<K, V, RecManager>::contains(const int tid, const K& key) {
     res = curr->val;
   }
   recordmgr->enterQuiescentState(tid);
-  return (res != NO_VALUE);
+  return pair<V, bool>(res, res != NO_VALUE);
 }
 
 template <typename K, typename V, class RecManager>
@@ -180,18 +193,18 @@ V bundle_lazylist<K, V, RecManager>::doInsert(const int tid, const K& key,
       pred = curr;
       curr = curr->next;
     }
-    acquireLock(&(pred->lock));
+    pred->lock.acquire(tid);
     if (validateLinks(tid, pred, curr)) {
       if (curr->key == key) {
         if (curr->marked) {  // this is an optimization
-          releaseLock(&(pred->lock));
+          pred->lock.release(tid);
           recordmgr->enterQuiescentState(tid);
           continue;
         }
         // node containing key is not marked
         if (onlyIfAbsent) {
           V result = curr->val;
-          releaseLock(&(pred->lock));
+          pred->lock.release(tid);
           recordmgr->enterQuiescentState(tid);
           return result;
         }
@@ -209,7 +222,7 @@ V bundle_lazylist<K, V, RecManager>::doInsert(const int tid, const K& key,
       BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {&newnode->rqbundle, &pred->rqbundle,
                                          nullptr};
       nodeptr ptrs[] = {curr, newnode, nullptr};
-      rqProvider->prepare_bundles(bundles, ptrs);
+      rqProvider->prepare_bundles(tid, bundles, ptrs);
 
       // Perform original linearization.
       timestamp_t lin_time =
@@ -219,11 +232,11 @@ V bundle_lazylist<K, V, RecManager>::doInsert(const int tid, const K& key,
       rqProvider->finalize_bundles(bundles, lin_time);
 
       // Release locks and return.
-      releaseLock(&(pred->lock));
+      pred->lock.release(tid);
       recordmgr->enterQuiescentState(tid);
       return result;
     }
-    releaseLock(&(pred->lock));
+    pred->lock.release(tid);
     recordmgr->enterQuiescentState(tid);
   }
 }
@@ -251,8 +264,8 @@ V bundle_lazylist<K, V, RecManager>::erase(const int tid, const K& key) {
       recordmgr->enterQuiescentState(tid);
       return result;
     }
-    acquireLock(&(curr->lock));
-    acquireLock(&(pred->lock));
+    curr->lock.acquire(tid);
+    pred->lock.acquire(tid);
     if (validateLinks(tid, pred, curr)) {
       // TODO: maybe implement version with atomic removal of consecutive marked
       // nodes
@@ -263,7 +276,7 @@ V bundle_lazylist<K, V, RecManager>::erase(const int tid, const K& key) {
       // Prepare bundles.
       BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {&pred->rqbundle, nullptr};
       nodeptr ptrs[] = {c_nxt, nullptr};
-      rqProvider->prepare_bundles(bundles, ptrs);
+      rqProvider->prepare_bundles(tid, bundles, ptrs);
 
       // Perform original linearization point.
       timestamp_t lin_time =
@@ -276,13 +289,13 @@ V bundle_lazylist<K, V, RecManager>::erase(const int tid, const K& key) {
       nodeptr deletedNodes[] = {curr, nullptr};
       rqProvider->physical_deletion_succeeded(tid, deletedNodes);
 
-      releaseLock(&(curr->lock));
-      releaseLock(&(pred->lock));
+      curr->lock.release(tid);
+      pred->lock.release(tid);
       recordmgr->enterQuiescentState(tid);
       return result;
     }
-    releaseLock(&(curr->lock));
-    releaseLock(&(pred->lock));
+    curr->lock.release(tid);
+    pred->lock.release(tid);
     recordmgr->enterQuiescentState(tid);
   }
 }
@@ -294,6 +307,7 @@ int bundle_lazylist<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
                                                   V* const resultValues) {
   timestamp_t ts;
   int cnt = 0;
+  int restarts = 0;
   for (;;) {
     recordmgr->leaveQuiescentState(tid, true);
 
@@ -311,6 +325,11 @@ int bundle_lazylist<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
 
     // Phase 2. Enter range using bundles.
     curr = pred->rqbundle.getPtrByTimestamp(ts);
+    if (curr == nullptr && restarts + 1 >= BUNDLE_RQ_MAX_RESTARTS) {
+      // Enter the range from the head rather than restart again.
+      ++restarts;
+      curr = head->rqbundle.getPtrByTimestamp(ts);
+    }
     while (curr != nullptr && curr->key <= hi) {
       if (curr->key >= lo) {
         // Phase 3. Collect snapshot while in the range.
@@ -325,25 +344,165 @@ int bundle_lazylist<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
 
     // Traversal was completed successfully.
     if (curr != nullptr) {
+      rqProvider->count_restarts(tid, restarts);
+      return cnt;
+    }
+    ++restarts;
+  }
+}
+
+template <typename K, typename V, class RecManager>
+template <typename Visitor>
+int bundle_lazylist<K, V, RecManager>::visitRange(const int tid, const K& lo,
+                                                  const K& hi, Visitor visit,
+                                                  const int limit) {
+  timestamp_t ts;
+  int cnt = 0;
+  int restarts = 0;
+  for (;;) {
+    recordmgr->leaveQuiescentState(tid, true);
+    ts = rqProvider->start_traversal(tid);
+
+    // Phase 1. Traverse to node immediately preceding range.
+    nodeptr pred = head;
+    nodeptr curr = pred->next;
+    while (curr->key < lo) {
+      pred = curr;
+      curr = curr->next;
+    }
+    assert(curr != nullptr);
+
+    // Phase 2. Enter range using bundles. Only this step can fail, so nothing
+    // has been visited yet if the traversal restarts.
+    curr = pred->rqbundle.getPtrByTimestamp(ts);
+    if (curr == nullptr && restarts + 1 >= BUNDLE_RQ_MAX_RESTARTS) {
+      // Enter the range from the head rather than restart again.
+      ++restarts;
+      curr = head->rqbundle.getPtrByTimestamp(ts);
+    }
+    while (curr != nullptr && curr->key <= hi && cnt != limit) {
+      if (curr->key >= lo) {
+        // Phase 3. Visit the snapshot while in the range.
+        ++cnt;
+        const K key = curr->key;
+        const V val = curr->val;
+        if (!visit(key, val)) {
+          break;
+        }
+      }
+      curr = curr->rqbundle.getPtrByTimestamp(ts);
+    }
+
+    rqProvider->end_traversal(tid);
+    recordmgr->enterQuiescentState(tid);
+    if (curr != nullptr) {
+      rqProvider->count_restarts(tid, restarts);
       return cnt;
     }
+    ++restarts;
   }
 }
 
 template <typename K, typename V, class RecManager>
-void bundle_lazylist<K, V, RecManager>::cleanup(int tid) {
+bool bundle_lazylist<K, V, RecManager>::cleanup(int tid, K& cursor,
+                                                const K& last, int budget) {
   // Walk the list using the newest edge and reclaim bundle entries.
   recordmgr->leaveQuiescentState(tid);
   BUNDLE_INIT_CLEANUP(rqProvider);
   while (head == nullptr)
     ;
-  BUNDLE_CLEAN_BUNDLE(&head->rqbundle);
-  for (nodeptr curr = head->next; curr->key != KEY_MAX; curr = curr->next) {
-    // if (!curr->marked) {
-    BUNDLE_CLEAN_BUNDLE(&curr->rqbundle);
-    // }
+  // The node at which the last batch stopped may have been freed since this
+  // thread left its epoch, so the batch starts over from the head. Keeping a
+  // node across batches would mean holding the epoch while the cleaner sleeps.
+  nodeptr curr = head;
+  while (curr->key != KEY_MAX && curr->key < cursor) {
+    curr = curr->next;
+  }
+  bool done = true;
+  for (; curr->key != KEY_MAX && curr->key <= last; curr = curr->next) {
+    if (budget-- == 0) {
+      cursor = curr->key;
+      done = false;
+      break;
+    }
+    // Bundles of deleted nodes are retired along with the node, so the node
+    // must not be deleted while its bundle is cleaned. Busy nodes are skipped.
+    if (curr->lock.tryAcquire(tid)) {
+      if (!curr->marked) {
+        BUNDLE_CLEAN_BUNDLE(curr->rqbundle);
+      }
+      curr->lock.release(tid);
+    }
   }
   recordmgr->enterQuiescentState(tid);
+  return done;
+}
+
+template <typename K, typename V, class RecManager>
+bool bundle_lazylist<K, V, RecManager>::getKeyBounds(int tid, K& lo, K& hi) {
+  recordmgr->leaveQuiescentState(tid);
+  while (head == nullptr)
+    ;
+  nodeptr curr = head->next;
+  const bool empty = (curr->key == KEY_MAX);
+  if (!empty) {
+    lo = curr->key;
+    while (curr->next->key != KEY_MAX) {
+      curr = curr->next;
+    }
+    hi = curr->key;
+  }
+  recordmgr->enterQuiescentState(tid);
+  return !empty;
+}
+
+template <typename K, typename V, class RecManager>
+typename bundle_lazylist<K, V, RecManager>::BulkLoadPart
+bundle_lazylist<K, V, RecManager>::bulkLoadPart(const int tid, const K* keys,
+                                                const V* values, const int n) {
+  BulkLoadPart part = {nullptr, nullptr};
+  for (int i = 0; i < n; ++i) {
+    nodeptr node = new_node(tid, keys[i], values[i], nullptr);
+    if (part.last == nullptr) {
+      part.first = node;
+    } else {
+      part.last->next = node;
+      rqProvider->init_bundle(tid, &part.last->rqbundle, node);
+    }
+    part.last = node;
+  }
+  return part;
+}
+
+template <typename K, typename V, class RecManager>
+void bundle_lazylist<K, V, RecManager>::bulkLoadFinish(const int tid,
+                                                       BulkLoadPart* parts,
+                                                       const int numParts) {
+  nodeptr max = head->next;
+  assert(max->key == KEY_MAX);
+  nodeptr first = nullptr;
+  nodeptr last = nullptr;
+  for (int i = 0; i < numParts; ++i) {
+    if (parts[i].first == nullptr) continue;
+    if (last == nullptr) {
+      first = parts[i].first;
+    } else {
+      last->next = parts[i].first;
+      rqProvider->init_bundle(tid, &last->rqbundle, parts[i].first);
+    }
+    last = parts[i].last;
+  }
+  if (first == nullptr) return;
+  last->next = max;
+  rqProvider->init_bundle(tid, &last->rqbundle, max);
+
+  // Link the loaded nodes in as a single insertion after head.
+  BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {&head->rqbundle, nullptr};
+  nodeptr ptrs[] = {first, nullptr};
+  rqProvider->prepare_bundles(tid, bundles, ptrs);
+  timestamp_t lin_time =
+      rqProvider->linearize_update_at_write(tid, &head->next, first);
+  rqProvider->finalize_bundles(bundles, lin_time);
 }
 
 template <typename K, typename V, class RecManager>
@@ -352,8 +511,13 @@ bool bundle_lazylist<K, V, RecManager>::validateBundles(int tid) {
   nodeptr temp;
   timestamp_t ts;
   bool valid = true;
-#ifdef BUNDLE_DEBUG
   while (curr->key < KEY_MAX) {
+    if (!curr->rqbundle.validate()) {
+      std::cout << "Invalid bundle! [key=" << curr->key << "] "
+                << curr->rqbundle.dump(0) << std::flush;
+      valid = false;
+    }
+#ifdef BUNDLE_DEBUG
     temp = curr->rqbundle.first(ts);
     if (temp != curr->next) {
       std::cout << "Pointer mismatch! [key=" << curr->next->key
@@ -362,9 +526,9 @@ bool bundle_lazylist<K, V, RecManager>::validateBundles(int tid) {
                 << "] " << curr->rqbundle.dump(0) << std::flush;
       valid = false;
     }
+#endif
     curr = curr->next;
   }
-#endif
   return valid;
 }
 
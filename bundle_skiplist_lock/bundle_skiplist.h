@@ -1,6 +1,7 @@
 #ifndef SKIPLIST_H
 #define SKIPLIST_H
 
+#include <algorithm>
 #include <stack>
 #include <type_traits>
 #include <unordered_set>
@@ -11,6 +12,7 @@
 #endif
 #include "plaf.h"
 #include "random.h"
+#include "node_locks.h"
 #include "rq_bundle.h"
 
 using namespace std;
@@ -24,6 +26,17 @@ using namespace std;
 #define SKIPLIST_MAX_LEVEL (20)
 #endif
 
+// Define to have searches start from the thread's search finger when they
+// look for keys near the ones its previous search did, instead of always
+// descending from the head. This pays off for localized accesses, but only
+// adds work for uniformly distributed keys.
+// #define SKIPLIST_SEARCH_FINGERS
+
+// Lock of every node (see node_locks.h).
+#ifndef SKIPLIST_NODE_LOCK
+#define SKIPLIST_NODE_LOCK TTASNodeLock
+#endif
+
 /////////////////////////////////////////////////////////
 // TYPES
 /////////////////////////////////////////////////////////
@@ -32,7 +45,7 @@ class node_t {
  public:
   struct {
    public:
-    volatile long lock;
+    NodeLock<SKIPLIST_NODE_LOCK> lock;
     volatile K key;
     volatile V val;
     volatile int topLevel;
@@ -83,11 +96,46 @@ class bundle_skiplist {
   debugCounters* const counters;
 #endif
 
+#ifdef SKIPLIST_SEARCH_FINGERS
+  // Search finger of a thread: the predecessors at each level found by its
+  // last search, which successive searches for nearby keys can start from
+  // instead of descending from the head, along with the keys of those nodes
+  // and of their successors at the time. The nodes may only be accessed while
+  // the reclamation epoch is the one in which they were found, so the finger
+  // is discarded once it changes.
+  struct finger_t {
+    long epoch;  // -1 until the first search.
+    nodeptr preds[SKIPLIST_MAX_LEVEL];
+    K predKeys[SKIPLIST_MAX_LEVEL];
+    K succKeys[SKIPLIST_MAX_LEVEL];
+  };
+  union padded_finger_t {
+    finger_t finger;
+    volatile char bytes[(sizeof(finger_t) + PREFETCH_SIZE_BYTES - 1) /
+                        PREFETCH_SIZE_BYTES * PREFETCH_SIZE_BYTES];
+  };
+  padded_finger_t fingers[MAX_TID_POW2];
+#endif
+
   nodeptr allocateNode(const int tid);
 
   void initNode(const int tid, nodeptr p_node, K key, V value, int height);
+  inline int fingerStart(const int tid, const K& key, const int minLevel,
+                         nodeptr& p_start);
+  inline void fingerSet(const int tid, const int level, nodeptr p_pred,
+                        const K succKey) {
+#ifdef SKIPLIST_SEARCH_FINGERS
+    finger_t& finger = fingers[tid].finger;
+    finger.preds[level] = p_pred;
+    finger.predKeys[level] = p_pred->key;
+    finger.succKeys[level] = succKey;
+#endif
+  }
+  // Finds the predecessors and successors of key at each level up to at least
+  // minLevel (every level, by default). Returns the highest of those levels at
+  // which key was found, or -1.
   int find_impl(const int tid, K key, nodeptr* p_preds, nodeptr* p_succs,
-                nodeptr* p_found);
+                nodeptr* p_found, const int minLevel = SKIPLIST_MAX_LEVEL - 1);
   V doInsert(const int tid, const K& key, const V& value, bool onlyIfAbsent);
 
   int init[MAX_TID_POW2] = {
@@ -115,8 +163,54 @@ class bundle_skiplist {
   V erase(const int tid, const K& key);
   int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
                  V* const resultValues);
-
-  void cleanup(int tid);
+  // Calls visit(key, value) on each key in [lo, hi], in increasing order and
+  // as of the same snapshot a range query would return, without collecting
+  // them in an array. Stops early once visit returns false or limit keys have
+  // been visited (a negative limit visits every key). The range query stays
+  // announced until it returns, so visit should be short and must not call
+  // back into the data structure. Returns the number of keys visited.
+  template <typename Visitor>
+  int visitRange(const int tid, const K& lo, const K& hi, Visitor visit,
+                 const int limit = -1);
+  // Answers the n ranges [los[i], his[i]] at a single snapshot, calling
+  // visit(i, key, value) on the keys of range i like visitRange does. Ranges
+  // are answered in increasing order of their lower bounds, each one resuming
+  // from where the previous one started instead of from the head. Returning
+  // false from visit skips the rest of range i. Returns the number of keys
+  // visited.
+  template <typename Visitor>
+  int visitRanges(const int tid, const int n, const K* const los,
+                  const K* const his, Visitor visit);
+  // Like rangeQuery, for the n ranges [los[i], his[i]] at a single snapshot
+  // (see visitRanges). The keys of range i are saved in resultKeys[starts[i]]
+  // to resultKeys[starts[i] + counts[i] - 1], and likewise for values. Returns
+  // the total number of keys.
+  int multiRangeQuery(const int tid, const int n, const K* const los,
+                      const K* const his, K* const resultKeys,
+                      V* const resultValues, int* const starts,
+                      int* const counts);
+
+  // Cleans the bundles of up to budget nodes with keys in [cursor, last].
+  // Returns true if it reached last, otherwise sets cursor to the key of the
+  // first node it did not clean (see bundle_cleaner.h).
+  // Each call searches for cursor, so batches can stay short.
+  static const bool CLEANUP_SEEKS_FROM_HEAD = false;
+  bool cleanup(int tid, K& cursor, const K& last, int budget);
+  // Returns the smallest and largest keys, or false if there are none.
+  bool getKeyBounds(int tid, K& lo, K& hi);
+
+  // Bulk loading of an empty skip-list that no other thread is using yet.
+  // Several threads may each build a part from a batch of sorted, distinct
+  // keys, drawing node heights as inserts do, then one thread links the parts,
+  // given in increasing order of their keys. Every bundle holds a single
+  // entry, as if each node had been inserted before the first range query.
+  struct BulkLoadPart {
+    nodeptr first[SKIPLIST_MAX_LEVEL];
+    nodeptr last[SKIPLIST_MAX_LEVEL];
+  };
+  BulkLoadPart bulkLoadPart(const int tid, const K* keys, const V* values,
+                            const int n);
+  void bulkLoadFinish(const int tid, BulkLoadPart* parts, const int numParts);
 
   void initThread(const int tid);
   void deinitThread(const int tid);
@@ -157,6 +251,11 @@ class bundle_skiplist {
     return 1;
   }
 
+  // Retires the bundle entries of a node that is being retired.
+  inline void retireBundles(const int tid, node_t<K, V>* node) {
+    node->rqbundle.retireEntries(tid, recmgr);
+  }
+
   bool isInRange(const K& key, const K& lo, const K& hi) {
     return (lo <= key && key <= hi);
   }
@@ -197,6 +296,27 @@ class bundle_skiplist {
 
   bool validateBundles(int tid);
 
+  // Sum and number of the bundle lengths sampled by updates so far.
+  void getBundleLengthSamples(long long &sum, long long &count) {
+    rqProvider->get_bundle_length_samples(sum, count);
+  }
+
+  // Histogram of the bundle lengths sampled by updates so far.
+  void getBundleLengthHistogram(BundleLengthHistogram &histogram) {
+    rqProvider->get_bundle_length_histogram(histogram);
+  }
+
+  // [UNSAFE] Memory used by the skiplist, including its sentinels. Must not run
+  // concurrently with updates (see bundle_footprint.h).
+  void getFootprint(BundleFootprint &footprint) {
+    for (nodeptr curr = p_head; curr != nullptr; curr = curr->p_next[0]) {
+      footprint.addNode(sizeof(node_t<K, V>));
+      footprint.addBundle(&curr->rqbundle);
+      if (curr == p_tail) break;
+    }
+    footprint.addRecords<node_t<K, V>, BundleEntry<node_t<K, V>>>(recmgr);
+  }
+
   string getBundleStatsString() {
     unsigned int max = 0;
     nodeptr max_node = nullptr;
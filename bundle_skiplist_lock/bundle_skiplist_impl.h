@@ -18,22 +18,18 @@
 #define CAS __sync_val_compare_and_swap
 
 template <typename K, typename V>
-static void sl_node_lock(nodeptr p_node) {
-  while (1) {
-    long cur_lock = p_node->lock;
-    if (likely(cur_lock == 0)) {
-      if (likely(CAS(&(p_node->lock), 0, 1) == 0)) {
-        return;
-      }
-    }
-    CPU_RELAX;
-  }
+static void sl_node_lock(const int tid, nodeptr p_node) {
+  p_node->lock.acquire(tid);
 }
 
 template <typename K, typename V>
-static void sl_node_unlock(nodeptr p_node) {
-  p_node->lock = 0;
-  SOFTWARE_BARRIER;
+static bool sl_node_trylock(const int tid, nodeptr p_node) {
+  return p_node->lock.tryAcquire(tid);
+}
+
+template <typename K, typename V>
+static void sl_node_unlock(const int tid, nodeptr p_node) {
+  p_node->lock.release(tid);
 }
 
 static int sl_randomLevel(const int tid, Random* const threadRNGs) {
@@ -68,7 +64,7 @@ void bundle_skiplist<K, V, RecordMgr>::initNode(const int tid, nodeptr p_node,
   p_node->key = key;
   p_node->val = value;
   p_node->topLevel = height;
-  p_node->lock = 0;
+  p_node->lock.init();
   p_node->marked = (long long)0;
   p_node->fullyLinked = (long long)0;
 }
@@ -83,19 +79,56 @@ nodeptr bundle_skiplist<K, V, RecordMgr>::allocateNode(const int tid) {
   return nnode;
 }
 
+// Returns the level from which a search for key, which needs the predecessors
+// at every level up to minLevel, should descend, and sets p_start to the node
+// it should start from. Like a finger search, this climbs the thread's finger
+// from minLevel to the first level at which key was between the keys of the
+// predecessor and its successor, and whose predecessor is still in the list.
+// The climb only reads the keys saved in the finger, since the successors may
+// have changed anyway: starting from any node of the list that precedes key
+// finds the right predecessors. If there is no such level, or the finger is
+// stale, the search descends from the head. The caller fills the finger in
+// (see fingerSet) at each level it descends through.
+template <typename K, typename V, class RecordMgr>
+int bundle_skiplist<K, V, RecordMgr>::fingerStart(const int tid, const K& key,
+                                                  const int minLevel,
+                                                  nodeptr& p_start) {
+  p_start = p_head;
+#ifdef SKIPLIST_SEARCH_FINGERS
+  finger_t& finger = fingers[tid].finger;
+  const long epoch = recmgr->readEpoch();
+  if (epoch != finger.epoch || epoch == -1) {
+    finger.epoch = epoch;
+    return SKIPLIST_MAX_LEVEL - 1;
+  }
+  for (int level = minLevel; level < SKIPLIST_MAX_LEVEL - 1; ++level) {
+    if (finger.predKeys[level] < key && key <= finger.succKeys[level]) {
+      nodeptr p_pred = finger.preds[level];
+      if (p_pred == p_head || (!p_pred->marked && p_pred->fullyLinked)) {
+        p_start = p_pred;
+        return level;
+      }
+      // A predecessor at a higher level may still be in the list.
+    }
+  }
+#endif
+  return SKIPLIST_MAX_LEVEL - 1;
+}
+
 template <typename K, typename V, class RecordMgr>
 int bundle_skiplist<K, V, RecordMgr>::find_impl(const int tid, K key,
                                                 nodeptr* p_preds,
                                                 nodeptr* p_succs,
-                                                nodeptr* p_found) {
+                                                nodeptr* p_found,
+                                                const int minLevel) {
   int level;
   int l_found = -1;
   nodeptr p_pred = NULL;
   nodeptr p_curr = NULL;
 
-  p_pred = p_head;
+  const int startLevel = fingerStart(tid, key, minLevel, p_pred);
 
-  for (level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level--) {
+  for (level = startLevel; level >= 0; level--) {
     p_curr = p_pred->p_next[level];
     while (key > p_curr->key) {
       p_pred = p_curr;
@@ -107,6 +140,11 @@ int bundle_skiplist<K, V, RecordMgr>::find_impl(const int tid, K key,
     p_preds[level] = p_pred;
     p_succs[level] = p_curr;
   }
+#ifdef SKIPLIST_SEARCH_FINGERS
+  for (level = 0; level <= startLevel; ++level) {
+    fingerSet(tid, level, p_preds[level], p_succs[level]->key);
+  }
+#endif
   if (p_found) *p_found = p_curr;
   return l_found;
 }
@@ -142,6 +180,11 @@ bundle_skiplist<K, V, RecManager>::bundle_skiplist(const int numProcesses,
   for (i = 0; i < SKIPLIST_MAX_LEVEL; i++) {
     p_head->p_next[i] = p_tail;
   }
+#ifdef SKIPLIST_SEARCH_FINGERS
+  for (i = 0; i < MAX_TID_POW2; i++) {
+    fingers[i].finger.epoch = -1;
+  }
+#endif
 
   rqProvider =
       new RQProvider<K, V, node_t<K, V>, bundle_skiplist<K, V, RecManager>,
@@ -155,8 +198,10 @@ bundle_skiplist<K, V, RecManager>::~bundle_skiplist() {
   while (curr->key < KEY_MAX) {
     auto tmp = curr;
     curr = curr->p_next[0];
+    retireBundles(dummyTid, tmp);
     recmgr->retire(dummyTid, tmp);
   }
+  retireBundles(dummyTid, curr);
   recmgr->retire(dummyTid, curr);
   delete rqProvider;
   recmgr->printStatus();
@@ -200,7 +245,7 @@ bool bundle_skiplist<K, V, RecManager>::contains(const int tid, K key) {
   int lFound;
   bool res;
   recmgr->leaveQuiescentState(tid, true);
-  lFound = find_impl(tid, key, p_preds, p_succs, &p_found);
+  lFound = find_impl(tid, key, p_preds, p_succs, &p_found, 0);
   res = (lFound != -1) && p_succs[lFound]->fullyLinked &&
         !p_succs[lFound]->marked;
 #ifdef RQ_SNAPCOLLECTOR
@@ -223,7 +268,7 @@ const pair<V, bool> bundle_skiplist<K, V, RecManager>::find(const int tid,
   int lFound;
   bool res;
   recmgr->leaveQuiescentState(tid, true);
-  lFound = find_impl(tid, key, p_preds, p_succs, &p_found);
+  lFound = find_impl(tid, key, p_preds, p_succs, &p_found, 0);
   res = (lFound != -1) && p_succs[lFound]->fullyLinked &&
         !p_succs[lFound]->marked;
 #ifdef RQ_SNAPCOLLECTOR
@@ -260,7 +305,7 @@ V bundle_skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
   topLevel = sl_randomLevel(tid, threadRNGs);
   while (!done) {
     recmgr->leaveQuiescentState(tid);
-    lFound = find_impl(tid, key, p_preds, p_succs, NULL);
+    lFound = find_impl(tid, key, p_preds, p_succs, NULL, topLevel);
     if (lFound != -1) {
       p_node_found = p_succs[lFound];
       if (!p_node_found->marked) {
@@ -294,7 +339,7 @@ V bundle_skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
       p_succ = p_succs[level];
       if (level == 0 || p_preds[level] != p_preds[level - 1]) {
         // don't try to lock same node twice
-        sl_node_lock(p_pred);
+        sl_node_lock(tid, p_pred);
       }
       highestLocked = level;
       // make sure nothing has changed in between
@@ -309,7 +354,7 @@ V bundle_skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
                     ((long long)p_new_node) % (1 << 12));
 #endif
       initNode(tid, p_new_node, key, value, topLevel);
-      sl_node_lock(p_new_node);
+      sl_node_lock(tid, p_new_node);
       p_new_node->topLevel = topLevel;
       for (level = 0; level <= topLevel; level++) {
         p_new_node->p_next[level] = p_succs[level];
@@ -319,7 +364,7 @@ V bundle_skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
       BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {
           &p_preds[0]->rqbundle, &p_new_node->rqbundle, nullptr};
       nodeptr ptrs[] = {p_new_node, p_succs[0], nullptr};
-      rqProvider->prepare_bundles(bundles, ptrs);
+      rqProvider->prepare_bundles(tid, bundles, ptrs);
 
       SOFTWARE_BARRIER;
       for (level = 0; level <= topLevel; level++) {
@@ -333,14 +378,14 @@ V bundle_skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
 #endif
       // p_new_node->fullyLinked = 1;
       done = 1;
-      sl_node_unlock(p_new_node);
+      sl_node_unlock(tid, p_new_node);
     }
 
     // unlock everything here
     for (level = 0; level <= highestLocked; level++) {
       if (level == 0 || p_preds[level] != p_preds[level - 1]) {
         // don't try to unlock the same node twice
-        sl_node_unlock(p_preds[level]);
+        sl_node_unlock(tid, p_preds[level]);
       }
     }
 
@@ -382,9 +427,9 @@ V bundle_skiplist<K, V, RecManager>::erase(const int tid, const K& key) {
                         (p_victim->topLevel == lFound) && !p_victim->marked)) {
       if (!isMarked) {
         topLevel = p_victim->topLevel;
-        sl_node_lock(p_victim);
+        sl_node_lock(tid, p_victim);
         if (p_victim->marked) {
-          sl_node_unlock(p_victim);
+          sl_node_unlock(tid, p_victim);
           // ret = 0; ret is already NO_VALUE = fail
           recmgr->enterQuiescentState(tid);
           break;
@@ -398,7 +443,7 @@ V bundle_skiplist<K, V, RecManager>::erase(const int tid, const K& key) {
         p_pred = p_preds[level];
         if (level == 0 ||
             p_preds[level] != p_preds[level - 1]) {  // don't do twice
-          sl_node_lock(p_pred);
+          sl_node_lock(tid, p_pred);
         }
         highestLocked = level;
         valid = (!p_pred->marked && (p_pred->p_next[level] == p_victim));
@@ -408,7 +453,7 @@ V bundle_skiplist<K, V, RecManager>::erase(const int tid, const K& key) {
         BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {&p_preds[0]->rqbundle,
                                                      nullptr};
         nodeptr ptrs[] = {p_victim->p_next[0], nullptr};
-        rqProvider->prepare_bundles(bundles, ptrs);
+        rqProvider->prepare_bundles(tid, bundles, ptrs);
         timestamp_t lin_time = rqProvider->linearize_update_at_write(
             tid, &p_victim->marked, (long long)1);
         rqProvider->finalize_bundles(bundles, lin_time);
@@ -431,15 +476,15 @@ V bundle_skiplist<K, V, RecManager>::erase(const int tid, const K& key) {
         }
 #endif
         ret = p_victim->val;
-        sl_node_unlock(p_victim);
+        sl_node_unlock(tid, p_victim);
       } else {
-        sl_node_unlock(p_victim);
+        sl_node_unlock(tid, p_victim);
       }
 
       // unlock mutexes
       for (i = 0; i <= highestLocked; i++) {
         if (i == 0 || p_preds[i] != p_preds[i - 1]) {
-          sl_node_unlock(p_preds[i]);
+          sl_node_unlock(tid, p_preds[i]);
         }
       }
 
@@ -464,6 +509,7 @@ int bundle_skiplist<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
   //    cout<<"rangeQuery(lo="<<lo<<" hi="<<hi<<")"<<endl;
   timestamp_t ts;
   long i = 0;
+  int restarts = 0;
   while (true) {
     int cnt = 0;
     recmgr->leaveQuiescentState(tid, true);
@@ -472,16 +518,22 @@ int bundle_skiplist<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
     nodeptr pred = p_head;
     nodeptr curr = nullptr;
 #ifdef BUNDLE_OPTIMIZE_RQS
-    for (int level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level--) {
+    for (int level = fingerStart(tid, lo, 0, pred); level >= 0; level--) {
       curr = pred->p_next[level];
       while (curr->key < lo) {
         pred = curr;
         curr = pred->p_next[level];
       }
+      fingerSet(tid, level, pred, curr->key);
     }
 #endif
     // Perform the traversal using the bundles.
     curr = pred->rqbundle.getPtrByTimestamp(ts);
+    if (curr == nullptr && restarts + 1 >= BUNDLE_RQ_MAX_RESTARTS) {
+      // Enter the range from the head rather than restart again.
+      ++restarts;
+      curr = p_head->rqbundle.getPtrByTimestamp(ts);
+    }
     while (curr != nullptr && curr->key <= hi) {
       if (curr->key >= lo) {
         cnt += getKeys(tid, curr, resultKeys + cnt, resultValues + cnt);
@@ -493,49 +545,346 @@ int bundle_skiplist<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
 
     // Traversal successful.
     if (curr != nullptr) {
+      rqProvider->count_restarts(tid, restarts);
       return cnt;
     }
+    ++restarts;
   }
 }
 
 template <typename K, typename V, class RecManager>
-void bundle_skiplist<K, V, RecManager>::cleanup(int tid) {
+template <typename Visitor>
+int bundle_skiplist<K, V, RecManager>::visitRange(const int tid, const K& lo,
+                                                  const K& hi, Visitor visit,
+                                                  const int limit) {
+  timestamp_t ts;
+  int cnt = 0;
+  int restarts = 0;
+  while (true) {
+    recmgr->leaveQuiescentState(tid, true);
+    ts = rqProvider->start_traversal(tid);
+    SOFTWARE_BARRIER;
+    nodeptr pred = p_head;
+    nodeptr curr = nullptr;
+#ifdef BUNDLE_OPTIMIZE_RQS
+    for (int level = fingerStart(tid, lo, 0, pred); level >= 0; level--) {
+      curr = pred->p_next[level];
+      while (curr->key < lo) {
+        pred = curr;
+        curr = pred->p_next[level];
+      }
+      fingerSet(tid, level, pred, curr->key);
+    }
+#endif
+    // Perform the traversal using the bundles. Only entering the range can
+    // fail, so nothing has been visited yet if the traversal restarts.
+    curr = pred->rqbundle.getPtrByTimestamp(ts);
+    if (curr == nullptr && restarts + 1 >= BUNDLE_RQ_MAX_RESTARTS) {
+      // Enter the range from the head rather than restart again.
+      ++restarts;
+      curr = p_head->rqbundle.getPtrByTimestamp(ts);
+    }
+    while (curr != nullptr && curr->key <= hi && cnt != limit) {
+      if (curr->key >= lo) {
+        ++cnt;
+        const K key = curr->key;
+        const V val = curr->val;
+        if (!visit(key, val)) {
+          break;
+        }
+      }
+      curr = curr->rqbundle.getPtrByTimestamp(ts);
+    }
+    rqProvider->end_traversal(tid);
+    recmgr->enterQuiescentState(tid);
+
+    // Traversal successful.
+    if (curr != nullptr) {
+      rqProvider->count_restarts(tid, restarts);
+      return cnt;
+    }
+    ++restarts;
+  }
+}
+
+template <typename K, typename V, class RecManager>
+template <typename Visitor>
+int bundle_skiplist<K, V, RecManager>::visitRanges(const int tid, const int n,
+                                                   const K* const los,
+                                                   const K* const his,
+                                                   Visitor visit) {
+  if (n <= 0) {
+    return 0;
+  }
+  int order[n];
+  for (int i = 0; i < n; ++i) {
+    order[i] = i;
+  }
+  std::sort(order, order + n,
+            [los](const int a, const int b) { return los[a] < los[b]; });
+
+  timestamp_t ts;
+  int restarts = 0;
+  while (true) {
+    int cnt = 0;
+    recmgr->leaveQuiescentState(tid, true);
+    ts = rqProvider->start_traversal(tid);
+    SOFTWARE_BARRIER;
+    // Node of the snapshot that precedes every range left.
+    nodeptr snap = p_head;
+#ifdef BUNDLE_OPTIMIZE_RQS
+    // Predecessors of the previous range at each level. Lower bounds never
+    // decrease, so they are valid starting points for the next range.
+    nodeptr fingers[SKIPLIST_MAX_LEVEL];
+    for (int level = 0; level < SKIPLIST_MAX_LEVEL; ++level) {
+      fingers[level] = p_head;
+    }
+#endif
+    int i = 0;
+    for (; i < n; ++i) {
+      const int r = order[i];
+      const K lo = los[r];
+      const K hi = his[r];
+      nodeptr curr;
+#ifdef BUNDLE_OPTIMIZE_RQS
+      nodeptr pred = p_head;
+      for (int level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level--) {
+        if (fingers[level]->key > pred->key) {
+          pred = fingers[level];
+        }
+        curr = pred->p_next[level];
+        while (curr->key < lo) {
+          pred = curr;
+          curr = pred->p_next[level];
+        }
+        fingers[level] = pred;
+      }
+      curr = pred->rqbundle.getPtrByTimestamp(ts);
+      if (curr != nullptr) {
+        if (pred->key > snap->key) {
+          snap = pred;
+        }
+      } else if (i == 0 && restarts + 1 < BUNDLE_RQ_MAX_RESTARTS) {
+        break;  // Nothing was visited yet, so simply try again.
+      } else {
+        // The predecessor is newer than the snapshot. Enter the range from
+        // the snapshot instead of visiting the previous ranges again, or, for
+        // the first range, instead of restarting again.
+        if (i == 0) {
+          ++restarts;
+        }
+        curr = snap->rqbundle.getPtrByTimestamp(ts);
+      }
+#else
+      curr = snap->rqbundle.getPtrByTimestamp(ts);
+#endif
+      while (curr != nullptr && curr->key <= hi) {
+        if (curr->key >= lo) {
+          ++cnt;
+          const K key = curr->key;
+          const V val = curr->val;
+          if (!visit(r, key, val)) {
+            break;
+          }
+        } else {
+          snap = curr;
+        }
+        curr = curr->rqbundle.getPtrByTimestamp(ts);
+      }
+    }
+    rqProvider->end_traversal(tid);
+    recmgr->enterQuiescentState(tid);
+
+    // Traversal successful.
+    if (i == n) {
+      rqProvider->count_restarts(tid, restarts);
+      return cnt;
+    }
+    ++restarts;
+  }
+}
+
+template <typename K, typename V, class RecManager>
+int bundle_skiplist<K, V, RecManager>::multiRangeQuery(
+    const int tid, const int n, const K* const los, const K* const his,
+    K* const resultKeys, V* const resultValues, int* const starts,
+    int* const counts) {
+  for (int i = 0; i < n; ++i) {
+    starts[i] = 0;
+    counts[i] = 0;
+  }
+  int cnt = 0;
+  return visitRanges(tid, n, los, his,
+                     [&](const int r, const K& key, const V& value) {
+                       if (counts[r]++ == 0) {
+                         starts[r] = cnt;
+                       }
+                       resultKeys[cnt] = key;
+                       resultValues[cnt++] = value;
+                       return true;
+                     });
+}
+
+template <typename K, typename V, class RecManager>
+bool bundle_skiplist<K, V, RecManager>::cleanup(int tid, K& cursor,
+                                                const K& last, int budget) {
   recmgr->leaveQuiescentState(tid);
   BUNDLE_INIT_CLEANUP(rqProvider);
-  BUNDLE_CLEAN_BUNDLE(p_head->rqbundle);
-  for (nodeptr curr = p_head->p_next[0]; curr->key != KEY_MAX;
-       curr = curr->p_next[0]) {
-    if (!curr->marked) {
-      BUNDLE_CLEAN_BUNDLE(curr->rqbundle);
+  // Use the upper levels to find the first node to clean.
+  nodeptr curr = p_head;
+  if (curr->key < cursor) {
+    for (int level = SKIPLIST_MAX_LEVEL - 1; level >= 0; --level) {
+      while (curr->p_next[level]->key != KEY_MAX &&
+             curr->p_next[level]->key < cursor) {
+        curr = curr->p_next[level];
+      }
+    }
+    curr = curr->p_next[0];
+  }
+  bool done = true;
+  for (; curr->key != KEY_MAX && curr->key <= last; curr = curr->p_next[0]) {
+    if (budget-- == 0) {
+      cursor = curr->key;
+      done = false;
+      break;
+    }
+    // Bundles of deleted nodes are retired along with the node, so the node
+    // must not be deleted while its bundle is cleaned. Busy nodes are skipped.
+    if (sl_node_trylock<K, V>(tid, curr)) {
+      if (!curr->marked) {
+        BUNDLE_CLEAN_BUNDLE(curr->rqbundle);
+      }
+      sl_node_unlock<K, V>(tid, curr);
     }
   }
   recmgr->enterQuiescentState(tid);
+  return done;
+}
+
+template <typename K, typename V, class RecManager>
+bool bundle_skiplist<K, V, RecManager>::getKeyBounds(int tid, K& lo, K& hi) {
+  recmgr->leaveQuiescentState(tid);
+  nodeptr curr = p_head->p_next[0];
+  const bool empty = (curr->key == KEY_MAX);
+  if (!empty) {
+    lo = curr->key;
+    curr = p_head;
+    for (int level = SKIPLIST_MAX_LEVEL - 1; level >= 0; --level) {
+      while (curr->p_next[level]->key != KEY_MAX) {
+        curr = curr->p_next[level];
+      }
+    }
+    hi = curr->key;
+  }
+  recmgr->enterQuiescentState(tid);
+  return !empty;
+}
+
+template <typename K, typename V, class RecManager>
+typename bundle_skiplist<K, V, RecManager>::BulkLoadPart
+bundle_skiplist<K, V, RecManager>::bulkLoadPart(const int tid, const K* keys,
+                                                const V* values, const int n) {
+  BulkLoadPart part;
+  for (int level = 0; level < SKIPLIST_MAX_LEVEL; ++level) {
+    part.first[level] = nullptr;
+    part.last[level] = nullptr;
+  }
+  for (int i = 0; i < n; ++i) {
+    const int topLevel = sl_randomLevel(tid, threadRNGs);
+    nodeptr p_node = allocateNode(tid);
+    initNode(tid, p_node, keys[i], values[i], topLevel);
+    p_node->fullyLinked = 1;
+    if (part.last[0] != nullptr) {
+      rqProvider->init_bundle(tid, &part.last[0]->rqbundle, p_node);
+    }
+    for (int level = 0; level <= topLevel; ++level) {
+      if (part.last[level] == nullptr) {
+        part.first[level] = p_node;
+      } else {
+        part.last[level]->p_next[level] = p_node;
+      }
+      part.last[level] = p_node;
+    }
+  }
+  return part;
+}
+
+template <typename K, typename V, class RecManager>
+void bundle_skiplist<K, V, RecManager>::bulkLoadFinish(const int tid,
+                                                       BulkLoadPart* parts,
+                                                       const int numParts) {
+  assert(p_head->p_next[0] == p_tail);
+  // Last node linked so far on each level, or null while it is still head.
+  nodeptr p_preds[SKIPLIST_MAX_LEVEL];
+  nodeptr p_first = nullptr;
+  for (int level = 0; level < SKIPLIST_MAX_LEVEL; ++level) {
+    p_preds[level] = nullptr;
+  }
+  for (int i = 0; i < numParts; ++i) {
+    for (int level = 0; level < SKIPLIST_MAX_LEVEL; ++level) {
+      nodeptr p_node = parts[i].first[level];
+      if (p_node == nullptr) continue;
+      if (p_preds[level] == nullptr) {
+        // Head is linked last, on level 0 as the linearization point.
+        if (level == 0) {
+          p_first = p_node;
+        } else {
+          p_head->p_next[level] = p_node;
+        }
+      } else {
+        p_preds[level]->p_next[level] = p_node;
+        if (level == 0) {
+          rqProvider->init_bundle(tid, &p_preds[0]->rqbundle, p_node);
+        }
+      }
+      p_preds[level] = parts[i].last[level];
+    }
+  }
+  if (p_first == nullptr) return;
+  for (int level = 0; level < SKIPLIST_MAX_LEVEL; ++level) {
+    if (p_preds[level] != nullptr) {
+      p_preds[level]->p_next[level] = p_tail;
+    }
+  }
+  rqProvider->init_bundle(tid, &p_preds[0]->rqbundle, p_tail);
+
+  // Link the loaded nodes in as a single insertion after head.
+  BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {&p_head->rqbundle, nullptr};
+  nodeptr ptrs[] = {p_first, nullptr};
+  rqProvider->prepare_bundles(tid, bundles, ptrs);
+  timestamp_t lin_time =
+      rqProvider->linearize_update_at_write(tid, &p_head->p_next[0], p_first);
+  rqProvider->finalize_bundles(bundles, lin_time);
 }
 
 template <typename K, typename V, class RecManager>
 bool bundle_skiplist<K, V, RecManager>::validateBundles(int tid) {
   bool valid = true;
+  for (nodeptr curr = p_head; curr->key != KEY_MAX; curr = curr->p_next[0]) {
+    if (!curr->rqbundle.validate()) {
+      std::cout << "Invalid bundle! [key=" << curr->key << "] "
+                << curr->rqbundle.dump(0) << std::flush;
+      valid = false;
+    }
 #ifdef BUNDLE_DEBUG
-  for (nodeptr curr = p_head->p_next[0]; curr->key != KEY_MAX;
-       curr = curr->p_next[0]) {
     timestamp_t ts;
-    nodeptr ptr = curr->rqbundle->first(ts);
+    nodeptr ptr = curr->rqbundle.first(ts);
     if (ptr != curr->p_next[0]) {
       std::cout << "Pointer mismatch! [key=" << curr->p_next[0]->key
                 << ",marked=" << curr->p_next[0]->marked << "] "
                 << curr->p_next[0] << " vs. [key=" << ptr->key
-                << ",marked=" << ptr->marked << "] " << curr->rqbundle->dump(0)
+                << ",marked=" << ptr->marked << "] " << curr->rqbundle.dump(0)
                 << std::flush;
       valid = false;
     }
 #ifdef BUNDLE_CLEANUP
-    if (curr->rqbundle->size() > 1) {
-      std::cout << curr->rqbundle->dump(0) << std::flush;
+    if (curr->rqbundle.size() > 1) {
+      std::cout << curr->rqbundle.dump(0) << std::flush;
       return false;
     }
 #endif
-  }
 #endif
+  }
   return valid;
 }
 
@@ -27,6 +27,9 @@ typedef struct rcu_node_t {
     //char p2[128-sizeof(time)- 2*sizeof(uint64_t)];
 } rcu_node;
 
+// Receives the registered id of the thread running it.
+typedef void (*rcu_callback)(const int tid, void *arg);
+
 namespace urcu {
 
 void init(const int numThreads);
@@ -37,6 +40,14 @@ void synchronize();
 void registerThread(int id);
 void unregisterThread();
 
+// Deferred callbacks. fn(tid, arg) runs after a grace period, on whichever thread
+// first notices that the grace period has elapsed, instead of the caller
+// waiting for it as in synchronize().
+void deferCall(rcu_callback fn, void *arg);
+void poll();     // runs the caller's callbacks whose grace period elapsed
+void pollAll();  // runs every thread's callbacks whose grace period elapsed
+void barrier();  // waits until every callback deferred by the caller has run
+
 }
 
 #endif /* URCU_H */
@@ -17,12 +17,54 @@
 #include "urcu.h"
 #include "tsc.h"
 
+// Number of callbacks a thread can defer while an older batch of its callbacks
+// is still waiting for its grace period.
+#ifndef URCU_BATCH_SIZE
+#define URCU_BATCH_SIZE 64
+#endif
+
+/**
+ * Deferred callbacks are collected in per-thread batches. A thread fills one
+ * batch while its other batch (if any) waits for a grace period. Once the
+ * waiting batch has run, the filled one is closed: a snapshot of every
+ * thread's counter is taken once for the whole batch and it starts waiting.
+ * A waiting batch runs once every thread has been quiescent since its
+ * snapshot.
+ *
+ * Callbacks may hold locks other threads wait for, and the thread that
+ * deferred them may stop calling into urcu at any time, so any thread can
+ * close and run any thread's batches. Every transition is a CAS on the state
+ * of the batch, which also keeps the owner from appending to a batch that is
+ * being closed.
+ */
+#define URCU_BATCH_FREE 0     // open (or empty), nobody is touching it
+#define URCU_BATCH_FILLING 1  // its owner is appending a callback
+#define URCU_BATCH_CLOSING 2  // a thread is taking its snapshot
+#define URCU_BATCH_WAITING 3  // closed, waiting for its grace period
+#define URCU_BATCH_RUNNING 4  // claimed by the thread running its callbacks
+
+typedef struct rcu_batch_t {
+    volatile int state;
+    volatile int size;
+    rcu_callback fns[URCU_BATCH_SIZE];
+    void* args[URCU_BATCH_SIZE];
+    unsigned long* snapshot; // counters when the batch was closed
+} rcu_batch;
+
+typedef struct rcu_deferred_t {
+    rcu_batch batches[2];
+    volatile int open; // index of the batch being filled
+    char padding[128];
+} rcu_deferred;
+
 namespace urcu {
 
 int threads;
 volatile char padding0[256];
 rcu_node** urcu_table;
 volatile char padding1[256];
+rcu_deferred* deferred_table;
+volatile char padding2[256];
 
 __thread long* times; 
 __thread int i; 
@@ -38,6 +80,16 @@ void init(const int numThreads) {
         result[i] = nnode;
     }
     urcu_table = result;
+    deferred_table = (rcu_deferred*) malloc(sizeof(rcu_deferred) * threads);
+    for (i = 0; i < threads; i++) {
+        for (int j = 0; j < 2; j++) {
+            rcu_batch* b = &deferred_table[i].batches[j];
+            b->state = URCU_BATCH_FREE;
+            b->size = 0;
+            b->snapshot = (unsigned long*) malloc(sizeof(unsigned long) * threads);
+        }
+        deferred_table[i].open = 0;
+    }
     printf("initializing URCU finished, node_size: %zd\n", sizeof (rcu_node));
     return;
 }
@@ -45,8 +97,11 @@ void init(const int numThreads) {
 void deinit(const int numThreads) {
     for (int i=0;i<numThreads;++i) {
         free(urcu_table[i]);
+        free(deferred_table[i].batches[0].snapshot);
+        free(deferred_table[i].batches[1].snapshot);
     }
     free(urcu_table);
+    free(deferred_table);
 }
 
 void registerThread(int id) {
@@ -125,6 +180,104 @@ void synchronize() {
 
 #endif  /* RCU_USE_TSC */
 
+/* Returns true if every thread has been quiescent since the batch closed. */
+static bool elapsed(rcu_batch* b) {
+    for (int k = 0; k < threads; k++) {
+        unsigned long t = urcu_table[k]->time;
+#ifdef RCU_USE_TSC
+        if (!(t & 1) && t <= b->snapshot[0]) return false;
+#else
+        if (b->snapshot[k] & 1) continue;
+        if (!(t & 1) && t <= b->snapshot[k]) return false;
+#endif
+    }
+    return true;
+}
+
+/* Closes the open batch of thread k if it is not empty and its other batch has run. */
+static void tryClose(const int k) {
+    rcu_deferred* d = &deferred_table[k];
+    const int open = d->open;
+    rcu_batch* b = &d->batches[open];
+    if (b->size == 0 || d->batches[1 - open].state != URCU_BATCH_FREE) return;
+    if (!__sync_bool_compare_and_swap(&b->state, URCU_BATCH_FREE, URCU_BATCH_CLOSING)) return;
+    /* b may have been closed, run and freed since we read open */
+    if (b->size == 0 || d->open != open || d->batches[1 - open].state != URCU_BATCH_FREE) {
+        b->state = URCU_BATCH_FREE;
+        return;
+    }
+    /* order the snapshot after the writes the callbacks depend on */
+    __sync_synchronize();
+#ifdef RCU_USE_TSC
+    b->snapshot[0] = read_tsc() << 1;
+#else
+    for (int j = 0; j < threads; j++) {
+        b->snapshot[j] = urcu_table[j]->time;
+    }
+#endif
+    d->open = 1 - open;
+    __sync_synchronize();
+    b->state = URCU_BATCH_WAITING;
+}
+
+/* Runs the batch if its grace period has elapsed and nobody else claimed it. */
+static void tryRun(rcu_batch* b) {
+    if (b->state != URCU_BATCH_WAITING || !elapsed(b)) return;
+    if (!__sync_bool_compare_and_swap(&b->state, URCU_BATCH_WAITING, URCU_BATCH_RUNNING)) return;
+    for (int j = 0; j < b->size; j++) {
+        b->fns[j](i, b->args[j]);
+    }
+    b->size = 0;
+    __sync_synchronize();
+    b->state = URCU_BATCH_FREE;
+}
+
+void poll() {
+    rcu_deferred* d = &deferred_table[i];
+    tryRun(&d->batches[0]);
+    tryRun(&d->batches[1]);
+    tryClose(i);
+}
+
+void pollAll() {
+    for (int k = 0; k < threads; k++) {
+        tryRun(&deferred_table[k].batches[0]);
+        tryRun(&deferred_table[k].batches[1]);
+        tryClose(k);
+    }
+}
+
+void deferCall(rcu_callback fn, void* arg) {
+    rcu_deferred* d = &deferred_table[i];
+    rcu_batch* b;
+    while (true) {
+        b = &d->batches[d->open];
+        if (b->size < URCU_BATCH_SIZE
+                && __sync_bool_compare_and_swap(&b->state, URCU_BATCH_FREE, URCU_BATCH_FILLING)) {
+            if (b == &d->batches[d->open]) break;
+            b->state = URCU_BATCH_FREE; /* closed and reopened meanwhile */
+            continue;
+        }
+        /* the batch is being closed, or both batches are full */
+        __asm__ __volatile__("pause;");
+        pollAll();
+    }
+    b->fns[b->size] = fn;
+    b->args[b->size] = arg;
+    b->size++;
+    __sync_synchronize();
+    b->state = URCU_BATCH_FREE;
+    tryClose(i);
+}
+
+void barrier() {
+    rcu_deferred* d = &deferred_table[i];
+    while (d->batches[0].size > 0 || d->batches[1].size > 0) {
+        __asm__ __volatile__("pause;");
+        pollAll();
+    }
+}
+
 };
 
 #endif /* URCU_IMPL_H */
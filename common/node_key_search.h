@@ -0,0 +1,162 @@
+/*
+ * File:   node_key_search.h
+ *
+ * Searches of the sorted keys of a node of the (a,b)-tree or B-slack tree
+ * (see bslack_reuse and bundle_bslack). Since the keys of a node are sorted,
+ * the index a search stops at is the number of keys that satisfy its test,
+ * so it can be found by comparing every key at once and counting the keys
+ * that pass.
+ *
+ * NodeKeySearch<K, Compare> compares the keys one at a time with Compare,
+ * stopping at the first key that fails the test. For 4 or 8 byte integral
+ * keys ordered by std::less, and when compiled with AVX2 or AVX-512 enabled
+ * (e.g., -mavx2, -mavx512f or -march=native), it instead compares a vector of
+ * keys per instruction and counts the lanes that pass. For a node of 16 keys
+ * of 8 bytes, this takes 2 (AVX-512) or 4 (AVX2) comparisons instead of up to
+ * 16 unpredictable branches. Define NODE_KEY_SEARCH_SCALAR to always use the
+ * generic search.
+ */
+
+#ifndef NODE_KEY_SEARCH_H
+#define NODE_KEY_SEARCH_H
+
+#include <functional>
+#include <type_traits>
+
+#if !defined NODE_KEY_SEARCH_SCALAR && \
+    (defined __AVX512F__ || defined __AVX2__)
+#define NODE_KEY_SEARCH_SIMD
+#include <immintrin.h>
+#endif
+
+template <typename K, class Compare, bool Vectorize =
+#ifdef NODE_KEY_SEARCH_SIMD
+              std::is_integral<K>::value &&
+              std::is_same<Compare, std::less<K>>::value &&
+              (sizeof(K) == 4 || sizeof(K) == 8)
+#else
+              false
+#endif
+          >
+struct NodeKeySearch {
+  // Returns the number of keys in keys[0..n) that are not greater than key,
+  // which is the index of the child whose subtree can contain key.
+  static inline int countNotGreater(const K *const keys, const int n,
+                                    const K &key, Compare cmp) {
+    int i = 0;
+    while (i < n && !cmp(key, keys[i])) ++i;
+    return i;
+  }
+  // Returns the number of keys in keys[0..n) that are less than key, which is
+  // the index at which key is or would be in a leaf.
+  static inline int countLess(const K *const keys, const int n, const K &key,
+                              Compare cmp) {
+    int i = 0;
+    while (i < n && cmp(keys[i], key)) ++i;
+    return i;
+  }
+};
+
+#ifdef NODE_KEY_SEARCH_SIMD
+template <typename K, class Compare>
+struct NodeKeySearch<K, Compare, true> {
+  static inline int countNotGreater(const K *const keys, const int n,
+                                    const K &key, Compare) {
+    return count<false>(keys, n, key);
+  }
+  static inline int countLess(const K *const keys, const int n, const K &key,
+                              Compare) {
+    return count<true>(keys, n, key);
+  }
+
+ private:
+  static const bool SIGNED = std::is_signed<K>::value;
+
+  // Counts the keys in keys[0..n) that are less than key (if Less) or not
+  // greater than key (otherwise). Lanes at or past n are neither loaded nor
+  // counted, so this never reads past the last key of a node.
+  template <bool Less>
+  static inline int count(const K *const keys, const int n, const K &key) {
+    return sizeof(K) == 8 ? count64<Less>((const long long *)keys, n, key)
+                          : count32<Less>((const int *)keys, n, key);
+  }
+
+#ifdef __AVX512F__
+  template <bool Less>
+  static inline int count64(const long long *const keys, const int n,
+                            const K &key) {
+    const __m512i k = _mm512_set1_epi64((long long)key);
+    int result = 0;
+    for (int i = 0; i < n; i += 8) {
+      const __mmask8 live = (n - i >= 8) ? 0xff : (1u << (n - i)) - 1;
+      const __m512i v = _mm512_maskz_loadu_epi64(live, keys + i);
+      const __mmask8 pass =
+          Less ? (SIGNED ? _mm512_mask_cmplt_epi64_mask(live, v, k)
+                         : _mm512_mask_cmplt_epu64_mask(live, v, k))
+               : (SIGNED ? _mm512_mask_cmple_epi64_mask(live, v, k)
+                         : _mm512_mask_cmple_epu64_mask(live, v, k));
+      result += __builtin_popcount(pass);
+    }
+    return result;
+  }
+  template <bool Less>
+  static inline int count32(const int *const keys, const int n, const K &key) {
+    const __m512i k = _mm512_set1_epi32((int)key);
+    int result = 0;
+    for (int i = 0; i < n; i += 16) {
+      const __mmask16 live = (n - i >= 16) ? 0xffff : (1u << (n - i)) - 1;
+      const __m512i v = _mm512_maskz_loadu_epi32(live, keys + i);
+      const __mmask16 pass =
+          Less ? (SIGNED ? _mm512_mask_cmplt_epi32_mask(live, v, k)
+                         : _mm512_mask_cmplt_epu32_mask(live, v, k))
+               : (SIGNED ? _mm512_mask_cmple_epi32_mask(live, v, k)
+                         : _mm512_mask_cmple_epu32_mask(live, v, k));
+      result += __builtin_popcount(pass);
+    }
+    return result;
+  }
+#else
+  // AVX2 only compares signed integers for greater than. Unsigned keys are
+  // compared as signed ones after flipping their sign bits, and v < k and
+  // v <= k are computed as k > v and !(v > k).
+  template <bool Less>
+  static inline int count64(const long long *const keys, const int n,
+                            const K &key) {
+    const __m256i flip = _mm256_set1_epi64x(SIGNED ? 0 : (1ULL << 63));
+    const __m256i k =
+        _mm256_xor_si256(_mm256_set1_epi64x((long long)key), flip);
+    const __m256i lanes = _mm256_setr_epi64x(0, 1, 2, 3);
+    int result = 0;
+    for (int i = 0; i < n; i += 4) {
+      const __m256i live = _mm256_cmpgt_epi64(_mm256_set1_epi64x(n - i), lanes);
+      const __m256i v =
+          _mm256_xor_si256(_mm256_maskload_epi64(keys + i, live), flip);
+      const __m256i pass =
+          Less ? _mm256_and_si256(live, _mm256_cmpgt_epi64(k, v))
+               : _mm256_andnot_si256(_mm256_cmpgt_epi64(v, k), live);
+      result += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(pass)));
+    }
+    return result;
+  }
+  template <bool Less>
+  static inline int count32(const int *const keys, const int n, const K &key) {
+    const __m256i flip = _mm256_set1_epi32(SIGNED ? 0 : (int)(1u << 31));
+    const __m256i k = _mm256_xor_si256(_mm256_set1_epi32((int)key), flip);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    int result = 0;
+    for (int i = 0; i < n; i += 8) {
+      const __m256i live = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - i), lanes);
+      const __m256i v =
+          _mm256_xor_si256(_mm256_maskload_epi32(keys + i, live), flip);
+      const __m256i pass =
+          Less ? _mm256_and_si256(live, _mm256_cmpgt_epi32(k, v))
+               : _mm256_andnot_si256(_mm256_cmpgt_epi32(v, k), live);
+      result += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(pass)));
+    }
+    return result;
+  }
+#endif
+};
+#endif
+
+#endif /* NODE_KEY_SEARCH_H */
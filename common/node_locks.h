@@ -0,0 +1,258 @@
+/*
+ * File:   node_locks.h
+ *
+ * Locks embedded in the nodes of the lock-based lazy list and skip-list
+ * (bundle_lazylist and bundle_skiplist_lock). Each data structure picks the
+ * lock of its nodes at compile time, with LAZYLIST_NODE_LOCK and
+ * SKIPLIST_NODE_LOCK respectively, among:
+ *
+ *   TTASNodeLock     test-and-test-and-set lock that spins on reads of the
+ *                    lock word until it is free (the default).
+ *   BackoffNodeLock  test-and-test-and-set lock whose waiters pause for an
+ *                    exponentially growing number of iterations, between
+ *                    NODE_LOCK_BACKOFF_MIN and NODE_LOCK_BACKOFF_MAX, after
+ *                    every failed attempt. This cuts the traffic on the cache
+ *                    line of a hot node.
+ *   TicketNodeLock   FIFO ticket lock whose waiters pause in proportion to
+ *                    the number of threads ahead of them, so that a hot node
+ *                    is handed to its writers in order instead of to
+ *                    whichever wins the race for it.
+ *   CohortNodeLock   NUMA-aware cohort lock (Dice et al.) built like
+ *                    PTL_TKT_Lock in cohort_locks.h. A thread first takes a
+ *                    ticket lock of its NUMA node, then a global ticket lock.
+ *                    A holder that sees waiters on its own NUMA node passes
+ *                    both locks to them, up to NODE_LOCK_COHORT_MAX_HANDOFFS
+ *                    times in a row, so the node's cache line stays on one
+ *                    socket. PTL_TKT_Lock allocates its per-NUMA node state
+ *                    in its constructor. Record managers do not run
+ *                    constructors, so this lock holds that state inline,
+ *                    for up to NODE_LOCK_NUMA_NODES NUMA nodes.
+ *
+ * Every lock has init(), acquire(), tryAcquire() and release(), and must be
+ * initialized with init() whenever the node that holds it is (re)allocated.
+ *
+ * Data structures embed a NodeLock<Lock>, which adds statistics to Lock. If
+ * NODE_LOCK_STATS is defined and GSTATS are in use, it appends to the GSTATS
+ * node_lock_wait_cycles and node_lock_hold_cycles the cycles each
+ * acquisition waited for the lock and then held it (see microbench/globals.h).
+ * Measuring them costs two reads of the clock per acquisition, so they are off
+ * by default.
+ */
+
+#ifndef NODE_LOCKS_H
+#define NODE_LOCKS_H
+
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined NODE_LOCK_STATS && defined __HANDLE_STATS
+#include "server_clock.h"
+#define NODE_LOCK_RECORD_STATS
+#endif
+
+#ifndef NODE_LOCK_BACKOFF_MIN
+#define NODE_LOCK_BACKOFF_MIN 4
+#endif
+#ifndef NODE_LOCK_BACKOFF_MAX
+#define NODE_LOCK_BACKOFF_MAX 1024
+#endif
+// Pause iterations per thread ahead of a waiter of a ticket lock.
+#ifndef NODE_LOCK_TICKET_BACKOFF
+#define NODE_LOCK_TICKET_BACKOFF 16
+#endif
+#ifndef NODE_LOCK_NUMA_NODES
+#define NODE_LOCK_NUMA_NODES 2
+#endif
+// Same bound as MAX_LOCAL_HANDOFFS_BEFORE_RELEASE_TOP in cohort_locks.h.
+#ifndef NODE_LOCK_COHORT_MAX_HANDOFFS
+#define NODE_LOCK_COHORT_MAX_HANDOFFS 64
+#endif
+
+#define NODE_LOCK_PAUSE asm volatile("pause\n" ::: "memory")
+
+// Returns the NUMA node of the calling thread, looked up on its first call
+// only (threads are expected to be pinned).
+inline int node_lock_numa_node() {
+  static __thread int numaNode = -1;
+  if (numaNode < 0) {
+    unsigned cpu, node;
+    numaNode =
+        (syscall(SYS_getcpu, &cpu, &node, NULL) == 0) ? (int)node : 0;
+  }
+  return numaNode;
+}
+
+class TTASNodeLock {
+  volatile long word;
+
+ public:
+  inline void init() { word = 0; }
+  inline bool tryAcquire() {
+    return word == 0 && __sync_bool_compare_and_swap(&word, 0, 1);
+  }
+  inline void acquire() {
+    while (!tryAcquire()) {
+      while (word) NODE_LOCK_PAUSE;
+    }
+  }
+  inline void release() {
+    asm volatile("" ::: "memory");
+    word = 0;
+  }
+};
+
+class BackoffNodeLock {
+  volatile long word;
+
+ public:
+  inline void init() { word = 0; }
+  inline bool tryAcquire() {
+    return word == 0 && __sync_bool_compare_and_swap(&word, 0, 1);
+  }
+  inline void acquire() {
+    int delay = NODE_LOCK_BACKOFF_MIN;
+    while (!tryAcquire()) {
+      for (int i = 0; i < delay; ++i) NODE_LOCK_PAUSE;
+      if (delay < NODE_LOCK_BACKOFF_MAX) delay *= 2;
+    }
+  }
+  inline void release() {
+    asm volatile("" ::: "memory");
+    word = 0;
+  }
+};
+
+class TicketNodeLock {
+  // next is the ticket of the next thread to arrive, and owner the ticket of
+  // the thread holding (or next to hold) the lock. The lock is free if they
+  // are equal. word lets tryAcquire compare both in one CAS.
+  union {
+    volatile uint64_t word;
+    struct {
+      volatile uint32_t next;
+      volatile uint32_t owner;
+    } t;
+  };
+
+ public:
+  inline void init() { word = 0; }
+  inline bool tryAcquire() {
+    const uint64_t w = word;
+    const uint32_t next = (uint32_t)w;
+    const uint32_t owner = (uint32_t)(w >> 32);
+    if (next != owner) return false;
+    const uint64_t taken = (w & 0xffffffff00000000ULL) | (uint32_t)(next + 1);
+    return __sync_bool_compare_and_swap(&word, w, taken);
+  }
+  inline void acquire() {
+    const uint32_t ticket = __sync_fetch_and_add(&t.next, 1);
+    while (true) {
+      const uint32_t ahead = ticket - t.owner;
+      if (ahead == 0) break;
+      for (uint32_t i = 0; i < ahead * NODE_LOCK_TICKET_BACKOFF; ++i) {
+        NODE_LOCK_PAUSE;
+      }
+    }
+    asm volatile("" ::: "memory");
+  }
+  inline void release() {
+    asm volatile("" ::: "memory");
+    t.owner = t.owner + 1;
+  }
+  // Returns true if threads other than the holder are waiting for the lock.
+  inline bool hasWaiters() { return (uint32_t)(t.next - t.owner) > 1; }
+};
+
+class CohortNodeLock {
+  TicketNodeLock global;
+  struct {
+    TicketNodeLock lock;
+    // Set by a holder that passed the global lock along with this one.
+    volatile int passedGlobal;
+    int handoffs;
+  } local[NODE_LOCK_NUMA_NODES];
+  // NUMA node of the holder, whose local lock it must release.
+  volatile int holder;
+
+ public:
+  inline void init() {
+    global.init();
+    for (int i = 0; i < NODE_LOCK_NUMA_NODES; ++i) {
+      local[i].lock.init();
+      local[i].passedGlobal = 0;
+      local[i].handoffs = 0;
+    }
+    holder = 0;
+  }
+  inline bool tryAcquire() {
+    const int node = node_lock_numa_node() % NODE_LOCK_NUMA_NODES;
+    // If the local lock is free, no holder can have passed it the global lock.
+    if (!local[node].lock.tryAcquire()) return false;
+    if (!global.tryAcquire()) {
+      local[node].lock.release();
+      return false;
+    }
+    holder = node;
+    return true;
+  }
+  inline void acquire() {
+    const int node = node_lock_numa_node() % NODE_LOCK_NUMA_NODES;
+    local[node].lock.acquire();
+    if (local[node].passedGlobal) {
+      local[node].passedGlobal = 0;
+    } else {
+      global.acquire();
+    }
+    holder = node;
+  }
+  inline void release() {
+    const int node = holder;
+    if (local[node].lock.hasWaiters() &&
+        ++local[node].handoffs < NODE_LOCK_COHORT_MAX_HANDOFFS) {
+      local[node].passedGlobal = 1;
+      local[node].lock.release();
+      return;
+    }
+    local[node].handoffs = 0;
+    global.release();
+    local[node].lock.release();
+  }
+};
+
+template <class Lock>
+class NodeLock {
+  Lock lock;
+#ifdef NODE_LOCK_RECORD_STATS
+  uint64_t acquiredAt;
+#endif
+
+ public:
+  inline void init() { lock.init(); }
+  inline bool tryAcquire(const int tid) {
+    if (!lock.tryAcquire()) return false;
+#ifdef NODE_LOCK_RECORD_STATS
+    acquiredAt = get_server_clock();
+    GSTATS_APPEND(tid, node_lock_wait_cycles, 0);
+#endif
+    return true;
+  }
+  inline void acquire(const int tid) {
+#ifdef NODE_LOCK_RECORD_STATS
+    const uint64_t start = get_server_clock();
+    lock.acquire();
+    acquiredAt = get_server_clock();
+    GSTATS_APPEND(tid, node_lock_wait_cycles, acquiredAt - start);
+#else
+    lock.acquire();
+#endif
+  }
+  inline void release(const int tid) {
+#ifdef NODE_LOCK_RECORD_STATS
+    GSTATS_APPEND(tid, node_lock_hold_cycles, get_server_clock() - acquiredAt);
+#endif
+    lock.release();
+  }
+};
+
+#endif /* NODE_LOCKS_H */
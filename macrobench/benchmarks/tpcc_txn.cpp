@@ -651,15 +651,20 @@ RC tpcc_txn_man::run_delivery(tpcc_query *query) {
     key_low = neworderKey(query->w_id, d_id, 2100);
 #endif
     key_high = neworderKey(query->w_id, d_id, o_id);
-    uint64_t resultKeys[key_high - key_low + 1];
-    itemid_t *resultValues[key_high - key_low + 1];
-    int numResults =
-        index_range_query(_wl->i_neworder, key_low, key_high, resultKeys,
-                          resultValues, wh_to_part(query->w_id), true);
+    // Only the oldest new order is needed, so the scan stops at its first key.
+    // Every index runs this same scan (see index_range_scan), so the lookup
+    // and its range query statistics mean the same for all of them.
+    item = NULL;
+    int numResults = index_range_scan(
+        _wl->i_neworder, key_low, key_high,
+        [&item](const idx_key_t &key, itemid_t *const &value) {
+          item = value;
+          return false;
+        },
+        -1, wh_to_part(query->w_id), true);
     if (numResults == 0) {
       continue;  // Maybe there is no new order to deliver.
     }
-    item = resultValues[0];
     row_t *r_no = (row_t *)item->location;
     row_t *r_no_local = get_row(r_no, RD);
     if (r_no == NULL) {
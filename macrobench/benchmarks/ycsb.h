@@ -29,6 +29,9 @@ private:
     //  For parallel initialization
     static int next_tid;
     uint64_t* perm;
+    //  For bulk loading the index once all rows exist (NULL otherwise)
+    idx_key_t* bulk_keys;
+    itemid_t** bulk_items;
 };
 
 class ycsb_txn_man : public txn_man {
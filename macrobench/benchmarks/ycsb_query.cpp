@@ -94,13 +94,16 @@ void ycsb_query::gen_requests(uint64_t thd_id, workload * h_wl) {
         double r;
         drand48_r(&_query_thd->buffer, &r);
         ycsb_request * req = &requests[rid];
-        if (r<g_read_perc) {
+        // a fraction g_scan_perc of the requests are scans. the others are
+        // split between reads and writes in proportion to g_read_perc and
+        // g_write_perc.
+        if (r<g_scan_perc) {
+            req->rtype = SCAN;
+            req->scan_len = g_scan_len;
+        } else if ((r-g_scan_perc)*(g_read_perc+g_write_perc)<g_read_perc*(1-g_scan_perc)) {
             req->rtype = RD;
-        } else if (r>=g_read_perc&&r<=g_write_perc+g_read_perc) {
-            req->rtype = WR;
         } else {
-            req->rtype = SCAN;
-            req->scan_len = SCAN_LEN;
+            req->rtype = WR;
         }
 
         // the request will access part_id.
@@ -115,6 +118,9 @@ void ycsb_query::gen_requests(uint64_t thd_id, workload * h_wl) {
         int64_t rint64;
         lrand48_r(&_query_thd->buffer, &rint64);
         req->value = rint64%(1<<8);
+        // Make sure the transaction does not access more rows than it can track
+        if (access_cnt+(req->rtype==SCAN ? req->scan_len : 1)>MAX_ROW_PER_TXN)
+            continue;
         // Make sure a single row is not accessed twice
         if (req->rtype==RD||req->rtype==WR) {
             if (all_keys.find(req->key)==all_keys.end()) {
@@ -133,7 +139,7 @@ void ycsb_query::gen_requests(uint64_t thd_id, workload * h_wl) {
             else {
                 for (UInt32 i = 0; i<req->scan_len; i++)
                     all_keys.insert((row_id+i)*g_part_cnt+part_id);
-                access_cnt += SCAN_LEN;
+                access_cnt += req->scan_len;
             }
         }
         rid++;
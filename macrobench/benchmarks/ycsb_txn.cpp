@@ -33,8 +33,33 @@ RC ycsb_txn_man::run_txn(base_query * query) {
         int part_id = wl->key_to_part(key);
         bool finish_req = false;
         UInt32 iteration = 0;
+#ifdef INDEX_HAS_RQ
+        // a scan reads the rows of its partition at keys key, key+g_part_cnt,
+        // key+2*g_part_cnt, ... (see ycsb_query::gen_requests) with a single
+        // range query, and then visits them in order.
+        UInt32 scan_cnt = 0;
+        uint64_t scan_high = (req->rtype==SCAN ? key+(uint64_t) (req->scan_len-1)*g_part_cnt : key);
+        idx_key_t scan_keys[scan_high-key+1];
+        itemid_t * scan_items[scan_high-key+1];
+        if (req->rtype==SCAN) {
+            int cnt = index_range_query(_wl->the_index, key, scan_high, scan_keys, scan_items, part_id, true);
+            for (int i = 0; i<cnt; i++) {
+                if ((scan_keys[i]-key)%g_part_cnt==0)
+                    scan_items[scan_cnt++] = scan_items[i];
+            }
+            if (scan_cnt==0) {
+                cout<<"scan is empty, key is "<<key<<endl;
+            }
+            assert(scan_cnt>0);
+        }
+#endif
         while (!finish_req) {
             if (iteration==0) {
+#ifdef INDEX_HAS_RQ
+                if (req->rtype==SCAN) {
+                    m_item = scan_items[0];
+                } else
+#endif
                 m_item = index_read(_wl->the_index, key, part_id);
                 if (m_item==NULL) {
                     cout<<"item in null, key is "<<key<<endl;
@@ -47,6 +72,10 @@ RC ycsb_txn_man::run_txn(base_query * query) {
                 if (m_item==NULL)
                     break;
             }
+#elif defined INDEX_HAS_RQ
+            else {
+                m_item = scan_items[iteration];
+            }
 #endif
             row_t * row = ((row_t *) m_item->location);
             row_t * row_local;
@@ -81,6 +110,10 @@ RC ycsb_txn_man::run_txn(base_query * query) {
             iteration++;
             if (req->rtype==RD||req->rtype==WR||iteration==req->scan_len)
                 finish_req = true;
+#ifdef INDEX_HAS_RQ
+            if (req->rtype==SCAN&&iteration==scan_cnt)
+                finish_req = true;
+#endif
         }
     }
     rc = RCOK;
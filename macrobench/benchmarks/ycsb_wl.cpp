@@ -120,6 +120,19 @@ void ycsb_wl::init_table_parallel() {
     perm = (uint64_t*) malloc(sizeof (uint64_t)*g_synth_table_size);
     init_permutation(perm, g_synth_table_size);
 
+    bulk_keys = NULL;
+    bulk_items = NULL;
+    if (g_bulk_load) {
+#ifdef INDEX_HAS_BULK_LOAD
+        // the keys are a permutation of 1..g_synth_table_size, so the slices
+        // fill these arrays in increasing order of key
+        bulk_keys = new idx_key_t[g_synth_table_size];
+        bulk_items = new itemid_t*[g_synth_table_size];
+#else
+        printf("NOTICE: this index cannot be bulk loaded, so keys are inserted one at a time\n");
+#endif
+    }
+
     enable_thread_mem_pool = true;
     pthread_t p_thds[g_init_parallelism /*- 1*/];
     RLU_INIT(RLU_TYPE_FINE_GRAINED, 1);
@@ -134,6 +147,17 @@ void ycsb_wl::init_table_parallel() {
             exit(-1);
         }
     }
+    if (bulk_items!=NULL) {
+        uint64_t start = get_sys_clock();
+        RC rc = the_index->index_bulk_load(bulk_keys, bulk_items, g_synth_table_size);
+        assert(rc==RCOK);
+        printf("[YCSB] Index \"MAIN_INDEX\" bulk loaded in %.3fs.\n",
+                (get_sys_clock()-start)/1e9);
+        delete[] bulk_keys;
+        delete[] bulk_items;
+        bulk_keys = NULL;
+        bulk_items = NULL;
+    }
     RLU_FINISH();
     enable_thread_mem_pool = false;
     mem_allocator.unregister();
@@ -189,6 +213,11 @@ void * ycsb_wl::init_table_slice() {
         m_item->valid = true;
         uint64_t idx_key = primary_key;
 
+        if (bulk_items!=NULL) {
+            bulk_keys[key-1] = idx_key;
+            bulk_items[key-1] = m_item;
+            continue;
+        }
         rc = the_index->index_insert(idx_key, m_item, part_id);
         assert(rc==RCOK);
     }
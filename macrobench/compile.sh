@@ -8,6 +8,7 @@
 
 workloads="TPCC"
 modes="withupdates"
+#modes+=" snapshot"
 
 # note: HASH "fakes" its range queries, so it is not quite fair to compare with the other algorithms.
 #       nevertheless, it is included, since it was the default index in DBx.
@@ -15,16 +16,24 @@ modes="withupdates"
 
 #algs="HASH"
 #algs+=" BST_RQ_LOCKFREE BST_RQ_RWLOCK BST_RQ_HTM_RWLOCK BST_RQ_UNSAFE"
+algs+=" BST_RQ_BUNDLE BST_RQ_VCAS"
 algs+=" CITRUS_RQ_LOCKFREE CITRUS_RQ_RWLOCK" #CITRUS_RQ_HTM_RWLOCK CITRUS_RQ_UNSAFE"
 algs+=" CITRUS_RQ_RLU" 
 algs+=" CITRUS_RQ_BUNDLE"
 algs+=" CITRUS_RQ_UNSAFE"
+algs+=" CITRUS_RQ_VCAS"
+algs+=" ABTREE_RQ_BUNDLE BSLACK_RQ_BUNDLE"
 #algs+=" ABTREE_RQ_LOCKFREE ABTREE_RQ_RWLOCK ABTREE_RQ_HTM_RWLOCK ABTREE_RQ_UNSAFE"
 #algs+=" BSLACK_RQ_LOCKFREE BSLACK_RQ_RWLOCK BSLACK_RQ_HTM_RWLOCK BSLACK_RQ_UNSAFE"
 algs+=" SKIPLISTLOCK_RQ_LOCKFREE SKIPLISTLOCK_RQ_RWLOCK" # SKIPLISTLOCK_RQ_HTM_RWLOCK SKIPLISTLOCK_RQ_UNSAFE"
 algs+=" SKIPLISTLOCK_RQ_BUNDLE"
 algs+=" SKIPLISTLOCK_RQ_UNSAFE"
+algs+=" SKIPLISTLOCK_RQ_VCAS"
+algs+=" LFSKIPLIST_RQ_VCAS"
 #algs+=" SKIPLISTLOCK_RQ_SNAPCOLLECTOR"
+# note: the lazy list answers every operation in linear time, so it only suits small tables.
+algs+=" LAZYLIST_RQ_BUNDLE"
+algs+=" MVCC_VBR_SKIPLIST MVCC_VBR_TREE"
 
 make_workload_dict() {
     # skip the readonly variant of the YCSB workload
@@ -34,6 +43,8 @@ make_workload_dict() {
     # compile the given workload, algorithm and mode
     ro=""
     if [ "$3" == "readonly" ]; then ro="readonly=-DREAD_ONLY" ; fi
+    # snapshot-isolated transactions (only meaningful for *_RQ_BUNDLE)
+    if [ "$3" == "snapshot" ]; then ro="snapshot=1" ; fi
     make -j clean workload=$1 dict=$2 $ro
     make -j workload=$1 dict=$2 $ro &> compiling.$1.$2.$3.out
     if [ $? -ne 0 ]; then
@@ -49,8 +49,15 @@
 // WAIT_DIE, NO_WAIT, DL_DETECT, TIMESTAMP, MVCC, HEKATON, HSTORE, OCC, VLL,
 // TICTOC, SILO
 // TODO TIMESTAMP does not work at this moment
+// SNAPSHOT_TXNS (make snapshot=1) runs HEKATON at snapshot isolation, taking
+// transaction timestamps from the clock of the bundled indexes (TS_BUNDLE).
+#ifdef SNAPSHOT_TXNS
+#define CC_ALG HEKATON
+#define ISOLATION_LEVEL SNAPSHOT
+#else
 #define CC_ALG NO_WAIT
 #define ISOLATION_LEVEL SERIALIZABLE
+#endif
 
 // all transactions acquire tuples according to the primary key order.
 #define KEY_ORDER false
@@ -78,7 +85,11 @@
 #define TIMEOUT 1000000  // 1ms
 // [TIMESTAMP]
 #define TS_TWR false
+#ifdef SNAPSHOT_TXNS
+#define TS_ALLOC TS_BUNDLE
+#else
 #define TS_ALLOC TS_CAS
+#endif
 #define TS_BATCH_ALLOC false
 #define TS_BATCH_NUM 1
 // [MVCC]
@@ -243,15 +254,19 @@ extern TestCases g_test_case;
 #define IDX_BST_RQ_RWLOCK 101
 #define IDX_BST_RQ_HTM_RWLOCK 102
 #define IDX_BST_RQ_UNSAFE 103
+#define IDX_BST_RQ_BUNDLE 104
+#define IDX_BST_RQ_VCAS 105
 #define IDX_CITRUS_RQ_LOCKFREE 110
 #define IDX_CITRUS_RQ_RWLOCK 111
 #define IDX_CITRUS_RQ_HTM_RWLOCK 112
 #define IDX_CITRUS_RQ_UNSAFE 113
+#define IDX_CITRUS_RQ_VCAS 114
 #define IDX_CITRUS_RQ_RLU 120
 #define IDX_ABTREE_RQ_LOCKFREE 130
 #define IDX_ABTREE_RQ_RWLOCK 131
 #define IDX_ABTREE_RQ_HTM_RWLOCK 132
 #define IDX_ABTREE_RQ_UNSAFE 133
+#define IDX_ABTREE_RQ_BUNDLE 134
 #define IDX_SKIPLISTLOCK_RQ_LOCKFREE 140
 #define IDX_SKIPLISTLOCK_RQ_RWLOCK 141
 #define IDX_SKIPLISTLOCK_RQ_HTM_RWLOCK 142
@@ -259,10 +274,16 @@ extern TestCases g_test_case;
 #define IDX_SKIPLISTLOCK_RQ_SNAPCOLLECTOR 144
 #define IDX_SKIPLISTLOCK_RQ_BUNDLE 145
 #define IDX_CITRUS_RQ_BUNDLE 146
+#define IDX_SKIPLISTLOCK_RQ_VCAS 147
 #define IDX_BSLACK_RQ_LOCKFREE 150
 #define IDX_BSLACK_RQ_RWLOCK 151
 #define IDX_BSLACK_RQ_HTM_RWLOCK 152
 #define IDX_BSLACK_RQ_UNSAFE 153
+#define IDX_BSLACK_RQ_BUNDLE 154
+#define IDX_LFSKIPLIST_RQ_VCAS 160
+#define IDX_LAZYLIST_RQ_BUNDLE 170
+#define IDX_MVCC_VBR_SKIPLIST 180
+#define IDX_MVCC_VBR_TREE 181
 // WORKLOAD
 #define YCSB 1
 #define TPCC 2
@@ -288,5 +309,16 @@ extern TestCases g_test_case;
 #define TS_CAS 2
 #define TS_HW 3
 #define TS_CLOCK 4
+// Transactions start at a snapshot of the bundled indexes and commit at the
+// timestamp of a bundle update, so index range queries and row versions read
+// by a transaction come from the same snapshot.
+#define TS_BUNDLE 5
+
+#if TS_ALLOC == TS_BUNDLE
+#if CC_ALG != HEKATON
+#error TS_BUNDLE requires HEKATON, which allows transactions to share timestamps
+#endif
+#define BUNDLE_SHARED_TIMESTAMPS
+#endif
 
 #endif
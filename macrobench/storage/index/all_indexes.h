@@ -35,6 +35,16 @@
       (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_SNAPCOLLECTOR) || \
       (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_BUNDLE) || \
       (INDEX_STRUCT == IDX_CITRUS_RQ_BUNDLE) || \
+      (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_VCAS) || \
+      (INDEX_STRUCT == IDX_BST_RQ_BUNDLE) || \
+      (INDEX_STRUCT == IDX_ABTREE_RQ_BUNDLE) || \
+      (INDEX_STRUCT == IDX_BSLACK_RQ_BUNDLE) || \
+      (INDEX_STRUCT == IDX_BST_RQ_VCAS) || \
+      (INDEX_STRUCT == IDX_CITRUS_RQ_VCAS) || \
+      (INDEX_STRUCT == IDX_LFSKIPLIST_RQ_VCAS) || \
+      (INDEX_STRUCT == IDX_LAZYLIST_RQ_BUNDLE) || \
+      (INDEX_STRUCT == IDX_MVCC_VBR_SKIPLIST) || \
+      (INDEX_STRUCT == IDX_MVCC_VBR_TREE) || \
       (INDEX_STRUCT == IDX_CITRUS_RQ_UNSAFE)
 #include "index_with_rq.h"
 #elif (INDEX_STRUCT == IDX_BTREE)
@@ -102,6 +102,18 @@ class index_base {
   virtual RC index_insert(KEY_TYPE key, VALUE_TYPE item, int part_id = -1) = 0;
   virtual RC index_read(KEY_TYPE key, VALUE_TYPE *item, int part_id = -1,
                         int thd_id = 0) = 0;
+  // builds the index from the n sorted, distinct keys[i] and their items[i].
+  // the index must be empty, and no thread may be using it. indexes that
+  // cannot build their nodes directly insert the keys one at a time, from the
+  // calling thread.
+  virtual RC index_bulk_load(KEY_TYPE *keys, VALUE_TYPE *items, int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      RC rc = index_insert(keys[i], items[i]);
+      if (rc != RCOK) return rc;
+    }
+    return RCOK;
+  }
+
   virtual RC index_remove(KEY_TYPE key, int part_id = -1) = 0;
   virtual RC index_read(KEY_TYPE key, VALUE_TYPE *item, int part_id = -1) {
     return index_read(key, item, part_id, 0);
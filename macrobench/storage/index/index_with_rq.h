@@ -13,6 +13,7 @@
 #include <csignal>
 #include <cstring>
 #include <limits>
+#include <thread>
 #include "index_base.h"  // for table_t declaration, and parent class inheritance
 
 #include <ctime>
@@ -28,6 +29,13 @@ static Random
  */
 
 typedef allocator_new_segregated<> ALLOCATOR_TYPE;
+// Circular bundles keep their buffers for as long as the memory of the node
+// they are embedded in, so bundled nodes must be constructed by the allocator.
+#ifdef BUNDLE_CIRCULAR_BUNDLE
+typedef allocator_new<> BUNDLE_ALLOCATOR_TYPE;
+#else
+typedef ALLOCATOR_TYPE BUNDLE_ALLOCATOR_TYPE;
+#endif
 typedef pool_none<> POOL_TYPE;
 #ifdef INDEX_NO_RECLAMATION
 typedef reclaimer_none<> RECLAIMER_TYPE;
@@ -63,8 +71,17 @@ typedef reclaimer_debra<> RECLAIMER_TYPE;
 #elif (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_SNAPCOLLECTOR)
 #define RQ_SNAPCOLLECTOR
 #elif (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_BUNDLE) || \
-    (INDEX_STRUCT == IDX_CITRUS_RQ_BUNDLE)
+    (INDEX_STRUCT == IDX_CITRUS_RQ_BUNDLE) ||     \
+    (INDEX_STRUCT == IDX_BST_RQ_BUNDLE) ||        \
+    (INDEX_STRUCT == IDX_ABTREE_RQ_BUNDLE) ||     \
+    (INDEX_STRUCT == IDX_BSLACK_RQ_BUNDLE) ||     \
+    (INDEX_STRUCT == IDX_LAZYLIST_RQ_BUNDLE)
 #define RQ_BUNDLE
+#elif (INDEX_STRUCT == IDX_BST_RQ_VCAS) ||      \
+    (INDEX_STRUCT == IDX_CITRUS_RQ_VCAS) ||     \
+    (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_VCAS) || \
+    (INDEX_STRUCT == IDX_LFSKIPLIST_RQ_VCAS)
+#define RQ_VCAS
 #endif
 
 #if 0
@@ -137,22 +154,41 @@ typedef skiplist<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
 #define VALUES_ARRAY_TYPE VALUE_TYPE *
 
 #elif (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_BUNDLE)
+// Answers several ranges under one snapshot (see index_multi_range_scan).
+#define INDEX_HAS_MULTI_RANGE_SCAN
+// Builds its nodes directly when loading a table (see index_bulk_load).
+#define INDEX_HAS_BULK_LOAD
 #define BUNDLE_MAX_BUNDLES_UPDATED 2
+// Range queries reach their range through the regular pointers, as in the
+// microbenchmark (see microbench/bundle.mk). Otherwise every range query walks
+// the bottom level of the skiplist from the head.
+#define BUNDLE_OPTIMIZE_RQS
+// Define to start searches and range queries from per-thread search fingers,
+// which can help when threads scan nearby keys (see bundle_skiplist.h).
+// #define SKIPLIST_SEARCH_FINGERS
+#if !defined BUNDLE_CIRCULAR_BUNDLE && !defined BUNDLE_INLINE_BUNDLE
 #define BUNDLE_LINKED_BUNDLE
+#endif
 #include "bundle_skiplist_impl.h"
 typedef node_t<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
 typedef bool DESCRIPTOR_TYPE;  // no descriptor
-typedef record_manager<RECLAIMER_TYPE, ALLOCATOR_TYPE, POOL_TYPE, NODE_TYPE>
+// Bundle entries are recycled through per-thread pools.
+typedef BundleEntry<NODE_TYPE> BUNDLE_ENTRY_TYPE;
+typedef record_manager<RECLAIMER_TYPE, BUNDLE_ALLOCATOR_TYPE,
+                       pool_perthread_and_shared<>, NODE_TYPE,
+                       BUNDLE_ENTRY_TYPE>
     RECORD_MANAGER_TYPE;
 typedef bundle_skiplist<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
-#define INDEX_CONSTRUCTOR_ARGS                   \
-  g_thread_cnt, numeric_limits<KEY_TYPE>::min(), \
+// Background cleanup threads use the thread ids after the workers'.
+#define INDEX_CONSTRUCTOR_ARGS                                            \
+  g_thread_cnt + BUNDLE_CLEANUP_THREADS, numeric_limits<KEY_TYPE>::min(), \
       numeric_limits<KEY_TYPE>::max() - 1, __NO_VALUE, rngs
 #define CALL_CALCULATE_INDEX_STATS_FOREACH_CHILD(x, depth)
 #define ISLEAF(x) false
 #define VALUES_ARRAY_TYPE VALUE_TYPE *
 
 #elif (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_UNSAFE)
+#define INDEX_HAS_BULK_LOAD
 #include "unsafe_skiplist_impl.h"
 typedef node_t<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
 typedef bool DESCRIPTOR_TYPE;  // no descriptor
@@ -167,21 +203,32 @@ typedef unsafe_skiplist<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
 #define VALUES_ARRAY_TYPE VALUE_TYPE *
 
 #elif (INDEX_STRUCT == IDX_CITRUS_RQ_BUNDLE)
+#define INDEX_HAS_MULTI_RANGE_SCAN
+#define INDEX_HAS_BULK_LOAD
 #define BUNDLE_MAX_BUNDLES_UPDATED 4
+#if !defined BUNDLE_CIRCULAR_BUNDLE && !defined BUNDLE_INLINE_BUNDLE
 #define BUNDLE_LINKED_BUNDLE
+#endif
 #include "bundle_citrus_impl.h"
 typedef node_t<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
 typedef bool DESCRIPTOR_TYPE;  // no descriptor
-typedef record_manager<RECLAIMER_TYPE, ALLOCATOR_TYPE, POOL_TYPE, NODE_TYPE>
+// Bundle entries are recycled through per-thread pools.
+typedef BundleEntry<NODE_TYPE> BUNDLE_ENTRY_TYPE;
+typedef record_manager<RECLAIMER_TYPE, BUNDLE_ALLOCATOR_TYPE,
+                       pool_perthread_and_shared<>, NODE_TYPE,
+                       BUNDLE_ENTRY_TYPE>
     RECORD_MANAGER_TYPE;
 typedef bundle_citrustree<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
-#define INDEX_CONSTRUCTOR_ARGS \
-  numeric_limits<KEY_TYPE>::max(), __NO_VALUE, g_thread_cnt
+// Background cleanup threads use the thread ids after the workers'.
+#define INDEX_CONSTRUCTOR_ARGS                   \
+  numeric_limits<KEY_TYPE>::max(), __NO_VALUE, \
+      g_thread_cnt + BUNDLE_CLEANUP_THREADS
 #define CALL_CALCULATE_INDEX_STATS_FOREACH_CHILD(x, depth)
 #define ISLEAF(x) false
 #define VALUES_ARRAY_TYPE VALUE_TYPE *
 
 #elif (INDEX_STRUCT == IDX_CITRUS_RQ_UNSAFE)
+#define INDEX_HAS_BULK_LOAD
 #include "unsafe_citrus_impl.h"
 typedef node_t<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
 typedef bool DESCRIPTOR_TYPE;  // no descriptor
@@ -209,6 +256,144 @@ typedef rlucitrus<KEY_TYPE, VALUE_TYPE> INDEX_TYPE;
 #define ISLEAF(x) ((x)->child[0] == NULL && (x)->child[1] == NULL)
 #define VALUES_ARRAY_TYPE VALUE_TYPE *
 
+#elif (INDEX_STRUCT == IDX_BST_RQ_BUNDLE)
+// The tree prepares bundles without locking the nodes that own them, so
+// concurrent updates must serialize on the bundle itself. Only the linked
+// bundle supports this.
+#define BUNDLE_LINKED_BUNDLE
+#define BUNDLE_LOCKFREE
+#define INDEX_HAS_BULK_LOAD
+#include "bundle_bst_impl.h"
+using namespace bundle_bst_ns;
+typedef Node<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
+typedef SCXRecord<KEY_TYPE, VALUE_TYPE> DESCRIPTOR_TYPE;
+// Bundle entries are recycled through per-thread pools.
+typedef BundleEntry<NODE_TYPE> BUNDLE_ENTRY_TYPE;
+typedef record_manager<RECLAIMER_TYPE, BUNDLE_ALLOCATOR_TYPE,
+                       pool_perthread_and_shared<>, NODE_TYPE,
+                       BUNDLE_ENTRY_TYPE>
+    RECORD_MANAGER_TYPE;
+typedef bundle_bst<KEY_TYPE, VALUE_TYPE, less<KEY_TYPE>, RECORD_MANAGER_TYPE>
+    INDEX_TYPE;
+// Background cleanup threads use the thread ids after the workers'.
+#define INDEX_CONSTRUCTOR_ARGS \
+  __NO_KEY, __NO_VALUE, g_thread_cnt + BUNDLE_CLEANUP_THREADS, SIGQUIT
+#define CALL_CALCULATE_INDEX_STATS_FOREACH_CHILD(x, depth) \
+  {                                                        \
+    calculate_index_stats((x)->left, (depth));             \
+    calculate_index_stats((x)->right, (depth));            \
+  }
+#define ISLEAF(x) ((x)->left == NULL)
+#define VALUES_ARRAY_TYPE VALUE_TYPE *
+
+#elif (INDEX_STRUCT == IDX_LAZYLIST_RQ_BUNDLE)
+#define INDEX_HAS_BULK_LOAD
+#if !defined BUNDLE_CIRCULAR_BUNDLE && !defined BUNDLE_INLINE_BUNDLE
+#define BUNDLE_LINKED_BUNDLE
+#endif
+#include "bundle_lazylist_impl.h"
+typedef node_t<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
+typedef bool DESCRIPTOR_TYPE;  // no descriptor
+// Bundle entries are recycled through per-thread pools.
+typedef BundleEntry<NODE_TYPE> BUNDLE_ENTRY_TYPE;
+typedef record_manager<RECLAIMER_TYPE, BUNDLE_ALLOCATOR_TYPE,
+                       pool_perthread_and_shared<>, NODE_TYPE,
+                       BUNDLE_ENTRY_TYPE>
+    RECORD_MANAGER_TYPE;
+typedef bundle_lazylist<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
+// Background cleanup threads use the thread ids after the workers'.
+#define INDEX_CONSTRUCTOR_ARGS                                            \
+  g_thread_cnt + BUNDLE_CLEANUP_THREADS, numeric_limits<KEY_TYPE>::min(), \
+      numeric_limits<KEY_TYPE>::max() - 1, __NO_VALUE
+#define CALL_CALCULATE_INDEX_STATS_FOREACH_CHILD(x, depth)
+#define ISLEAF(x) false
+#define VALUES_ARRAY_TYPE VALUE_TYPE *
+
+#elif (INDEX_STRUCT == IDX_BST_RQ_VCAS)
+#include "vcas_bst_impl.h"
+using namespace vcas_bst_ns;
+typedef Node<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
+typedef SCXRecord<KEY_TYPE, VALUE_TYPE> DESCRIPTOR_TYPE;
+typedef record_manager<RECLAIMER_TYPE, ALLOCATOR_TYPE, POOL_TYPE, NODE_TYPE>
+    RECORD_MANAGER_TYPE;
+typedef vcas_bst<KEY_TYPE, VALUE_TYPE, less<KEY_TYPE>, RECORD_MANAGER_TYPE>
+    INDEX_TYPE;
+#define INDEX_CONSTRUCTOR_ARGS __NO_KEY, __NO_VALUE, g_thread_cnt, SIGQUIT
+#define CALL_CALCULATE_INDEX_STATS_FOREACH_CHILD(x, depth) \
+  {                                                        \
+    calculate_index_stats((x)->left, (depth));             \
+    calculate_index_stats((x)->right, (depth));            \
+  }
+#define ISLEAF(x) ((x)->left == NULL)
+#define VALUES_ARRAY_TYPE VALUE_TYPE *
+
+#elif (INDEX_STRUCT == IDX_CITRUS_RQ_VCAS)
+#define NVCAS_OPTIMIZATION
+#include "vcas_citrus_impl.h"
+using namespace vcas_citrus;
+typedef node_t<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
+typedef bool DESCRIPTOR_TYPE;  // no descriptor
+typedef record_manager<RECLAIMER_TYPE, ALLOCATOR_TYPE, POOL_TYPE, NODE_TYPE,
+                       vcas_obj_t<NODE_TYPE *>>
+    RECORD_MANAGER_TYPE;
+typedef citrustree<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
+#define INDEX_CONSTRUCTOR_ARGS \
+  numeric_limits<KEY_TYPE>::max(), __NO_VALUE, g_thread_cnt
+#define CALL_CALCULATE_INDEX_STATS_FOREACH_CHILD(x, depth)
+#define ISLEAF(x) false
+#define VALUES_ARRAY_TYPE VALUE_TYPE *
+
+#elif (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_VCAS) || \
+    (INDEX_STRUCT == IDX_LFSKIPLIST_RQ_VCAS)
+#define NVCAS_OPTIMIZATION
+#if (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_VCAS)
+#include "vcas_skiplist_lock_impl.h"
+using namespace vcas_skiplist_lock;
+#else
+#include "vcas_lockfree_skiplist_impl.h"
+using namespace vcas_lockfree_skiplist;
+#endif
+typedef node_t<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
+typedef bool DESCRIPTOR_TYPE;  // no descriptor
+typedef record_manager<RECLAIMER_TYPE, ALLOCATOR_TYPE, POOL_TYPE, NODE_TYPE,
+                       vcas_obj_t<NODE_TYPE *>, vcas_obj_t<long long>>
+    RECORD_MANAGER_TYPE;
+typedef skiplist<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
+#define INDEX_CONSTRUCTOR_ARGS                   \
+  g_thread_cnt, numeric_limits<KEY_TYPE>::min(), \
+      numeric_limits<KEY_TYPE>::max() - 1, __NO_VALUE, rngs
+#define CALL_CALCULATE_INDEX_STATS_FOREACH_CHILD(x, depth)
+#define ISLEAF(x) false
+#define VALUES_ARRAY_TYPE VALUE_TYPE *
+
+#elif (INDEX_STRUCT == IDX_MVCC_VBR_SKIPLIST) || \
+    (INDEX_STRUCT == IDX_MVCC_VBR_TREE)
+// The same versioned list, indexed by a skiplist or a tree.
+#if (INDEX_STRUCT == IDX_MVCC_VBR_SKIPLIST)
+#define MVCC_VBR_SKIPLIST
+#else
+#define MVCC_VBR_TREE
+#endif
+// Every allocator preallocates its whole pool, and there is one index (with
+// two allocators) per table, so the pools are much smaller than in the
+// microbenchmark.
+#ifndef OBJECTS_IN_POOL
+#define OBJECTS_IN_POOL (1024 * 1024L)
+#endif
+#include "mvccvbr_list.h"
+typedef DirectCTSNode<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
+typedef bool DESCRIPTOR_TYPE;  // no descriptor
+// Nodes come from the list's own allocator, so the record manager is unused.
+typedef record_manager<RECLAIMER_TYPE, ALLOCATOR_TYPE, POOL_TYPE, NODE_TYPE>
+    RECORD_MANAGER_TYPE;
+typedef mvccvbr_list<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
+#define INDEX_CONSTRUCTOR_ARGS                   \
+  g_thread_cnt, numeric_limits<KEY_TYPE>::min(), \
+      numeric_limits<KEY_TYPE>::max() - 1, __NO_VALUE
+#define CALL_CALCULATE_INDEX_STATS_FOREACH_CHILD(x, depth)
+#define ISLEAF(x) false
+#define VALUES_ARRAY_TYPE VALUE_TYPE *
+
 #elif (INDEX_STRUCT == IDX_ABTREE_RQ_LOCKFREE) || \
     (INDEX_STRUCT == IDX_ABTREE_RQ_RWLOCK) ||     \
     (INDEX_STRUCT == IDX_ABTREE_RQ_HTM_RWLOCK) || \
@@ -242,6 +427,40 @@ typedef bslack<ABTREE_DEGREE, KEY_TYPE, less<KEY_TYPE>, RECORD_MANAGER_TYPE>
   }
 #define ISLEAF(x) (x)->isLeaf()
 #define VALUES_ARRAY_TYPE void **
+
+#elif (INDEX_STRUCT == IDX_ABTREE_RQ_BUNDLE) || \
+    (INDEX_STRUCT == IDX_BSLACK_RQ_BUNDLE)
+// Like the bundled BST, updates prepare bundles without locking nodes.
+#define BUNDLE_LINKED_BUNDLE
+#define BUNDLE_LOCKFREE
+#define INDEX_HAS_BULK_LOAD
+#if (INDEX_STRUCT == IDX_ABTREE_RQ_BUNDLE)
+#define USE_SIMPLIFIED_ABTREE_REBALANCING
+#endif
+#include "bundle_bslack_impl.h"
+using namespace bundle_bslack_ns;
+#define ABTREE_DEGREE 16
+typedef Node<ABTREE_DEGREE, KEY_TYPE> NODE_TYPE;
+typedef SCXRecord<ABTREE_DEGREE, KEY_TYPE> DESCRIPTOR_TYPE;
+// Bundle entries are recycled through per-thread pools.
+typedef BundleEntry<NODE_TYPE> BUNDLE_ENTRY_TYPE;
+typedef record_manager<RECLAIMER_TYPE, BUNDLE_ALLOCATOR_TYPE,
+                       pool_perthread_and_shared<>, NODE_TYPE,
+                       BUNDLE_ENTRY_TYPE>
+    RECORD_MANAGER_TYPE;
+typedef bundle_bslack<ABTREE_DEGREE, KEY_TYPE, less<KEY_TYPE>,
+                      RECORD_MANAGER_TYPE>
+    INDEX_TYPE;
+#define INDEX_CONSTRUCTOR_ARGS \
+  g_thread_cnt + BUNDLE_CLEANUP_THREADS, ABTREE_DEGREE, __NO_KEY, SIGQUIT
+#define CALL_CALCULATE_INDEX_STATS_FOREACH_CHILD(x, depth)         \
+  {                                                                \
+    for (int __i = 0; __i < (x)->getABDegree(); ++__i) {           \
+      calculate_index_stats((NODE_TYPE *)(x)->ptrs[__i], (depth)); \
+    }                                                              \
+  }
+#define ISLEAF(x) (x)->isLeaf()
+#define VALUES_ARRAY_TYPE void **
 #endif
 
 /**
@@ -279,6 +498,19 @@ class index_with_rq : public index_base {
     }
   }
 
+#ifdef RQ_BUNDLE
+  // gives visit each value as a VALUE_TYPE, since some indexes store values
+  // as void * (see VALUES_ARRAY_TYPE).
+  template <typename Visitor>
+  struct ValueCastingVisitor {
+    Visitor &visit;
+    template <typename V>
+    bool operator()(const KEY_TYPE &key, const V &value) {
+      return visit(key, (VALUE_TYPE)value);
+    }
+  };
+#endif
+
  public:
   // WARNING: DO NOT OVERLOAD init() WITH NO ARGUMENTS!!!
   RC init(uint64_t part_cnt, table_t *table) {
@@ -289,6 +521,15 @@ class index_with_rq : public index_base {
       rngs[i * PREFETCH_SIZE_WORDS].setSeed(rand());
     }
 
+#ifdef RQ_BUNDLE
+    if (g_bundle_ts_policy != "") {
+      default_timestamp_policy() =
+          timestamp_policy_from_name(g_bundle_ts_policy.c_str());
+      if (default_timestamp_policy() == BUNDLE_TS_INVALID) {
+        error("invalid bundle timestamp policy");
+      }
+    }
+#endif
     index = new INDEX_TYPE(INDEX_CONSTRUCTOR_ARGS);
     this->table = table;
 
@@ -334,7 +575,12 @@ class index_with_rq : public index_base {
     (INDEX_STRUCT == IDX_CITRUS_RQ_RWLOCK) ||     \
     (INDEX_STRUCT == IDX_CITRUS_RQ_HTM_RWLOCK) || \
     (INDEX_STRUCT == IDX_CITRUS_RQ_UNSAFE) ||     \
-    (INDEX_STRUCT == IDX_CITRUS_RQ_RLU) 
+    (INDEX_STRUCT == IDX_CITRUS_RQ_RLU) ||        \
+    (INDEX_STRUCT == IDX_CITRUS_RQ_VCAS) ||       \
+    (INDEX_STRUCT == IDX_BST_RQ_BUNDLE) ||        \
+    (INDEX_STRUCT == IDX_BST_RQ_VCAS) ||          \
+    (INDEX_STRUCT == IDX_ABTREE_RQ_BUNDLE) ||     \
+    (INDEX_STRUCT == IDX_BSLACK_RQ_BUNDLE)
     const void *oldVal = (VALUE_TYPE)index->erase(tid, key).first;
 #else
     const void *oldVal = index->erase(tid, key);
@@ -361,6 +607,83 @@ class index_with_rq : public index_base {
     INCREMENT_NUM_RQS(tid);
     return RCOK;
   }
+#ifdef RQ_BUNDLE
+  // calls visit(key, value) on the keys in [low, high] in increasing order,
+  // stopping once visit returns false or limit keys were visited (all of them
+  // if limit is negative), and saves the number N of keys visited in
+  // numResults. nothing is copied, so memory use does not depend on the size
+  // of the range.
+  template <typename Visitor>
+  RC index_range_scan(KEY_TYPE low, KEY_TYPE high, Visitor visit,
+                      int *numResults, int limit = -1, int part_id = -1) {
+    ValueCastingVisitor<Visitor> castingVisit = {visit};
+    *numResults = index->visitRange(tid, low, high, castingVisit, limit);
+    INCREMENT_NUM_RQS(tid);
+    return RCOK;
+  }
+#else
+  // same contract, for indexes without visitRange: the range is copied by
+  // index_range_query, then its keys are visited in increasing order.
+  template <typename Visitor>
+  RC index_range_scan(KEY_TYPE low, KEY_TYPE high, Visitor visit,
+                      int *numResults, int limit = -1, int part_id = -1) {
+    KEY_TYPE resultKeys[high - low + 1];
+    VALUE_TYPE resultValues[high - low + 1];
+    int n = 0;
+    index_range_query(low, high, resultKeys, resultValues, &n, part_id);
+    int cnt = 0;
+    while (cnt < n) {
+      ++cnt;
+      if (!visit(resultKeys[cnt - 1], resultValues[cnt - 1]) || cnt == limit)
+        break;
+    }
+    *numResults = cnt;
+    return RCOK;
+  }
+#endif
+#ifdef INDEX_HAS_MULTI_RANGE_SCAN
+  // like index_range_scan, for the n ranges [lows[i], highs[i]] at once:
+  // visit(i, key, value) is called on the keys of range i, and all ranges
+  // share the snapshot and traversal of a single range query.
+  template <typename Visitor>
+  RC index_multi_range_scan(int n, KEY_TYPE *lows, KEY_TYPE *highs,
+                            Visitor visit, int *numResults, int part_id = -1) {
+    *numResults = index->visitRanges(tid, n, lows, highs, visit);
+    INCREMENT_NUM_RQS(tid);
+    return RCOK;
+  }
+#endif
+#ifdef INDEX_HAS_BULK_LOAD
+  // builds the index without inserting the keys one at a time:
+  // g_init_parallelism threads (with thread ids 0, 1, ...) each build the
+  // nodes of a slice of the keys, then the calling thread links the slices
+  // (as thread 0). keys must be sorted and distinct, the index must be empty,
+  // and every thread that used it must have called deinitThread.
+  RC index_bulk_load(KEY_TYPE *keys, VALUE_TYPE *items, int64_t n) {
+    const int numParts = g_init_parallelism;
+    INDEX_TYPE::BulkLoadPart *parts = new INDEX_TYPE::BulkLoadPart[numParts];
+    std::thread *builders = new std::thread[numParts];
+    for (int i = 0; i < numParts; ++i) {
+      builders[i] = std::thread([this, keys, items, n, numParts, parts, i]() {
+        const int64_t lo = n * i / numParts;
+        const int64_t hi = n * (i + 1) / numParts;
+        index->initThread(i);
+        parts[i] = index->bulkLoadPart(i, keys + lo,
+                                       (VALUES_ARRAY_TYPE)(items + lo), hi - lo);
+        index->deinitThread(i);
+      });
+    }
+    for (int i = 0; i < numParts; ++i) {
+      builders[i].join();
+    }
+    index->initThread(0);
+    index->bulkLoadFinish(0, parts, numParts);
+    index->deinitThread(0);
+    delete[] builders;
+    delete[] parts;
+    return RCOK;
+  }
+#endif
   void initThread(const int tid) { index->initThread(tid); }
   void deinitThread(const int tid) { index->deinitThread(tid); }
 
@@ -384,6 +707,12 @@ class index_with_rq : public index_base {
       cout << "Alignment " << i * 8 << ": "
            << (alignment[i] / (double)num_nodes) * 100 << "%" << endl;
     }
+#ifdef RQ_BUNDLE
+    // the worker threads have been joined, so the index can be traversed
+    BundleFootprint footprint;
+    index->getFootprint(footprint);
+    footprint.print(cout);
+#endif
   }
 };
 
@@ -37,6 +37,8 @@ carbon_barrier_t enable_barrier;
 #endif
 
 string g_thr_pinning_policy = "";
+string g_bundle_ts_policy = "";
+bool g_bulk_load = false;
 
 ts_t g_abort_penalty = ABORT_PENALTY;
 bool g_central_man = CENTRAL_MAN;
@@ -57,6 +59,8 @@ double g_perc_multi_part = PERC_MULTI_PART;
 double g_read_perc = READ_PERC;
 double g_write_perc = WRITE_PERC;
 double g_zipf_theta = ZIPF_THETA;
+double g_scan_perc = SCAN_PERC;
+UInt32 g_scan_len = SCAN_LEN;
 bool g_prt_lat_distr = PRT_LAT_DISTR;
 UInt32 g_part_cnt = PART_CNT;
 UInt32 g_virtual_part_cnt = VIRTUAL_PART_CNT;
@@ -80,6 +80,8 @@ extern carbon_barrier_t enable_barrier;
 // Global Parameter
 /******************************************/
 extern string g_thr_pinning_policy;
+extern string g_bundle_ts_policy;
+extern bool g_bulk_load;
 
 extern bool g_part_alloc;
 extern bool g_mem_pad;
@@ -109,6 +111,8 @@ extern double g_perc_multi_part;
 extern double g_read_perc;
 extern double g_write_perc;
 extern double g_zipf_theta;
+extern double g_scan_perc;
+extern UInt32 g_scan_len;
 extern UInt64 g_synth_table_size;
 extern UInt32 g_req_per_query;
 extern UInt32 g_field_per_tuple;
@@ -183,7 +187,17 @@ enum TsType {R_REQ, W_REQ, P_REQ, XP_REQ};
         (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_UNSAFE) || \
         (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_SNAPCOLLECTOR) || \
         (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_BUNDLE) || \
-        (INDEX_STRUCT == IDX_CITRUS_RQ_BUNDLE)
+        (INDEX_STRUCT == IDX_CITRUS_RQ_BUNDLE) || \
+        (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_VCAS) || \
+        (INDEX_STRUCT == IDX_BST_RQ_BUNDLE) || \
+        (INDEX_STRUCT == IDX_ABTREE_RQ_BUNDLE) || \
+        (INDEX_STRUCT == IDX_BSLACK_RQ_BUNDLE) || \
+        (INDEX_STRUCT == IDX_BST_RQ_VCAS) || \
+        (INDEX_STRUCT == IDX_CITRUS_RQ_VCAS) || \
+        (INDEX_STRUCT == IDX_LFSKIPLIST_RQ_VCAS) || \
+        (INDEX_STRUCT == IDX_LAZYLIST_RQ_BUNDLE) || \
+        (INDEX_STRUCT == IDX_MVCC_VBR_SKIPLIST) || \
+        (INDEX_STRUCT == IDX_MVCC_VBR_TREE)
 #define INDEX           index_with_rq
 #elif (INDEX_STRUCT == IDX_BST)
 #define INDEX           index_bst
@@ -2,6 +2,9 @@
 #include "row.h"
 #include "txn.h"
 #include "pthread.h"
+#if TS_ALLOC == TS_BUNDLE
+#include "rq_announcements.h"
+#endif
 
 void Manager::init() {
 	timestamp = (uint64_t *) _mm_malloc(sizeof(uint64_t), ALIGNMENT);
@@ -53,6 +56,11 @@ Manager::get_ts(uint64_t thread_id) {
 	case TS_CLOCK :
 		time = get_sys_clock() * g_thread_cnt + thread_id;
 		break;
+#if TS_ALLOC == TS_BUNDLE
+	case TS_BUNDLE :
+		time = 2 * shared_bundle_timestamps().update(thread_id);
+		break;
+#endif
 	default :
 		assert(false);
 	}
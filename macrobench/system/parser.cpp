@@ -22,6 +22,8 @@ void print_usage() {
 	printf("\t-GbINT      ; TS_BATCH_ALLOC\n");
 	printf("\t-GuINT      ; TS_BATCH_NUM\n");
 	
+	printf("\t-bts STRING ; bundle timestamp policy (global, cas, rq, numa, tsc)\n");
+	printf("\t-bulk       ; bulk load the indexes that support it\n");
 	printf("\t-o STRING   ; output file\n\n");
 	printf("  [YCSB]:\n");
 	printf("\t-cINT       ; PART_PER_TXN\n");
@@ -29,6 +31,8 @@ void print_usage() {
 	printf("\t-rFLOAT     ; READ_PERC\n");
 	printf("\t-wFLOAT     ; WRITE_PERC\n");
 	printf("\t-zFLOAT     ; ZIPF_THETA\n");
+	printf("\t-SpFLOAT    ; SCAN_PERC\n");
+	printf("\t-SlINT      ; SCAN_LEN\n");
 	printf("\t-sINT       ; SYNTH_TABLE_SIZE\n");
 	printf("\t-RINT       ; REQ_PER_QUERY\n");
 	printf("\t-fINT       ; FIELD_PER_TUPLE\n");
@@ -52,6 +56,8 @@ void parser(int argc, char * argv[]) {
         //cout<<"argv["<<i<<"]="<<argv[i]<<endl;
         assert(argv[i][0]=='-');
         if (strcmp(argv[i], "-pin")==0) g_thr_pinning_policy = string(argv[++i]);
+        else if (strcmp(argv[i], "-bts")==0) g_bundle_ts_policy = string(argv[++i]);
+        else if (strcmp(argv[i], "-bulk")==0) g_bulk_load = true;
         else if (argv[i][1]=='a') g_part_alloc = atoi(&argv[i][2]);
         else if (argv[i][1]=='m') g_mem_pad = atoi(&argv[i][2]);
         else if (argv[i][1]=='q') g_query_intvl = atoi(&argv[i][2]);
@@ -78,6 +84,9 @@ void parser(int argc, char * argv[]) {
             else if (argv[i][2]=='l') g_dl_loop_detect = atoi(&argv[i][3]);
             else if (argv[i][2]=='b') g_ts_batch_alloc = atoi(&argv[i][3]);
             else if (argv[i][2]=='u') g_ts_batch_num = atoi(&argv[i][3]);
+        } else if (argv[i][1]=='S') {
+            if (argv[i][2]=='p') g_scan_perc = atof(&argv[i][3]);
+            if (argv[i][2]=='l') g_scan_len = atoi(&argv[i][3]);
         } else if (argv[i][1]=='T') {
             if (argv[i][2]=='p') g_perc_payment = atof(&argv[i][3]);
             if (argv[i][2]=='u') g_wh_update = atoi(&argv[i][3]);
@@ -102,6 +111,10 @@ void parser(int argc, char * argv[]) {
             assert(false);
         }
     }
+    if (g_scan_len<1||g_scan_len>MAX_ROW_PER_TXN) {
+        printf("SCAN_LEN must be between 1 and MAX_ROW_PER_TXN (%d)\n", MAX_ROW_PER_TXN);
+        exit(1);
+    }
     if (g_thread_cnt<g_init_parallelism)
         g_init_parallelism = g_thread_cnt;
 }
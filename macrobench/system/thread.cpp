@@ -12,6 +12,9 @@
 #include "tpcc_query.h"
 #include "mem_alloc.h"
 #include "test.h"
+#if TS_ALLOC == TS_BUNDLE
+#include "rq_announcements.h"
+#endif
 
 void thread_t::init(uint64_t thd_id, workload * workload) {
 	_thd_id = thd_id;
@@ -100,11 +103,19 @@ RC thread_t::run() {
 		m_txn->set_txn_id(get_thd_id() + thd_txn_id * g_thread_cnt);
 		thd_txn_id ++;
 
+#if TS_ALLOC == TS_BUNDLE
+		// Index range queries of the transaction read at the pinned snapshot.
+		// Commit timestamps are even and start timestamps odd (see
+		// Manager::get_ts), so a row version is visible exactly when a bundle
+		// entry with the same timestamp would be.
+		m_txn->set_ts(2 * shared_bundle_announcements().pin(get_thd_id()) + 1);
+#else
 		if ((CC_ALG == HSTORE && !HSTORE_LOCAL_TS)
 				|| CC_ALG == MVCC 
 				|| CC_ALG == HEKATON
 				|| CC_ALG == TIMESTAMP) 
 			m_txn->set_ts(get_next_ts());
+#endif
 
 		rc = RCOK;
 #if CC_ALG == HSTORE
@@ -139,6 +150,9 @@ RC thread_t::run() {
 				part_lock_man.unlock(m_txn, m_query->part_to_access, m_query->part_num);
 #endif
 		}
+#if TS_ALLOC == TS_BUNDLE
+		shared_bundle_announcements().unpin(get_thd_id());
+#endif
 		if (rc == Abort) {
 			uint64_t penalty = 0;
 			if (ABORT_PENALTY != 0)  {
@@ -89,6 +89,46 @@ class txn_man {
   int index_range_query(INDEX* index, idx_key_t low, idx_key_t high,
                         idx_key_t* resultKeys, itemid_t** resultValues,
                         int part_id, bool countLen = false);
+  // like index_range_query, but streams the results to visit instead of
+  // copying them (only for indexes with index_range_scan).
+  template <typename Index, typename Visitor>
+  int index_range_scan(Index* index, idx_key_t low, idx_key_t high,
+                       Visitor visit, int limit, int part_id,
+                       bool countLen = false) {
+    uint64_t starttime = get_sys_clock();
+    int numResults = 0;
+    index->index_range_scan(low, high, visit, &numResults, limit, part_id);
+    INC_TMP_STATS(get_thd_id(), stats_indexes[index->index_id].numRangeQuery, 1);
+    INC_TMP_STATS(get_thd_id(), stats_indexes[index->index_id].timeRangeQuery,
+                  get_sys_clock() - starttime);
+    if (countLen) {
+      INC_TMP_STATS(get_thd_id(), stats_indexes[index->index_id].lenRangeQuery,
+                    numResults);
+      INC_TMP_STATS(get_thd_id(),
+                    stats_indexes[index->index_id].numLenRangeQuery, 1);
+    }
+    return numResults;
+  }
+  // like index_range_scan, for n ranges answered at a single snapshot. each
+  // range counts as one range query in the statistics.
+  template <typename Index, typename Visitor>
+  int index_multi_range_scan(Index* index, int n, idx_key_t* lows,
+                             idx_key_t* highs, Visitor visit, int part_id,
+                             bool countLen = false) {
+    uint64_t starttime = get_sys_clock();
+    int numResults = 0;
+    index->index_multi_range_scan(n, lows, highs, visit, &numResults, part_id);
+    INC_TMP_STATS(get_thd_id(), stats_indexes[index->index_id].numRangeQuery, n);
+    INC_TMP_STATS(get_thd_id(), stats_indexes[index->index_id].timeRangeQuery,
+                  get_sys_clock() - starttime);
+    if (countLen) {
+      INC_TMP_STATS(get_thd_id(), stats_indexes[index->index_id].lenRangeQuery,
+                    numResults);
+      INC_TMP_STATS(get_thd_id(),
+                    stats_indexes[index->index_id].numLenRangeQuery, n);
+    }
+    return numResults;
+  }
   itemid_t* index_read(INDEX* index, idx_key_t key, int part_id);
   void index_read(INDEX* index, idx_key_t key, int part_id, itemid_t** item);
   void index_insert(INDEX* index, uint64_t key, row_t* row, int64_t part_id);
@@ -7,24 +7,42 @@
 # FLAGS += -DBUNDLE_CLEANUP_NO_FREE
 # FLAGS += -DBUNDLE_DEBUG
 FLAGS += -DBUNDLE_PRINT_BUNDLE_STATS
+# Reports how many bundle entries were allocated versus recycled from the
+# record manager's per-thread pools.
+FLAGS += -DBUNDLE_PRINT_ENTRY_STATS
 # ---------------------------
 
 
 ## Bundle entry cleanup flags. Uncoment CLEANUP_BACKGROUND to 
-## enable a background thread cleanup of bundle entries. The 
-## CLEANUP_SLEEP macro adjusts how many nanoseconds the background 
-## thread sleeps between iterations. It is required if 
-## CLENAUP_BACKGROUND is enabled. CLEANUP_UPDATE is an experimental 
-## configuration that allows update operations to reclaim stale 
-## bundle entries
+## enable background threads that clean up bundle entries (see
+## bundle/bundle_cleaner.h). The CLEANUP_SLEEP macro sets the longest
+## pause, in microseconds, between two batches of a background thread.
+## It is required if CLENAUP_BACKGROUND is enabled. The pause shrinks
+## as updates create entries faster, down to CLEANUP_MIN_SLEEP.
+## CLEANUP_THREADS sets the number of background threads, each cleaning
+## its own share of the keys CLEANUP_BATCH nodes at a time.
+## CLEANUP_UPDATE lets update operations reclaim stale bundle entries
+## instead, without any background thread. An update trims a bundle it
+## prepares only if it holds more than CLEANUP_UPDATE_THRESHOLD entries,
+## using its own snapshot of the oldest active range query, which it
+## refreshes every RQ_REFRESH_PERIOD updates.
 # ------------------------.
 # FLAGS += -DBUNDLE_CLEANUP_UPDATE
+# FLAGS += -DBUNDLE_CLEANUP_UPDATE_THRESHOLD=4
+# FLAGS += -DBUNDLE_RQ_REFRESH_PERIOD=64
 # FLAGS += -DBUNDLE_CLEANUP_BACKGROUND
-# FLAGS += -DBUNDLE_CLEANUP_SLEEP=100000  # ns
+# FLAGS += -DBUNDLE_CLEANUP_SLEEP=100000  # us
+# FLAGS += -DBUNDLE_CLEANUP_MIN_SLEEP=10  # us
+# FLAGS += -DBUNDLE_CLEANUP_THREADS=1
+# FLAGS += -DBUNDLE_CLEANUP_BATCH=1024
 # --------------------------
 
-# FLAGS += -DBUNDLE_UPDATE_USES_CAS
-# FLAGS += -DBUNDLE_RQTS
+## Timestamp policy used when none is given on the command line (see
+## bundle/timestamp_provider.h). Select one at runtime with "-ts <policy>",
+## where <policy> is one of global, cas, rq, numa or tsc.
+# ------------------------.
+# FLAGS += -DBUNDLE_TIMESTAMP_POLICY=\"numa\"
+# ------------------------
 
 ## Three-phase range query optimzation. Allows range queries to use 
 ## the regular pointers for the first (pre-traversal) phase. During 
@@ -37,9 +55,31 @@ FLAGS += -DBUNDLE_PRINT_BUNDLE_STATS
 FLAGS +=  -DBUNDLE_OPTIMIZE_RQS
 # ------------------------
 
-## Relaxation optimization. If this is enabled, then threads will 
-## only increment the global timestamp after TIMSTAMP_RELAXATION 
-## number of update operations
+## Bound on the restarts of a range query of the bundled lazy-list and
+## skip-list. Its BUNDLE_RQ_MAX_RESTARTS-th restart enters the range
+## from the head, following only bundles, which cannot fail. The
+## restarts of each range query are recorded in the rq_restarts GSTAT,
+## and range queries that entered from the head in rq_fallbacks.
+# ------------------------.
+# FLAGS += -DBUNDLE_RQ_MAX_RESTARTS=4
+# ------------------------
+
+## Search fingers for the bundled skip-list. Searches and range queries
+## start from the predecessors found by the thread's previous search
+## when they look for a nearby key, instead of descending from the head.
+## This only helps if the keys a thread accesses are localized.
+# ------------------------.
+# FLAGS += -DSKIPLIST_SEARCH_FINGERS
+# ------------------------
+
+## Locks of the nodes of the bundled lazy-list and skip-list (see
+## common/node_locks.h). Each is one of TTASNodeLock (the default),
+## BackoffNodeLock, TicketNodeLock or CohortNodeLock. NODE_LOCK_STATS
+## records how long each acquisition waited for its lock and held it,
+## in cycles, as the node_lock_wait_cycles and node_lock_hold_cycles
+## GSTATS.
 # ------------------------.
-# FLAGS += -DBUNDLE_TIMESTAMP_RELAXATION=5
+# FLAGS += -DLAZYLIST_NODE_LOCK=TicketNodeLock
+# FLAGS += -DSKIPLIST_NODE_LOCK=CohortNodeLock
+# FLAGS += -DNODE_LOCK_STATS
 # ------------------------
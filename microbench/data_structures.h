@@ -43,7 +43,8 @@ const test_type KEY_MAX =
 #define FIND_FUNC contains
 #endif
 
-#if defined ABTREE || defined BSLACK
+#if defined ABTREE || defined BSLACK || defined BUNDLE_ABTREE || \
+    defined BUNDLE_BSLACK
 #define VALUE ((void *)(int64_t)key)
 #define KEY keys[0]
 #define VALUE_TYPE void *
@@ -356,15 +357,18 @@ rlu_thread_data_t *rlu_tdata = NULL;
 
 #elif defined(BUNDLE_LIST)
 #include "record_manager.h"
-#define BUNDLE_TYPE_DECL LinkedBundle
 #include "bundle_lazylist_impl.h"
 
 
 #define DS_DECLARATION bundle_lazylist<test_type, test_type, MEMMGMT_T>
-#define MEMMGMT_T \
-  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>>
-#define DS_CONSTRUCTOR \
-  new DS_DECLARATION(TOTAL_THREADS + 1, KEY_MIN, KEY_MAX, NO_VALUE)
+#define BULK_LOAD_SUPPORTED
+#define BUNDLE_ENTRY_TYPE BundleEntry<node_t<test_type, test_type>>
+#define MEMMGMT_T                                                    \
+  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>, \
+                 BUNDLE_ENTRY_TYPE>
+#define DS_CONSTRUCTOR                                                         \
+  new DS_DECLARATION(TOTAL_THREADS + BUNDLE_CLEANUP_THREADS, KEY_MIN, KEY_MAX, \
+                     NO_VALUE)
 
 #define INSERT_AND_CHECK_SUCCESS \
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
@@ -392,15 +396,18 @@ rlu_thread_data_t *rlu_tdata = NULL;
        << " including header=" << BUNDLE_OBJ_SIZE << endl;
 
 #elif defined(BUNDLE_SKIPLIST)
-#define BUNDLE_TYPE_DECL LinkedBundle
 #include "bundle_skiplist_impl.h"
 #include "record_manager.h"
 
 #define DS_DECLARATION bundle_skiplist<test_type, test_type, MEMMGMT_T>
-#define MEMMGMT_T \
-  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>>
-#define DS_CONSTRUCTOR \
-  new DS_DECLARATION(TOTAL_THREADS + 1, KEY_MIN, KEY_MAX, NO_VALUE, glob.rngs)
+#define BULK_LOAD_SUPPORTED
+#define BUNDLE_ENTRY_TYPE BundleEntry<node_t<test_type, test_type>>
+#define MEMMGMT_T                                                    \
+  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>, \
+                 BUNDLE_ENTRY_TYPE>
+#define DS_CONSTRUCTOR                                                         \
+  new DS_DECLARATION(TOTAL_THREADS + BUNDLE_CLEANUP_THREADS, KEY_MIN, KEY_MAX, \
+                     NO_VALUE, glob.rngs)
 
 #define INSERT_AND_CHECK_SUCCESS \
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
@@ -426,14 +433,17 @@ rlu_thread_data_t *rlu_tdata = NULL;
        << " including header=" << BUNDLE_OBJ_SIZE << endl;
 
 #elif defined(BUNDLE_CITRUS)
-#define BUNDLE_TYPE_DECL LinkedBundle
 #include "bundle_citrus_impl.h"
 #include "record_manager.h"
 
 #define DS_DECLARATION bundle_citrustree<test_type, test_type, MEMMGMT_T>
-#define MEMMGMT_T \
-  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>>
-#define DS_CONSTRUCTOR new DS_DECLARATION(KEY_MAX, NO_VALUE, TOTAL_THREADS + 1)
+#define BULK_LOAD_SUPPORTED
+#define BUNDLE_ENTRY_TYPE BundleEntry<node_t<test_type, test_type>>
+#define MEMMGMT_T                                                    \
+  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>, \
+                 BUNDLE_ENTRY_TYPE>
+#define DS_CONSTRUCTOR \
+  new DS_DECLARATION(KEY_MAX, NO_VALUE, TOTAL_THREADS + BUNDLE_CLEANUP_THREADS)
 
 #define INSERT_AND_CHECK_SUCCESS \
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
@@ -453,10 +463,10 @@ rlu_thread_data_t *rlu_tdata = NULL;
   ((DS_DECLARATION *)glob.__ds)->validateBundles(0)       \
       ? std::cout << "Bundle validation OK." << std::endl \
       : std::cout << "Bundle validation failed." << std::endl;
-#define INIT_ALL urcu::init(TOTAL_THREADS + 1);
+#define INIT_ALL urcu::init(TOTAL_THREADS + BUNDLE_CLEANUP_THREADS);
 #define DEINIT_ALL  \
   VALIDATE_BUNDLES; \
-  urcu::deinit(TOTAL_THREADS + 1);
+  urcu::deinit(TOTAL_THREADS + BUNDLE_CLEANUP_THREADS);
 
 #define BUNDLE_OBJ_SIZE (sizeof(BUNDLE_TYPE_DECL<node_t<test_type, test_type>>))
 #define PRINT_OBJ_SIZES                                              \
@@ -465,17 +475,20 @@ rlu_thread_data_t *rlu_tdata = NULL;
        << " including header=" << BUNDLE_OBJ_SIZE << endl;
 
 #elif defined(BUNDLE_BST)
-#define BUNDLE_TYPE_DECL LinkedBundle
 #include "bundle_bst_impl.h"
 #include "record_manager.h"
 using namespace bundle_bst_ns;
 
 #define DS_DECLARATION \
   bundle_bst<test_type, test_type, less<test_type>, MEMMGMT_T>
-#define MEMMGMT_T \
-  record_manager<RECLAIM, ALLOC, POOL, Node<test_type, test_type>>
-#define DS_CONSTRUCTOR \
-  new DS_DECLARATION(KEY_MAX, NO_VALUE, TOTAL_THREADS + 1, SIGQUIT)
+#define BULK_LOAD_SUPPORTED
+#define BUNDLE_ENTRY_TYPE BundleEntry<Node<test_type, test_type>>
+#define MEMMGMT_T                                                  \
+  record_manager<RECLAIM, ALLOC, POOL, Node<test_type, test_type>, \
+                 BUNDLE_ENTRY_TYPE>
+#define DS_CONSTRUCTOR                                                          \
+  new DS_DECLARATION(KEY_MAX, NO_VALUE, TOTAL_THREADS + BUNDLE_CLEANUP_THREADS, \
+                     SIGQUIT)
 
 #define INSERT_AND_CHECK_SUCCESS \
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
@@ -490,10 +503,52 @@ using namespace bundle_bst_ns;
 #define INIT_ALL
 #define DEINIT_ALL
 
-#define BUNDLE_OBJ_SIZE (sizeof(Bundle<node_t<test_type, test_type>>))
+#define BUNDLE_OBJ_SIZE (sizeof(BUNDLE_TYPE_DECL<Node<test_type, test_type>>))
 #define PRINT_OBJ_SIZES                                          \
   cout << "sizes: node=" << (sizeof(Node<test_type, test_type>)) \
        << " descriptor=" << (sizeof(SCXRecord<test_type, test_type>)) << endl;
+
+#elif defined(BUNDLE_ABTREE) || defined(BUNDLE_BSLACK)
+#if defined BUNDLE_ABTREE
+#define USE_SIMPLIFIED_ABTREE_REBALANCING
+#endif
+#define ABTREE_DEGREE 16
+#include "bundle_bslack_impl.h"
+#include "record_manager.h"
+using namespace bundle_bslack_ns;
+
+#define DS_DECLARATION \
+  bundle_bslack<ABTREE_DEGREE, test_type, less<test_type>, MEMMGMT_T>
+#define BULK_LOAD_SUPPORTED
+#define BUNDLE_ENTRY_TYPE BundleEntry<Node<ABTREE_DEGREE, test_type>>
+#define MEMMGMT_T                                                       \
+  record_manager<RECLAIM, ALLOC, POOL, Node<ABTREE_DEGREE, test_type>, \
+                 BUNDLE_ENTRY_TYPE>
+#define DS_CONSTRUCTOR                                                    \
+  new DS_DECLARATION(TOTAL_THREADS + BUNDLE_CLEANUP_THREADS, ABTREE_DEGREE, \
+                     KEY_MAX, SIGQUIT)
+
+// note: INSERT success checks use "== NO_VALUE" so that prefilling can tell
+// that a new KEY has been inserted
+#define INSERT_AND_CHECK_SUCCESS \
+  ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
+#define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key).second
+#define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define RQ_AND_CHECK_SUCCESS(rqcnt)                               \
+  (rqcnt) = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
+                        (VALUE_TYPE *)rqResultValues)
+#define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[(rqcnt)-1]
+#define INIT_THREAD(tid) ds->initThread(tid)
+#define DEINIT_THREAD(tid) ds->deinitThread(tid)
+#define INIT_ALL
+#define DEINIT_ALL
+
+#define BUNDLE_OBJ_SIZE \
+  (sizeof(BUNDLE_TYPE_DECL<Node<ABTREE_DEGREE, test_type>>))
+#define PRINT_OBJ_SIZES                                                   \
+  cout << "sizes: node=" << (sizeof(Node<ABTREE_DEGREE, test_type>))      \
+       << " descriptor=" << (sizeof(SCXRecord<ABTREE_DEGREE, test_type>)) \
+       << endl;
 /*--------------------------------------------------------------------------*/
 #elif defined(UNSAFE_LIST)
 #include "record_manager.h"
@@ -528,6 +583,7 @@ using namespace bundle_bst_ns;
 #include "unsafe_skiplist_impl.h"
 
 #define DS_DECLARATION unsafe_skiplist<test_type, test_type, MEMMGMT_T>
+#define BULK_LOAD_SUPPORTED
 #define MEMMGMT_T \
   record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>>
 #define DS_CONSTRUCTOR \
@@ -555,6 +611,7 @@ using namespace bundle_bst_ns;
 #include "unsafe_citrus_impl.h"
 
 #define DS_DECLARATION unsafe_citrustree<test_type, test_type, MEMMGMT_T>
+#define BULK_LOAD_SUPPORTED
 #define MEMMGMT_T \
   record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>>
 #define DS_CONSTRUCTOR new DS_DECLARATION(KEY_MAX, NO_VALUE, TOTAL_THREADS)
@@ -620,8 +677,9 @@ using namespace vcas_bst_ns;
 using namespace vcas_citrus;
 
 #define DS_DECLARATION citrustree<test_type, test_type, MEMMGMT_T>
-#define MEMMGMT_T \
-  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>>
+#define MEMMGMT_T                                                    \
+  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>, \
+                 vcas_obj_t<node_t<test_type, test_type> *>>
 #define DS_CONSTRUCTOR new DS_DECLARATION(MAXKEY, NO_VALUE, TOTAL_THREADS)
 
 #define INSERT_AND_CHECK_SUCCESS \
@@ -656,9 +714,11 @@ using namespace vcas_citrus;
 using namespace vcas_skiplist_lock;
 
 #define DS_DECLARATION skiplist<test_type, test_type, MEMMGMT_T>
-#define MEMMGMT_T                      \
-  record_manager<RECLAIM, ALLOC, POOL, \
-                 node_t<test_type, test_type> RQ_SNAPCOLLECTOR_OBJECT_TYPES>
+#define MEMMGMT_T                                            \
+  record_manager<RECLAIM, ALLOC, POOL,                       \
+                 node_t<test_type, test_type>,               \
+                 vcas_obj_t<node_t<test_type, test_type> *>, \
+                 vcas_obj_t<long long> RQ_SNAPCOLLECTOR_OBJECT_TYPES>
 #define DS_CONSTRUCTOR \
   new DS_DECLARATION(TOTAL_THREADS, KEY_MIN, KEY_MAX, NO_VALUE, glob.rngs)
 
@@ -691,9 +751,11 @@ using namespace vcas_skiplist_lock;
 using namespace vcas_lockfree_skiplist;
 
 #define DS_DECLARATION skiplist<test_type, test_type, MEMMGMT_T>
-#define MEMMGMT_T                      \
-  record_manager<RECLAIM, ALLOC, POOL, \
-                 node_t<test_type, test_type> RQ_SNAPCOLLECTOR_OBJECT_TYPES>
+#define MEMMGMT_T                                           \
+  record_manager<RECLAIM, ALLOC, POOL,                      \
+                 node_t<test_type, test_type>,              \
+                 vcas_obj_t<node_t<test_type, test_type> *> \
+                     RQ_SNAPCOLLECTOR_OBJECT_TYPES>
 #define DS_CONSTRUCTOR \
   new DS_DECLARATION(TOTAL_THREADS, KEY_MIN, KEY_MAX, NO_VALUE, glob.rngs)
 
@@ -726,9 +788,11 @@ using namespace vcas_lockfree_skiplist;
 using namespace vcas_lockfree_list;
 
 #define DS_DECLARATION list<test_type, test_type, MEMMGMT_T>
-#define MEMMGMT_T                      \
-  record_manager<RECLAIM, ALLOC, POOL, \
-                 node_t<test_type, test_type> RQ_SNAPCOLLECTOR_OBJECT_TYPES>
+#define MEMMGMT_T                                           \
+  record_manager<RECLAIM, ALLOC, POOL,                      \
+                 node_t<test_type, test_type>,              \
+                 vcas_obj_t<node_t<test_type, test_type> *> \
+                     RQ_SNAPCOLLECTOR_OBJECT_TYPES>
 #define DS_CONSTRUCTOR \
   new DS_DECLARATION(TOTAL_THREADS, KEY_MIN, KEY_MAX, NO_VALUE, glob.rngs)
 
@@ -761,8 +825,10 @@ using namespace vcas_lazylist;
 
 #define DS_DECLARATION \
   lazylist<test_type, test_type, MEMMGMT_T>
-#define MEMMGMT_T \
-  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type> >
+#define MEMMGMT_T                                                    \
+  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>, \
+                 vcas_obj_t<node_t<test_type, test_type> *>,         \
+                 vcas_obj_t<long long> >
 #define DS_CONSTRUCTOR \
   new DS_DECLARATION(TOTAL_THREADS, KEY_MIN, KEY_MAX, NO_VALUE)
 
@@ -15,6 +15,8 @@ source ./supported.inc
 ## Abridged experimental configurations (for artifact evaluation)
 # rqtechniques="lockfree rwlock unsafe rlu lbundle vcas"
 rqtechniques="mvccvbr vcas lbundle unsafe lockfree"
+## Bundle layout comparison (linked vs. circular vs. inline entries).
+# rqtechniques="lbundle cbundle ibundle"
 datastructures="skiplist tree list"
 ksizes="1000000 10000"
 
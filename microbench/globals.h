@@ -111,6 +111,14 @@ int TOTAL_THREADS;
           C stat_output_item(PRINT_RAW, MIN, TOTAL) \
           C stat_output_item(PRINT_RAW, MAX, TOTAL) \
     }) \
+    handle_stat(LONG_LONG, latency_deletes, 10000, { \
+            stat_output_item(PRINT_HISTOGRAM_LOG, NONE, FULL_DATA) \
+          C stat_output_item(PRINT_RAW, SUM, TOTAL) \
+          C stat_output_item(PRINT_RAW, AVERAGE, TOTAL) \
+          C stat_output_item(PRINT_RAW, STDEV, TOTAL) \
+          C stat_output_item(PRINT_RAW, MIN, TOTAL) \
+          C stat_output_item(PRINT_RAW, MAX, TOTAL) \
+    }) \
     handle_stat(LONG_LONG, latency_searches, 10000, { \
             stat_output_item(PRINT_HISTOGRAM_LOG, NONE, FULL_DATA) \
           /*C stat_output_item(PRINT_RAW, NONE, FULL_DATA)*/ \
@@ -120,6 +128,26 @@ int TOTAL_THREADS;
           C stat_output_item(PRINT_RAW, MIN, TOTAL) \
           C stat_output_item(PRINT_RAW, MAX, TOTAL) \
     }) \
+    handle_stat(LONG_LONG, node_lock_wait_cycles, 10000, { \
+            stat_output_item(PRINT_HISTOGRAM_LOG, NONE, FULL_DATA) \
+          C stat_output_item(PRINT_RAW, AVERAGE, TOTAL) \
+          C stat_output_item(PRINT_RAW, MAX, TOTAL) \
+    }) \
+    handle_stat(LONG_LONG, node_lock_hold_cycles, 10000, { \
+            stat_output_item(PRINT_HISTOGRAM_LOG, NONE, FULL_DATA) \
+          C stat_output_item(PRINT_RAW, AVERAGE, TOTAL) \
+          C stat_output_item(PRINT_RAW, MAX, TOTAL) \
+    }) \
+    handle_stat(LONG_LONG, rq_restarts, 10000, { \
+            stat_output_item(PRINT_HISTOGRAM_LOG, NONE, FULL_DATA) \
+          C stat_output_item(PRINT_RAW, COUNT, TOTAL) \
+          C stat_output_item(PRINT_RAW, SUM, TOTAL) \
+          C stat_output_item(PRINT_RAW, AVERAGE, TOTAL) \
+          C stat_output_item(PRINT_RAW, MAX, TOTAL) \
+    }) \
+    handle_stat(LONG_LONG, rq_fallbacks, 1, { \
+            stat_output_item(PRINT_RAW, SUM, TOTAL) \
+    }) \
     handle_stat(LONG_LONG, skiplist_inserted_on_level, 30, { \
             /*stat_output_item(PRINT_RAW, NONE, FULL_DATA)*/ \
           /*C stat_output_item(PRINT_RAW, SUM, BY_INDEX)*/ \
@@ -79,8 +79,20 @@ extern int TOTAL_THREADS;
  */
 
 #define RECLAIM reclaimer_debra<test_type>
+#if defined RQ_BUNDLE && defined BUNDLE_CIRCULAR_BUNDLE
+// Circular bundles keep their buffers for as long as the memory of the node
+// they are embedded in, so nodes must be constructed by the allocator.
+#define ALLOC allocator_new<test_type>
+#else
 #define ALLOC allocator_new_segregated<test_type>
+#endif
+#ifdef RQ_BUNDLE
+// Bundle entries (and nodes) are recycled through per-thread pools so that
+// updates do not call malloc/free when preparing bundles.
+#define POOL pool_perthread_and_shared<test_type>
+#else
 #define POOL pool_none<test_type>
+#endif
 
 #endif	/* GLOBALS_EXTERN_H */
 
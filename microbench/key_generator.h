@@ -0,0 +1,282 @@
+/*
+ * File:   key_generator.h
+ *
+ * Key distributions for the microbenchmark. Every thread draws the keys of its
+ * operations from a KeyGenerator, and all generators share one KeyDistribution
+ * holding the parameters chosen on the command line:
+ *
+ *   uniform     every key in [0, MAXKEY) is equally likely (the default).
+ *   zipf        the key of rank r is drawn with probability proportional to
+ *               1 / (r+1)^theta. as in YCSB's ScrambledZipfian, ranks are
+ *               hashed into the key range, so the hottest keys are spread over
+ *               the data structure instead of sitting together at its front
+ *               (-noscramble uses rank r as key r).
+ *   hotspot     a fraction hotops of the operations go to the first hotset
+ *               fraction of the key range, and the rest to the remainder.
+ *   sequential  inserts take monotonically increasing keys (wrapping around
+ *               at MAXKEY) and every other operation is uniform. prefilling
+ *               inserts the keys below the first sequential key (see
+ *               startSequentialAt), so inserts add new keys until they wrap.
+ *   latest      inserts are sequential and every other operation picks a key
+ *               zipf-distributed behind the most recently inserted key, as in
+ *               the YCSB "latest" distribution.
+ *
+ * Drawing a zipf key needs a call to pow(), which would cost more than many of
+ * the operations being measured, so each generator precomputes a table of
+ * KEYGEN_TABLE_SIZE zipf ranks before the trial starts and cycles through it,
+ * jumping to a random position whenever it wraps around.
+ *
+ * Sequential keys are handed out in blocks of KEYGEN_SEQUENTIAL_BLOCK from a
+ * shared counter, so threads rarely contend on it and inserts are monotonic
+ * up to the interleaving of blocks.
+ */
+
+#ifndef KEY_GENERATOR_H
+#define KEY_GENERATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include "plaf.h"
+#include "random.h"
+
+// Number of precomputed zipf ranks per generator.
+#ifndef KEYGEN_TABLE_SIZE
+#define KEYGEN_TABLE_SIZE (1 << 16)
+#endif
+
+// Number of sequential keys a thread reserves at once.
+#ifndef KEYGEN_SEQUENTIAL_BLOCK
+#define KEYGEN_SEQUENTIAL_BLOCK 64
+#endif
+
+enum key_dist_t {
+    KEY_DIST_UNIFORM,
+    KEY_DIST_ZIPF,
+    KEY_DIST_HOTSPOT,
+    KEY_DIST_SEQUENTIAL,
+    KEY_DIST_LATEST,
+    KEY_DIST_INVALID
+};
+
+inline const char *key_dist_name(const key_dist_t dist) {
+    switch (dist) {
+        case KEY_DIST_UNIFORM: return "uniform";
+        case KEY_DIST_ZIPF: return "zipf";
+        case KEY_DIST_HOTSPOT: return "hotspot";
+        case KEY_DIST_SEQUENTIAL: return "sequential";
+        case KEY_DIST_LATEST: return "latest";
+        default: return "invalid";
+    }
+}
+
+inline key_dist_t key_dist_from_name(const char *name) {
+    for (int i = 0; i < KEY_DIST_INVALID; ++i) {
+        if (strcmp(name, key_dist_name((key_dist_t)i)) == 0) {
+            return (key_dist_t)i;
+        }
+    }
+    return KEY_DIST_INVALID;
+}
+
+inline bool key_dist_uses_zipf(const key_dist_t dist) {
+    return dist == KEY_DIST_ZIPF || dist == KEY_DIST_LATEST;
+}
+
+class KeyDistribution {
+public:
+    key_dist_t dist;    // keys of inserts, deletes and searches
+    key_dist_t rqdist;  // first keys of range queries
+    double theta;
+    double hotset;
+    double hotops;
+    bool scramble;  // hash zipf ranks into the key range
+
+private:
+    int maxkey;
+    // constants of the zipf generator of Gray et al. ("Quickly generating
+    // billion-record synthetic databases"), also used by YCSB
+    double zetan;
+    double alpha;
+    double eta;
+    double zeta2theta;
+    int hotkeys;
+    unsigned hotthreshold;
+
+    volatile char padding0[PREFETCH_SIZE_BYTES];
+    std::atomic<long long> sequential;  // next sequential key to hand out
+    volatile char padding1[PREFETCH_SIZE_BYTES];
+
+public:
+    KeyDistribution() {
+        dist = KEY_DIST_UNIFORM;
+        rqdist = KEY_DIST_UNIFORM;
+        theta = 0.99;
+        hotset = 0.2;
+        hotops = 0.8;
+        scramble = true;
+        maxkey = 1;
+        sequential = 0;
+    }
+
+    // must be called once the parameters are set and before any generator is
+    // created. returns false if the parameters are invalid.
+    bool init(const int _maxkey) {
+        maxkey = _maxkey;
+        sequential = 0;
+        if (maxkey < 2 || hotset <= 0 || hotset >= 1 || hotops < 0 || hotops > 1) {
+            return false;
+        }
+        hotkeys = std::max(1, std::min(maxkey - 1, (int) (maxkey * hotset)));
+        hotthreshold = (unsigned) (hotops * 4294967295.);
+        if (key_dist_uses_zipf(dist) || key_dist_uses_zipf(rqdist)) {
+            if (theta <= 0 || theta >= 1) {
+                return false;
+            }
+            zetan = 0;
+            for (int i = 1; i <= maxkey; ++i) {
+                zetan += 1 / pow((double) i, theta);
+            }
+            zeta2theta = 1 + pow(0.5, theta);
+            alpha = 1 / (1 - theta);
+            eta = (1 - pow(2. / maxkey, 1 - theta)) / (1 - zeta2theta / zetan);
+        }
+        return true;
+    }
+
+    inline int getMaxKey() { return maxkey; }
+
+    // returns a rank in [0, maxkey) where rank 0 is the most likely. slow.
+    int nextZipf(Random *rng) {
+        const double u = rng->nextNatural() / 4294967296.;
+        const double uz = u * zetan;
+        if (uz < 1) return 0;
+        if (uz < zeta2theta) return 1;
+        const int rank = (int) (maxkey * pow(eta * u - eta + 1, alpha));
+        return std::min(std::max(rank, 0), maxkey - 1);
+    }
+
+    // maps a zipf rank to its key: the 64-bit FNV hash of the rank, as in
+    // YCSB, modulo maxkey
+    inline int scrambleRank(const int rank) {
+        if (!scramble) return rank;
+        unsigned long long h = 0xCBF29CE484222325ULL;
+        unsigned long long v = (unsigned long long) rank;
+        for (int i = 0; i < 8; ++i) {
+            h ^= v & 0xff;
+            h *= 1099511628211ULL;
+            v >>= 8;
+        }
+        return (int) (h % (unsigned long long) maxkey);
+    }
+
+    inline int nextHotspot(Random *rng) {
+        if (rng->nextNatural() <= hotthreshold) {
+            return rng->nextNatural(hotkeys);
+        }
+        return hotkeys + rng->nextNatural(maxkey - hotkeys);
+    }
+
+    // true if prefilling should insert exactly the keys below the first
+    // sequential key, rather than a random subset of the whole key range
+    inline bool prefillsBelowSequential() {
+        return dist == KEY_DIST_SEQUENTIAL || dist == KEY_DIST_LATEST;
+    }
+
+    // must be called before any generator hands out a sequential key
+    void startSequentialAt(const long long key) {
+        sequential = key;
+    }
+
+    // reserves n consecutive sequential keys and returns the first one
+    inline long long reserveSequential(const int n) {
+        return sequential.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // returns (an upper bound on) the next sequential key to be inserted
+    inline long long frontier() {
+        return sequential.load(std::memory_order_relaxed);
+    }
+};
+
+class KeyGenerator {
+private:
+    KeyDistribution * const d;
+    Random * const rng;
+    const int maxkey;
+    int *zipf;  // precomputed ranks, or NULL if no distribution needs them
+    int zipfix;
+    long long seq;     // next key of the reserved block
+    long long seqend;  // one past the reserved block
+
+    inline int nextRank() {
+        if (zipfix == KEYGEN_TABLE_SIZE) {
+            zipfix = rng->nextNatural(KEYGEN_TABLE_SIZE);
+        }
+        return zipf[zipfix++];
+    }
+
+    inline int draw(const key_dist_t dist) {
+        switch (dist) {
+            case KEY_DIST_ZIPF:
+                return d->scrambleRank(nextRank());
+            case KEY_DIST_HOTSPOT:
+                return d->nextHotspot(rng);
+            case KEY_DIST_LATEST: {
+                const long long key = d->frontier() - 1 - nextRank();
+                return (int) (((key % maxkey) + maxkey) % maxkey);
+            }
+            default:  // uniform, and sequential for everything but inserts
+                return rng->nextNatural(maxkey);
+        }
+    }
+
+public:
+    // rng must be the caller's own generator. the table is filled here so that
+    // it is allocated and first touched by the thread that uses it.
+    KeyGenerator(KeyDistribution * const _d, Random * const _rng)
+            : d(_d), rng(_rng), maxkey(_d->getMaxKey()), zipf(NULL), zipfix(0),
+              seq(0), seqend(0) {
+        if (key_dist_uses_zipf(d->dist) || key_dist_uses_zipf(d->rqdist)) {
+            zipf = new int[KEYGEN_TABLE_SIZE];
+            for (int i = 0; i < KEYGEN_TABLE_SIZE; ++i) {
+                zipf[i] = d->nextZipf(rng);
+            }
+            zipfix = rng->nextNatural(KEYGEN_TABLE_SIZE);
+        }
+    }
+
+    ~KeyGenerator() {
+        if (zipf) delete[] zipf;
+    }
+
+    // returns the key of a delete or search
+    inline int next() {
+        return draw(d->dist);
+    }
+
+    // returns the key of an insert
+    inline int nextInsert() {
+        if (d->dist != KEY_DIST_SEQUENTIAL && d->dist != KEY_DIST_LATEST) {
+            return draw(d->dist);
+        }
+        if (seq == seqend) {
+            seq = d->reserveSequential(KEYGEN_SEQUENTIAL_BLOCK);
+            seqend = seq + KEYGEN_SEQUENTIAL_BLOCK;
+        }
+        return (int) (seq++ % maxkey);
+    }
+
+    // returns the first key of a range query of rqsize keys
+    inline int nextRangeStart(const int rqsize) {
+        const int n = std::max(1, maxkey - rqsize);
+        if (d->rqdist == KEY_DIST_UNIFORM || d->rqdist == KEY_DIST_SEQUENTIAL) {
+            return rng->nextNatural(n);
+        }
+        return draw(d->rqdist) % n;
+    }
+};
+
+#endif /* KEY_GENERATOR_H */
@@ -0,0 +1,153 @@
+/*
+ * File:   latency_histogram.h
+ *
+ * Per-thread latency histograms for the microbenchmark. The gstats latency
+ * stats only keep the first samples each thread appends (up to the capacity
+ * of the stat), so they cannot report tail latencies over a whole trial. A
+ * LatencyHistogram instead counts every operation in a fixed set of buckets,
+ * in the style of HdrHistogram:
+ *
+ *   values below 2^LATENCY_HISTOGRAM_SUB_BITS have a bucket each, and every
+ *   larger power-of-two range [2^m, 2^(m+1)) is split into
+ *   2^LATENCY_HISTOGRAM_SUB_BITS equal buckets,
+ *
+ * so a recorded value is off by less than 2^-LATENCY_HISTOGRAM_SUB_BITS of
+ * itself (about 3% by default), whatever its magnitude. Recording is a count
+ * leading zeros, a shift and an increment of a counter that only its owner
+ * writes. Histograms of different threads are merged by adding their buckets
+ * once the trial is over.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// Number of bits of precision kept for every value.
+#ifndef LATENCY_HISTOGRAM_SUB_BITS
+#define LATENCY_HISTOGRAM_SUB_BITS 5
+#endif
+
+#define LATENCY_HISTOGRAM_SUB_BUCKETS (1 << LATENCY_HISTOGRAM_SUB_BITS)
+#define LATENCY_HISTOGRAM_BUCKETS \
+    ((64 - LATENCY_HISTOGRAM_SUB_BITS + 1) * LATENCY_HISTOGRAM_SUB_BUCKETS)
+
+// Operation types whose latencies are recorded. Deletes are also recorded as
+// updates, as in the gstats latency stats.
+enum latency_op_t {
+    LATENCY_UPDATES,
+    LATENCY_DELETES,
+    LATENCY_SEARCHES,
+    LATENCY_RQS,
+    LATENCY_NUM_OPS
+};
+
+inline const char *latency_op_name(const latency_op_t op) {
+    switch (op) {
+        case LATENCY_UPDATES: return "updates";
+        case LATENCY_DELETES: return "deletes";
+        case LATENCY_SEARCHES: return "searches";
+        case LATENCY_RQS: return "rqs";
+        default: return "invalid";
+    }
+}
+
+class LatencyHistogram {
+private:
+    long long counts[LATENCY_HISTOGRAM_BUCKETS];
+    long long total;
+    long long sum;
+    unsigned long long maxValue;
+
+    static inline int bucketOf(const unsigned long long value) {
+        if (value < LATENCY_HISTOGRAM_SUB_BUCKETS) {
+            return (int) value;
+        }
+        const int shift = 63 - __builtin_clzll(value) - LATENCY_HISTOGRAM_SUB_BITS;
+        return (shift + 1) * LATENCY_HISTOGRAM_SUB_BUCKETS
+                + (int) ((value >> shift) & (LATENCY_HISTOGRAM_SUB_BUCKETS - 1));
+    }
+
+    // returns the largest value that falls in bucket b
+    static inline unsigned long long highestIn(const int b) {
+        if (b < LATENCY_HISTOGRAM_SUB_BUCKETS) {
+            return b;
+        }
+        const int shift = b / LATENCY_HISTOGRAM_SUB_BUCKETS - 1;
+        const unsigned long long lowest = (unsigned long long)
+                (LATENCY_HISTOGRAM_SUB_BUCKETS + b % LATENCY_HISTOGRAM_SUB_BUCKETS) << shift;
+        return lowest + ((1ULL << shift) - 1);
+    }
+
+public:
+    LatencyHistogram() {
+        clear();
+    }
+
+    void clear() {
+        memset(counts, 0, sizeof(counts));
+        total = 0;
+        sum = 0;
+        maxValue = 0;
+    }
+
+    inline void record(const unsigned long long value) {
+        ++counts[bucketOf(value)];
+        ++total;
+        sum += value;
+        if (value > maxValue) maxValue = value;
+    }
+
+    // adds every value recorded by other to this histogram
+    void merge(const LatencyHistogram &other) {
+        for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    inline long long count() const { return total; }
+    inline unsigned long long max() const { return maxValue; }
+    inline double mean() const { return total ? sum / (double) total : 0; }
+
+    // returns (an upper bound within the precision of the histogram on) the
+    // smallest value that is at least as large as p percent of the values.
+    unsigned long long percentile(const double p) const {
+        if (total == 0) return 0;
+        long long rank = (long long) ceil(p / 100. * total);
+        rank = std::min(std::max(rank, 1LL), total);
+        long long seen = 0;
+        for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(highestIn(i), maxValue);
+            }
+        }
+        return maxValue;
+    }
+};
+
+// Prints one CSV row per operation type (preceded by a header row), each row
+// starting with "latency_percentiles," so that it can be picked out of the
+// rest of the output. Values are in the unit of the recorded latencies.
+inline void latency_print_csv(std::ostream &out, LatencyHistogram *const merged) {
+    out << "latency_percentiles,op,count,mean,p50,p90,p99,p99.9,max" << std::endl;
+    for (int op = 0; op < LATENCY_NUM_OPS; ++op) {
+        const LatencyHistogram &h = merged[op];
+        out << "latency_percentiles," << latency_op_name((latency_op_t) op)
+            << "," << h.count()
+            << "," << (long long) h.mean()
+            << "," << h.percentile(50)
+            << "," << h.percentile(90)
+            << "," << h.percentile(99)
+            << "," << h.percentile(99.9)
+            << "," << h.max() << std::endl;
+    }
+}
+
+#endif /* LATENCY_HISTOGRAM_H */
@@ -27,10 +27,14 @@ typedef long long test_type;
 #include <chrono>
 #include <cstring>
 #include <ctime>
+#include <fstream>
 #include <limits>
+#include <unistd.h>
 #include "binding.h"
 #include "globals.h"
 #include "globals_extern.h"
+#include "key_generator.h"
+#include "latency_histogram.h"
 #include "papi_util_impl.h"
 #include "plaf.h"
 #include "random.h"
@@ -53,6 +57,7 @@ struct main_globals_t {
     // number generators (padded
     // to avoid false sharing)
     volatile char padding1[PREFETCH_SIZE_BYTES];
+    KeyDistribution keydist;  // distributions of the keys of operations
 
     // variables used in the concurrent test
     volatile char padding2[PREFETCH_SIZE_BYTES];
@@ -85,6 +90,19 @@ struct main_globals_t {
     volatile char padding10[PREFETCH_SIZE_BYTES];
     long long prefillKeySum;
     volatile char padding11[PREFETCH_SIZE_BYTES];
+    // per-thread latency histograms, one per operation type, allocated by
+    // the threads that record them
+    LatencyHistogram *latencies[MAX_TID_POW2];
+    volatile char padding12[PREFETCH_SIZE_BYTES];
+    // time series sampling (disabled if sampleMillis is 0)
+    int sampleMillis;
+    const char *sampleFile;  // NULL to print samples with the rest of the output
+    volatile char padding13[PREFETCH_SIZE_BYTES];
+    // prefill by bulk loading the data structure (see prefillBulk)
+    bool prefillBulk;
+#ifdef BULK_LOAD_SUPPORTED
+    DS_DECLARATION::BulkLoadPart *bulkLoadParts;  // one per prefilling thread
+#endif
 };
 
 main_globals_t glob = {
@@ -108,6 +126,18 @@ const long long PREFILL_INTERVAL_MILLIS = 100;
 #define RQS_BETWEEN_TIME_CHECKS 10
 #endif
 
+// appends the latency of the operation that just completed to a gstats stat
+// and records it in the calling thread's histogram for op
+#ifdef USE_GSTATS
+#define RECORD_LATENCY(tid, stat, op) { \
+    const long long __elapsed = GSTATS_TIMER_ELAPSED(tid, timer_latency); \
+    GSTATS_APPEND(tid, stat, __elapsed); \
+    latencies[(op)].record(__elapsed); \
+}
+#else
+#define RECORD_LATENCY(tid, stat, op)
+#endif
+
 #ifdef USE_DEBUGCOUNTERS
 #define GET_COUNTERS ds->debugGetCounters()
 #define CLEAR_COUNTERS ds->clearCounters();
@@ -124,6 +154,13 @@ void *thread_prefill(void *_id) {
     test_type garbage = 0;
 
     double insProbability = (INS > 0 ? 100 * INS / (INS + DEL) : 50.);
+    // with sequential inserts, only insert the keys below the first sequential
+    // key (see prefill)
+    int prefillKeys = MAXKEY;
+    if (glob.keydist.prefillsBelowSequential()) {
+        prefillKeys = (int) glob.keydist.frontier();
+        insProbability = 100.;
+    }
 
     INIT_THREAD(tid);
     glob.running.fetch_add(1);
@@ -148,7 +185,7 @@ void *thread_prefill(void *_id) {
 
         VERBOSE if (cnt && ((cnt % 1000000) == 0))
             COUTATOMICTID("op# " << cnt << endl);
-        int key = rng->nextNatural(MAXKEY);
+        int key = rng->nextNatural(prefillKeys);
         double op = rng->nextNatural(100000000) / 1000000.;
         GSTATS_TIMER_RESET(tid, timer_latency);
         if (op < insProbability) {
@@ -196,6 +233,114 @@ void *thread_prefill(void *_id) {
     pthread_exit(NULL);
 }
 
+#ifdef BULK_LOAD_SUPPORTED
+// builds the part of the data structure holding the keys in this thread's
+// share of the key range, each of which is present with probability
+// expectedFullness (the same distribution of keys that prefilling with
+// random updates converges to), or, with sequential inserts, exactly the keys
+// below the first sequential key
+void *thread_prefill_bulk(void *_id) {
+    int tid = *((int *)_id);
+    binding_bindThread(tid, LOGICAL_PROCESSORS);
+    Random *rng = &glob.rngs[tid * PREFETCH_SIZE_WORDS];
+    DS_DECLARATION *ds = (DS_DECLARATION *)glob.__ds;
+
+    const double expectedFullness =
+            (INS + DEL ? INS / (double)(INS + DEL) : 0.5);
+    const unsigned long long threshold =
+            (unsigned long long)(expectedFullness * 4294967296.);
+    const test_type lo = (test_type)MAXKEY * tid / TOTAL_THREADS;
+    const test_type hi = (test_type)MAXKEY * (tid + 1) / TOTAL_THREADS;
+    test_type *keys = new test_type[hi - lo];
+    VALUE_TYPE *values = new VALUE_TYPE[hi - lo];
+    int n = 0;
+    for (test_type key = lo; key < hi; ++key) {
+        if (glob.keydist.prefillsBelowSequential()
+                ? key < glob.keydist.frontier()
+                : rng->nextNatural() < threshold) {
+            keys[n] = key;
+            values[n] = VALUE;
+            ++n;
+            GSTATS_ADD(tid, key_checksum, key);
+#ifdef USE_DEBUGCOUNTERS
+            glob.keysum->add(tid, key);
+            glob.prefillSize->add(tid, 1);
+#endif
+        }
+    }
+    GSTATS_ADD(tid, prefill_size, n);
+
+    INIT_THREAD(tid);
+    glob.bulkLoadParts[tid] = ds->bulkLoadPart(tid, keys, values, n);
+    DEINIT_THREAD(tid);
+
+    delete[] keys;
+    delete[] values;
+    pthread_exit(NULL);
+}
+
+// fills the data structure in a single pass: every thread builds the nodes of
+// a contiguous share of the key range, then the main thread links the parts
+void prefillBulk(DS_DECLARATION *ds) {
+    chrono::time_point<chrono::high_resolution_clock> prefillStartTime =
+            chrono::high_resolution_clock::now();
+    const double expectedFullness =
+            (INS + DEL ? INS / (double)(INS + DEL) : 0.5);
+    const int expectedSize = (int)(MAXKEY * expectedFullness);
+
+    INIT_ALL;
+    glob.bulkLoadParts = new DS_DECLARATION::BulkLoadPart[TOTAL_THREADS];
+    pthread_t *threads = new pthread_t[TOTAL_THREADS];
+    int *ids = new int[TOTAL_THREADS];
+    for (int i = 0; i < TOTAL_THREADS; ++i) {
+        ids[i] = i;
+        if (pthread_create(&threads[i], NULL, thread_prefill_bulk, &ids[i])) {
+            cerr << "ERROR: could not create thread" << endl;
+            exit(-1);
+        }
+    }
+    for (int i = 0; i < TOTAL_THREADS; ++i) {
+        if (pthread_join(threads[i], NULL)) {
+            cerr << "ERROR: could not join prefilling thread" << endl;
+            exit(-1);
+        }
+    }
+    const int tid = 0;
+    INIT_THREAD(tid);
+    ds->bulkLoadFinish(tid, glob.bulkLoadParts, TOTAL_THREADS);
+    DEINIT_THREAD(tid);
+    delete[] glob.bulkLoadParts;
+    glob.bulkLoadParts = NULL;
+    delete[] threads;
+    delete[] ids;
+    DEINIT_ALL;
+
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(
+            chrono::high_resolution_clock::now() - prefillStartTime)
+                           .count();
+
+#ifdef USE_DEBUGCOUNTERS
+    const long long sz = glob.prefillSize->getTotal();
+    COUTATOMIC("finished bulk loading to size "
+            << sz << " for expected size " << expectedSize
+            << " keysum=" << glob.keysum->getTotal()
+            << " dskeysum=" << ds->debugKeySum() << " dssize=" << ds->getSize()
+            << " in " << (elapsed / 1000.) << "s" << endl);
+    CLEAR_COUNTERS;
+#endif
+#ifdef USE_GSTATS
+    const long long sz = GSTATS_OBJECT_NAME.get_sum<long long>(prefill_size);
+    glob.prefillKeySum = GSTATS_OBJECT_NAME.get_sum<long long>(key_checksum);
+    COUTATOMIC("finished bulk loading to size "
+            << sz << " for expected size " << expectedSize
+            << " keysum=" << glob.prefillKeySum
+            << " dskeysum=" << ds->debugKeySum() << " dssize=" << ds->getSize()
+            << " in " << (elapsed / 1000.) << "s" << endl);
+    GSTATS_CLEAR_ALL;
+#endif
+}
+#endif
+
 void prefill(DS_DECLARATION *ds) {
     chrono::time_point<chrono::high_resolution_clock> prefillStartTime =
             chrono::high_resolution_clock::now();
@@ -388,6 +533,10 @@ void *thread_timed(void *_id) {
     VALUE_TYPE *rqResultValues =
             new VALUE_TYPE[RQSIZE + RQ_DEBUGGING_MAX_KEYS_PER_NODE];
 
+    KeyGenerator keys(&glob.keydist, rng);
+    LatencyHistogram *latencies = new LatencyHistogram[LATENCY_NUM_OPS];
+    glob.latencies[tid] = latencies;
+
     INIT_THREAD(tid);
     papi_create_eventset(tid);
     glob.running.fetch_add(1);
@@ -471,24 +620,28 @@ void *thread_timed(void *_id) {
 
         VERBOSE if (cnt && ((cnt % 1000000) == 0))
             COUTATOMICTID("op# " << cnt << endl);
-        int key = rng->nextNatural(MAXKEY);
+        int key;
         double op = rng->nextNatural(100000000) / 1000000.;
         if (op < INS) {
+            key = keys.nextInsert();
             GSTATS_TIMER_RESET(tid, timer_latency);
             if (INSERT_AND_CHECK_SUCCESS) {
                 GSTATS_ADD(tid, key_checksum, key);
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+            RECORD_LATENCY(tid, latency_updates, LATENCY_UPDATES);
             GSTATS_ADD(tid, num_updates, 1);
         } else if (op < INS + DEL) {
+            key = keys.next();
             GSTATS_TIMER_RESET(tid, timer_latency);
             if (DELETE_AND_CHECK_SUCCESS) {
                 GSTATS_ADD(tid, key_checksum, -key);
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_updates);
+            // deletes are also counted as updates
+            RECORD_LATENCY(tid, latency_deletes, LATENCY_DELETES);
+            RECORD_LATENCY(tid, latency_updates, LATENCY_UPDATES);
             GSTATS_ADD(tid, num_updates, 1);
         } else if (op < INS + DEL + RQ) {
-            unsigned _key = rng->nextNatural() % max(1, MAXKEY - RQSIZE);
+            unsigned _key = keys.nextRangeStart(RQSIZE);
             assert(_key >= 0);
             assert(_key < MAXKEY);
             assert(_key < max(1, MAXKEY - RQSIZE));
@@ -502,14 +655,15 @@ void *thread_timed(void *_id) {
                 // being optimized out
                 garbage += RQ_GARBAGE(rqcnt);
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_rqs);
+            RECORD_LATENCY(tid, latency_rqs, LATENCY_RQS);
             GSTATS_ADD(tid, num_rq, 1);
             GSTATS_ADD_IX(tid, length_rqs, rqcnt, GSTATS_GET(tid, num_rq));
         } else {
+            key = keys.next();
             GSTATS_TIMER_RESET(tid, timer_latency);
             if (FIND_AND_CHECK_SUCCESS) {
             }
-            GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_searches);
+            RECORD_LATENCY(tid, latency_searches, LATENCY_SEARCHES);
             GSTATS_ADD(tid, num_searches, 1);
         }
         GSTATS_ADD(tid, num_operations, 1);
@@ -541,6 +695,10 @@ void *thread_rq(void *_id) {
     VALUE_TYPE *rqResultValues =
             new VALUE_TYPE[RQSIZE + RQ_DEBUGGING_MAX_KEYS_PER_NODE];
 
+    KeyGenerator keys(&glob.keydist, rng);
+    LatencyHistogram *latencies = new LatencyHistogram[LATENCY_NUM_OPS];
+    glob.latencies[tid] = latencies;
+
     INIT_THREAD(tid);
     papi_create_eventset(tid);
     glob.running.fetch_add(1);
@@ -567,7 +725,7 @@ void *thread_rq(void *_id) {
 
         VERBOSE if (cnt && ((cnt % 1000000) == 0))
             COUTATOMICTID("op# " << cnt << endl);
-        unsigned _key = rng->nextNatural() % max(1, MAXKEY - RQSIZE);
+        unsigned _key = keys.nextRangeStart(RQSIZE);
         assert(_key >= 0);
         assert(_key < MAXKEY);
         assert(_key < max(1, MAXKEY - RQSIZE));
@@ -585,7 +743,7 @@ void *thread_rq(void *_id) {
             GET_COUNTERS->rqFail->inc(tid);
 #endif
         }
-        GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_rqs);
+        RECORD_LATENCY(tid, latency_rqs, LATENCY_RQS);
         GSTATS_ADD(tid, num_rq, 1);
         GSTATS_ADD_IX(tid, length_rqs, rqcnt, GSTATS_GET(tid, num_rq));
         GSTATS_ADD(tid, num_operations, 1);
@@ -603,6 +761,125 @@ void *thread_rq(void *_id) {
     pthread_exit(NULL);
 }
 
+// returns the resident set size of the process in bytes
+long long getResidentBytes() {
+    long long pages = 0, residentPages = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f == NULL) return 0;
+    if (fscanf(f, "%lld %lld", &pages, &residentPages) != 2) residentPages = 0;
+    fclose(f);
+    return residentPages * sysconf(_SC_PAGESIZE);
+}
+
+// every glob.sampleMillis milliseconds of the trial, records the throughput of
+// each operation type over the last interval, the average length of the
+// bundles updated in that interval, the number of retired records waiting in
+// epoch bags, the megabytes of retired and pooled records and the resident set
+// size, followed (with bundles) by a histogram of the bundle lengths sampled in
+// that interval. bundle lengths are only sampled by builds with
+// -DBUNDLE_SAMPLE_LENGTHS; otherwise their average is 0 and the histogram is
+// left out. the sampler only reads counters that other threads update, so it
+// does not register with the data structure.
+void *thread_sampler(void *unused) {
+    DS_DECLARATION *ds = (DS_DECLARATION *)glob.__ds;
+    MEMMGMT_T *recmgr = (MEMMGMT_T *)ds->debugGetRecMgr();
+
+    ofstream file;
+    if (glob.sampleFile) {
+        file.open(glob.sampleFile);
+        if (!file) {
+            cerr << "ERROR: could not open sample file " << glob.sampleFile << endl;
+            exit(-1);
+        }
+    }
+    // rows printed with the rest of the output are prefixed so that they can
+    // be picked out of it
+    const string prefix = (glob.sampleFile ? "" : "timeseries,");
+    ostream &out = (glob.sampleFile ? (ostream &)file : cout);
+    stringstream ss;
+    ss << prefix << "elapsed_ms,update_thruput,find_thruput,rq_thruput,tot_thruput,"
+       << "avg_bundle_size,retired_records,retired_mb,pooled_mb,rss_mb";
+#if defined RQ_BUNDLE && defined BUNDLE_SAMPLE_LENGTHS
+    for (int b = 0; b < BUNDLE_LENGTH_HISTOGRAM_BUCKETS; ++b) {
+        ss << ",len_" << BundleLengthHistogram::bucketName(b);
+    }
+#endif
+    ss << endl;
+    out << ss.str() << flush;
+
+    while (!glob.start) {
+        __sync_synchronize();
+    }
+    long long prevOps[3] = {0, 0, 0};  // updates, searches and rqs
+#if defined RQ_BUNDLE && defined BUNDLE_SAMPLE_LENGTHS
+    long long prevLengthSum = 0, prevLengthCount = 0;
+    BundleLengthHistogram prevHistogram, histogram;
+#endif
+    long long prevMillis = 0;
+    for (long long next = glob.sampleMillis; !glob.done; next += glob.sampleMillis) {
+        const long long sleepMillis = next
+                - chrono::duration_cast<chrono::milliseconds>(
+                        chrono::high_resolution_clock::now() - glob.startTime).count();
+        if (sleepMillis > 0) {
+            timespec ts;
+            ts.tv_sec = sleepMillis / 1000;
+            ts.tv_nsec = (sleepMillis % 1000) * ((__syscall_slong_t)1000000);
+            nanosleep(&ts, NULL);
+        }
+        if (glob.done) break;
+        const long long millis = chrono::duration_cast<chrono::milliseconds>(
+                chrono::high_resolution_clock::now() - glob.startTime).count();
+
+        long long ops[3] = {0, 0, 0};
+#ifdef USE_GSTATS
+        for (int tid = 0; tid < TOTAL_THREADS; ++tid) {
+            ops[0] += GSTATS_GET(tid, num_updates);
+            ops[1] += GSTATS_GET(tid, num_searches);
+            ops[2] += GSTATS_GET(tid, num_rq);
+        }
+#endif
+        double avgBundleSize = 0;
+#if defined RQ_BUNDLE && defined BUNDLE_SAMPLE_LENGTHS
+        long long lengthSum, lengthCount;
+        ds->getBundleLengthSamples(lengthSum, lengthCount);
+        if (lengthCount > prevLengthCount) {
+            avgBundleSize = (lengthSum - prevLengthSum)
+                    / (double) (lengthCount - prevLengthCount);
+        }
+        prevLengthSum = lengthSum;
+        prevLengthCount = lengthCount;
+        histogram.clear();
+        ds->getBundleLengthHistogram(histogram);
+#endif
+        const long long retired = (recmgr ? recmgr->getApproxRetired() : 0);
+        const double retiredMB = (recmgr ? recmgr->getApproxRetiredBytes() : 0) / 1000000.;
+        const double pooledMB = (recmgr ? recmgr->getApproxPooledBytes() : 0) / 1000000.;
+
+        const double seconds = max(1LL, millis - prevMillis) / 1000.;
+        long long thruput[3];
+        for (int i = 0; i < 3; ++i) {
+            thruput[i] = (long long) ((ops[i] - prevOps[i]) / seconds);
+            prevOps[i] = ops[i];
+        }
+        prevMillis = millis;
+
+        ss.str("");
+        ss << prefix << millis << "," << thruput[0] << "," << thruput[1] << ","
+           << thruput[2] << "," << (thruput[0] + thruput[1] + thruput[2]) << ","
+           << avgBundleSize << "," << retired << "," << retiredMB << ","
+           << pooledMB << "," << (getResidentBytes() / 1000000.);
+#if defined RQ_BUNDLE && defined BUNDLE_SAMPLE_LENGTHS
+        for (int b = 0; b < BUNDLE_LENGTH_HISTOGRAM_BUCKETS; ++b) {
+            ss << "," << (histogram.counts[b] - prevHistogram.counts[b]);
+        }
+        prevHistogram = histogram;
+#endif
+        ss << endl;
+        out << ss.str() << flush;
+    }
+    pthread_exit(NULL);
+}
+
 void trial() {
     INIT_ALL;
     papi_init_program(TOTAL_THREADS);
@@ -632,6 +909,19 @@ void trial() {
 
     DEINIT_ALL;
 
+    // sequential inserts start right after the keys that prefilling inserts,
+    // instead of at key 0 of a structure whose keys are spread over the whole
+    // range (where about half of them would fail)
+    if (PREFILL && glob.keydist.prefillsBelowSequential()) {
+        const double expectedFullness =
+                (INS + DEL ? INS / (double)(INS + DEL) : 0.5);
+        glob.keydist.startSequentialAt((long long)(MAXKEY * expectedFullness));
+    }
+
+#ifdef BULK_LOAD_SUPPORTED
+    if (PREFILL && glob.prefillBulk) prefillBulk((DS_DECLARATION *)glob.__ds);
+    else
+#endif
     if (PREFILL) prefill((DS_DECLARATION *)glob.__ds);
 
     INIT_ALL;
@@ -645,6 +935,12 @@ void trial() {
     tsNap.tv_sec = 0;
     tsNap.tv_nsec = 10000000;  // 10ms
 
+    pthread_t sampler;
+    if (glob.sampleMillis > 0 && pthread_create(&sampler, NULL, thread_sampler, NULL)) {
+        cerr << "ERROR: could not create sampler thread" << endl;
+        exit(-1);
+    }
+
     // start all threads. All worker threads are scheduled first, then range query
     // threads.
     for (int i = 0; i < TOTAL_THREADS; ++i) {
@@ -747,6 +1043,10 @@ void trial() {
             exit(-1);
         }
     }
+    if (glob.sampleMillis > 0 && pthread_join(sampler, NULL)) {
+        cerr << "ERROR: could not join sampler thread" << endl;
+        exit(-1);
+    }
 
 
     COUTATOMIC(endl);
@@ -898,6 +1198,23 @@ void printOutput() {
     }
 #endif
 
+    {
+        // merge the histograms of all threads into one per operation type
+        LatencyHistogram *merged = new LatencyHistogram[LATENCY_NUM_OPS];
+        for (int tid = 0; tid < TOTAL_THREADS; ++tid) {
+            if (glob.latencies[tid] == NULL) continue;
+            for (int op = 0; op < LATENCY_NUM_OPS; ++op) {
+                merged[op].merge(glob.latencies[tid][op]);
+            }
+            delete[] glob.latencies[tid];
+            glob.latencies[tid] = NULL;
+        }
+        COUTATOMIC("latency percentiles (ns):" << endl);
+        latency_print_csv(cout, merged);
+        COUTATOMIC(endl);
+        delete[] merged;
+    }
+
     COUTATOMIC("elapsed milliseconds          : " << glob.elapsedMillis << endl);
     COUTATOMIC("napping milliseconds overtime : " << glob.elapsedMillisNapping
             << endl);
@@ -909,6 +1226,31 @@ void printOutput() {
     COUTATOMIC(ds->getBundleStatsString() << flush);
     COUTATOMIC(endl);
 #endif
+#ifdef BUNDLE_PRINT_ENTRY_STATS
+    {
+        // Entries taken from a pool beyond those the allocator had to create
+        // were recycled.
+        debugInfo *entryInfo = ((MEMMGMT_T *)ds->debugGetRecMgr())
+                                   ->getDebugInfo((BUNDLE_ENTRY_TYPE *)NULL);
+        long long entriesAllocated = entryInfo->getTotalAllocated();
+        long long entriesRecycled =
+            entryInfo->getTotalFromPool() - entriesAllocated;
+        COUTATOMIC("bundle entries allocated      : " << entriesAllocated
+                                                      << endl);
+        COUTATOMIC("bundle entries recycled       : " << entriesRecycled
+                                                      << endl);
+        COUTATOMIC("bundle entry size             : "
+                   << sizeof(BUNDLE_ENTRY_TYPE) << endl);
+        COUTATOMIC(endl);
+    }
+#endif
+    {
+        // all threads have finished, so the data structure can be traversed
+        BundleFootprint footprint;
+        ds->getFootprint(footprint);
+        footprint.print(cout);
+        cout << endl;
+    }
 #endif
 
 #if defined(USE_DEBUGCOUNTERS) || defined(USE_GSTATS)
@@ -944,6 +1286,8 @@ int main(int argc, char **argv) {
     // read command line args
     // example args: -i 25 -d 25 -k 10000 -rq 0 -rqsize 1000 -p -t 1000 -nrq 0
     // -nwork 8
+    // range queries use the key distribution unless -rqdist is given
+    bool rqdistGiven = false;
     for (int i = 1; i < argc; ++i) {
         if (strcmp(argv[i], "-i") == 0) {
             INS = atof(argv[++i]);
@@ -963,6 +1307,35 @@ int main(int argc, char **argv) {
             MILLIS_TO_RUN = atoi(argv[++i]);
         } else if (strcmp(argv[i], "-p") == 0) {
             PREFILL = true;
+        } else if (strcmp(argv[i], "-bulk") == 0) {
+            PREFILL = true;
+            glob.prefillBulk = true;
+        } else if (strcmp(argv[i], "-sample") == 0) {  // e.g., "-sample 100"
+            glob.sampleMillis = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-samplefile") == 0) {
+            glob.sampleFile = argv[++i];
+        } else if (strcmp(argv[i], "-dist") == 0) {  // e.g., "-dist zipf"
+            glob.keydist.dist = key_dist_from_name(argv[++i]);
+            if (!rqdistGiven) glob.keydist.rqdist = glob.keydist.dist;
+        } else if (strcmp(argv[i], "-rqdist") == 0) {
+            glob.keydist.rqdist = key_dist_from_name(argv[++i]);
+            rqdistGiven = true;
+        } else if (strcmp(argv[i], "-theta") == 0) {
+            glob.keydist.theta = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-hotset") == 0) {
+            glob.keydist.hotset = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-hotops") == 0) {
+            glob.keydist.hotops = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-noscramble") == 0) {
+            glob.keydist.scramble = false;
+#ifdef RQ_BUNDLE
+        } else if (strcmp(argv[i], "-ts") == 0) {  // e.g., "-ts numa"
+            default_timestamp_policy() = timestamp_policy_from_name(argv[++i]);
+            if (default_timestamp_policy() == BUNDLE_TS_INVALID) {
+                cout << "bad timestamp policy " << argv[i] << endl;
+                exit(1);
+            }
+#endif
         } else if (strcmp(argv[i], "-bind") ==
                 0) {                    // e.g., "-bind 1,2,3,8-11,4-7,0"
             binding_parseCustom(argv[++i]);  // e.g., "1,2,3,8-11,4-7,0"
@@ -973,6 +1346,15 @@ int main(int argc, char **argv) {
         }
     }
     TOTAL_THREADS = WORK_THREADS + RQ_THREADS;
+    if (glob.keydist.dist == KEY_DIST_INVALID ||
+            glob.keydist.rqdist == KEY_DIST_INVALID) {
+        cout << "bad key distribution" << endl;
+        exit(1);
+    }
+    if (!glob.keydist.init(MAXKEY)) {
+        cout << "bad key distribution parameters" << endl;
+        exit(1);
+    }
 
     // print used args
     PRINTS(FIND_FUNC);
@@ -983,6 +1365,14 @@ int main(int argc, char **argv) {
     PRINTS(ALLOC);
     PRINTS(POOL);
     PRINTI(PREFILL);
+    if (glob.prefillBulk) {
+#ifdef BULK_LOAD_SUPPORTED
+        cout << "PREFILL_BULK=1" << endl;
+#else
+        cout << "NOTICE: bulk loading is not supported by this data structure;"
+             << " prefilling with random updates instead" << endl;
+#endif
+    }
     PRINTI(MILLIS_TO_RUN);
     PRINTI(INS);
     PRINTI(DEL);
@@ -991,6 +1381,25 @@ int main(int argc, char **argv) {
     PRINTI(MAXKEY);
     PRINTI(WORK_THREADS);
     PRINTI(RQ_THREADS);
+    if (glob.sampleMillis > 0) {
+        cout << "SAMPLE_MILLIS=" << glob.sampleMillis << endl;
+        if (glob.sampleFile) cout << "SAMPLE_FILE=" << glob.sampleFile << endl;
+    }
+    cout << "KEY_DIST=" << key_dist_name(glob.keydist.dist) << endl;
+    cout << "RQ_DIST=" << key_dist_name(glob.keydist.rqdist) << endl;
+    if (key_dist_uses_zipf(glob.keydist.dist) ||
+            key_dist_uses_zipf(glob.keydist.rqdist)) {
+        cout << "ZIPF_THETA=" << glob.keydist.theta << endl;
+        if (glob.keydist.dist == KEY_DIST_ZIPF ||
+                glob.keydist.rqdist == KEY_DIST_ZIPF) {
+            cout << "ZIPF_SCRAMBLED=" << glob.keydist.scramble << endl;
+        }
+    }
+    if (glob.keydist.dist == KEY_DIST_HOTSPOT ||
+            glob.keydist.rqdist == KEY_DIST_HOTSPOT) {
+        cout << "HOTSPOT_SET=" << glob.keydist.hotset << endl;
+        cout << "HOTSPOT_OPS=" << glob.keydist.hotops << endl;
+    }
 
     // TODO: Find a way to keep strategy specific code out of main.
 #ifdef RQ_BUNDLE
@@ -998,18 +1407,25 @@ int main(int argc, char **argv) {
     cout << "BUNDLE_TYPE=linked" << endl;
 #elif defined BUNDLE_CIRCULAR_BUNDLE
     cout << "BUNDLE_TYPE=circular" << endl;
+#elif defined BUNDLE_INLINE_BUNDLE
+    cout << "BUNDLE_TYPE=inline" << endl;
 #endif
 #if defined BUNDLE_CLEANUP_BACKGROUND
     cout << "BUNDLE_CLEANUP=background" << endl;
     cout << "BUNDLE_CLEANUP_SLEEP=" << BUNDLE_CLEANUP_SLEEP << endl;
+    cout << "BUNDLE_CLEANUP_THREADS=" << BUNDLE_CLEANUP_THREADS << endl;
+    cout << "BUNDLE_CLEANUP_BATCH=" << BUNDLE_CLEANUP_BATCH << endl;
 #elif defined BUNDLE_CLEANUP_UPDATE
     cout << "BUNDLE_CLEANUP=update" << endl;
+    cout << "BUNDLE_CLEANUP_UPDATE_THRESHOLD="
+         << BUNDLE_CLEANUP_UPDATE_THRESHOLD << endl;
+    cout << "BUNDLE_RQ_REFRESH_PERIOD=" << BUNDLE_RQ_REFRESH_PERIOD << endl;
 #else
     cout << "BUNDLE_CLEANUP=none" << endl;
 #endif
-#if defined BUNDLE_TIMESTAMP_RELAXATION
-    cout << "BUNDLE_TIMESTAMP_RELAXATION=" << BUNDLE_TIMESTAMP_RELAXATION << endl;
-#endif
+    cout << "BUNDLE_RQ_MAX_RESTARTS=" << BUNDLE_RQ_MAX_RESTARTS << endl;
+    cout << "BUNDLE_TIMESTAMP="
+         << timestamp_policy_name(default_timestamp_policy()) << endl;
 #endif
 
 #ifdef WIDTH_SEQ
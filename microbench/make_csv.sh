@@ -31,10 +31,17 @@ avgannounce=0
 avgbag=0
 reachable=0
 avgbundle=0
+# Tail latencies (p99, p99.9) of updates, searches and range queries.
+up99=0
+up999=0
+cp99=0
+cp999=0
+rqp99=0
+rqp999=0
 expectedcount=0
 trialcount=0
 nobundlestats=0
-echo "list,max_key,u_rate,rq_rate,wrk_threads,rq_threads,rq_size,u_latency,c_latency,rq_latency,tot_thruput,u_thruput,c_thruput,rq_thruput,rq_len,avg_in_announce,avg_in_bags,reachable_nodes,avg_bundle_size" >${outfile}
+echo "list,max_key,u_rate,rq_rate,wrk_threads,rq_threads,rq_size,u_latency,c_latency,rq_latency,tot_thruput,u_thruput,c_thruput,rq_thruput,rq_len,avg_in_announce,avg_in_bags,reachable_nodes,avg_bundle_size,u_p99,u_p999,c_p99,c_p999,rq_p99,rq_p999" >${outfile}
 for algo in ${algos}; do
   files=$(ls ${algo} | grep ${listname})
   # echo $files
@@ -82,6 +89,14 @@ for algo in ${algos}; do
     clat=$(($(echo "${filecontents}" | grep 'average latency_searches' | sed -e 's/.*=//') + ${clat}))
     rqlat=$(($(echo "${filecontents}" | grep 'average latency_rqs' | sed -e 's/.*=//') + ${rqlat}))
 
+    # Percentiles from the latency histograms (columns: op,count,mean,p50,p90,p99,p99.9,max).
+    up99=$(($(echo "${filecontents}" | grep '^latency_percentiles,updates,' | cut -d, -f7) + ${up99}))
+    up999=$(($(echo "${filecontents}" | grep '^latency_percentiles,updates,' | cut -d, -f8) + ${up999}))
+    cp99=$(($(echo "${filecontents}" | grep '^latency_percentiles,searches,' | cut -d, -f7) + ${cp99}))
+    cp999=$(($(echo "${filecontents}" | grep '^latency_percentiles,searches,' | cut -d, -f8) + ${cp999}))
+    rqp99=$(($(echo "${filecontents}" | grep '^latency_percentiles,rqs,' | cut -d, -f7) + ${rqp99}))
+    rqp999=$(($(echo "${filecontents}" | grep '^latency_percentiles,rqs,' | cut -d, -f8) + ${rqp999}))
+
     # Throughput statistics.
     rqthrupt=$(($(echo "${filecontents}" | grep 'rq throughput' | sed -e 's/.*: //') + ${rqthrupt}))
     uthrupt=$(($(echo "${filecontents}" | grep 'update throughput' | sed -e 's/.*: //') + ${uthrupt}))
@@ -91,7 +106,7 @@ for algo in ${algos}; do
     avgrqlen=$(($(echo "${filecontents}" | grep 'average length_rqs' | sed -e 's/.*=//') + ${avgrqlen}))
 
     # EBR specific statistics.
-    if [[ "${nobundlestats}" == 0 ]] && ([[ "${rqstrategy}" == "lbundle" ]] || [[ "${rqstrategy}" == "cbundle" ]]); then
+    if [[ "${nobundlestats}" == 0 ]] && ([[ "${rqstrategy}" == "lbundle" ]] || [[ "${rqstrategy}" == "cbundle" ]] || [[ "${rqstrategy}" == "ibundle" ]]); then
       # Bundle specific statistics.
       reachable=$(($(echo "${filecontents}" | grep 'total reachable nodes' | sed -e 's/.*: //') + ${reachable}))
       if [[ ${reachable} != 0 ]]; then
@@ -121,7 +136,13 @@ for algo in ${algos}; do
       printf ",%d" $((${avgannounce} / ${ntrials})) >>${outfile}
       printf ",%d" $((${avgbag} / ${ntrials})) >>${outfile}
       printf ",%d" $((${reachable} / ${ntrials})) >>${outfile}
-      printf ",%.2f\n" $(echo "scale=4;$(echo ${avgbundle}) / ${ntrials}.0" | bc) >>${outfile}
+      printf ",%.2f" $(echo "scale=4;$(echo ${avgbundle}) / ${ntrials}.0" | bc) >>${outfile}
+      printf ",%d" $((${up99} / ${ntrials})) >>${outfile}
+      printf ",%d" $((${up999} / ${ntrials})) >>${outfile}
+      printf ",%d" $((${cp99} / ${ntrials})) >>${outfile}
+      printf ",%d" $((${cp999} / ${ntrials})) >>${outfile}
+      printf ",%d" $((${rqp99} / ${ntrials})) >>${outfile}
+      printf ",%d\n" $((${rqp999} / ${ntrials})) >>${outfile}
       ulat=0
       clat=0
       rqlat=0
@@ -133,6 +154,12 @@ for algo in ${algos}; do
       avgbag=0
       reachable=0
       avgbundle=0
+      up99=0
+      up999=0
+      cp99=0
+      cp999=0
+      rqp99=0
+      rqp999=0
     fi
   done
 done
@@ -7,7 +7,10 @@
 
 #define PADDING_BYTES 192
 
+// Number of objects preallocated by each allocator.
+#ifndef OBJECTS_IN_POOL
 #define OBJECTS_IN_POOL (64 * 1024 * 1024L)
+#endif
 
 class Allocator {  
   private:
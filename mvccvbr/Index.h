@@ -11,9 +11,11 @@
 #define INDEX_MAX_LEVEL (18)
 #define INDEX_FREQ 2
 
-__thread LocalAllocator *localIndexAllocator = nullptr;
-__thread unsigned int indexLevelSeed;
-__thread uint64_t currIndexEpoch = 0;
+// The calling thread's allocator of the index it is operating on (see
+// bindThread).
+__thread __attribute__((weak)) LocalAllocator *localIndexAllocator = nullptr;
+__thread __attribute__((weak)) unsigned int indexLevelSeed;
+__thread __attribute__((weak)) uint64_t currIndexEpoch = 0;
 
 template <typename K, typename V> 
 class Index
@@ -125,6 +127,8 @@ class Index
     IndexNode *indexHead;
     volatile char padding1[PADDING_BYTES];
     Allocator *globalIndexAllocator;
+    // Allocator of each thread, created by its first initThread.
+    LocalAllocator *localIndexAllocators[MAX_TID_POW2] = {};
     volatile char padding2[PADDING_BYTES];
     
     bool find(K key, IndexNode **preds, IndexNode **succs, int minLevel)
@@ -269,18 +273,28 @@ class Index
     }
     
     ~Index() {
+      for (int i = 0; i < MAX_TID_POW2; ++i) {
+        delete localIndexAllocators[i];
+      }
       delete globalIndexAllocator;
     }
     
     void initThread(int tid) {
-      if (localIndexAllocator == nullptr || localIndexAllocator->getGlobalAllocator() != globalIndexAllocator)
-        localIndexAllocator = new LocalAllocator(globalIndexAllocator, tid);
+      if (localIndexAllocators[tid] == nullptr)
+        localIndexAllocators[tid] = new LocalAllocator(globalIndexAllocator, tid);
+      localIndexAllocator = localIndexAllocators[tid];
       indexLevelSeed = tid + 3;
       currIndexEpoch = 0;
     }
     
+    // Points the calling thread's allocator at this index's. Must be called
+    // before operating on the index, since several indexes may be in use.
+    inline void bindThread(const int tid) {
+      localIndexAllocator = localIndexAllocators[tid];
+    }
+    
     void deinitThread(const int tid) {
-      localIndexAllocator->returnAllocCaches();
+      localIndexAllocators[tid]->returnAllocCaches();
     }
     
     void init(DirectCTSNode<K,V> *head, DirectCTSNode<K,V> *tail) {
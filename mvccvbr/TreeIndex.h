@@ -8,8 +8,10 @@
 #include "LocalAllocator.h"
 
 
-__thread LocalAllocator *localTreeIndexAllocator = nullptr;
-__thread uint64_t currTreeIndexEpoch;
+// The calling thread's allocator of the index it is operating on (see
+// bindThread).
+__thread __attribute__((weak)) LocalAllocator *localTreeIndexAllocator = nullptr;
+__thread __attribute__((weak)) uint64_t currTreeIndexEpoch;
 
 template <typename K, typename V> 
 class TreeIndex
@@ -109,6 +111,8 @@ class TreeIndex
     
     //volatile char padding0[PREFETCH_SIZE_BYTES];
     Allocator *globalTreeIndexAllocator;
+    // Allocator of each thread, created by its first initThread.
+    LocalAllocator *localTreeIndexAllocators[MAX_TID_POW2] = {};
     TreeIndexNode *root;
 	  TreeIndexNode *leftChild;
 
@@ -275,14 +279,27 @@ class TreeIndex
 
     }
     
+    ~TreeIndex() {
+      for (int i = 0; i < MAX_TID_POW2; ++i) {
+        delete localTreeIndexAllocators[i];
+      }
+    }
+    
     void initThread(int tid) {
-      if (localTreeIndexAllocator == nullptr || localTreeIndexAllocator->getGlobalAllocator() != globalTreeIndexAllocator)
-        localTreeIndexAllocator = new LocalAllocator(globalTreeIndexAllocator, tid);
+      if (localTreeIndexAllocators[tid] == nullptr)
+        localTreeIndexAllocators[tid] = new LocalAllocator(globalTreeIndexAllocator, tid);
+      localTreeIndexAllocator = localTreeIndexAllocators[tid];
       currTreeIndexEpoch = 0;
     }
     
+    // Points the calling thread's allocator at this index's. Must be called
+    // before operating on the index, since several indexes may be in use.
+    inline void bindThread(const int tid) {
+      localTreeIndexAllocator = localTreeIndexAllocators[tid];
+    }
+    
     void deinitThread(const int tid) {
-      localTreeIndexAllocator->returnAllocCaches();
+      localTreeIndexAllocators[tid]->returnAllocCaches();
     }
     
     void init(DirectCTSNode<K,V> *head, K maxElement) {
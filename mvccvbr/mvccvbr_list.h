@@ -18,10 +18,13 @@
 #endif
 
 
-__thread LocalAllocator *localAllocator = nullptr;
-__thread uint64_t currEpoch = 0;
-__thread uint64_t currTreeEpoch = 0;
-__thread uint64_t rollbacks = 0;
+// Weak, since this header may be included by several translation units.
+// localAllocator is the calling thread's allocator of the list it is
+// operating on (see bindThread).
+__thread __attribute__((weak)) LocalAllocator *localAllocator = nullptr;
+__thread __attribute__((weak)) uint64_t currEpoch = 0;
+__thread __attribute__((weak)) uint64_t currTreeEpoch = 0;
+__thread __attribute__((weak)) uint64_t rollbacks = 0;
 
 #define PADDING_BYTES 192
 #define PENDING_TS 1
@@ -40,6 +43,8 @@ private:
     TreeIndex<K,V> *treeIndex;
 #endif
     Allocator *globalAllocator;
+    // Allocator of each thread, created by its first initThread.
+    LocalAllocator *localAllocators[MAX_TID_POW2] = {};
     volatile char padding0[PADDING_BYTES];
     std::atomic<uint64_t> tsEpoch;
     volatile char padding1[PADDING_BYTES];
@@ -66,6 +71,18 @@ private:
     
     //int init[MAX_TID_POW2] = {0,};
     
+    // Several lists (e.g., one per table) share the thread-local allocator
+    // pointers, so every operation first points them at this list's
+    // allocators.
+    inline void bindThread(const int tid) {
+      localAllocator = localAllocators[tid];
+#if defined(MVCC_VBR_SKIPLIST)
+      index->bindThread(tid);
+#elif defined(MVCC_VBR_TREE)
+      treeIndex->bindThread(tid);
+#endif
+    }
+
     inline uint64_t getReclamationEpoch(){
       return localAllocator->getEpoch();
 	  }
@@ -238,6 +255,9 @@ public:
       delete treeIndex;
 #endif
 
+      for (int i = 0; i < MAX_TID_POW2; ++i) {
+        delete localAllocators[i];
+      }
       delete globalAllocator;
       
     }
@@ -632,6 +652,7 @@ public:
       uint64_t predVersion, newNodeTS, initEpoch, currTS, predTS;
       K currKey, predKey;
       
+      bindThread(tid);
       
       while (true) {
         curr = find(key, &pred, &predVersion, &currKey);
@@ -689,7 +710,7 @@ public:
       K currKey;
       V result;
 
-      
+      bindThread(tid);
       while (true) {
         result = NO_VALUE;
         curr = find(key, &pred, &predVersion, &currKey);
@@ -710,10 +731,27 @@ public:
       K currKey;
 	    DirectCTSNode<K,V> *pred, *curr;
          
+      bindThread(tid);
       curr = find(key, &pred, &predVersion, &currKey);
       return (currKey == key);
 
     }
+
+    const pair<V, bool> find(const int tid, const K& key) {
+      uint64_t predVersion;
+      K currKey;
+      DirectCTSNode<K,V> *pred, *curr;
+
+      bindThread(tid);
+      while (true) {
+        curr = find(key, &pred, &predVersion, &currKey);
+        if (currKey != key) return pair<V, bool>(NO_VALUE, false);
+        V result = curr->value;
+        if (getReclamationEpochFromTs(curr->getTS()) > predVersion)
+          continue; // the node was reclaimed, so the value may be stale
+        return pair<V, bool>(result, true);
+      }
+    }
     
     int rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, V * const resultValues) {	
     //intptr_t rangeQuery(intptr_t low, intptr_t high, int tid) {      
@@ -724,6 +762,7 @@ public:
       V currValue;
  	    DirectCTSNode<K,V> *pred, *curr;
   
+      bindThread(tid);
       minEpoch = getTsEpoch();
       //backoff(1000);
 
@@ -884,8 +923,9 @@ public:
      * It must be okay that we do this with the main thread and later with another thread!!!
      */
     void initThread(const int tid) {
-      if (localAllocator == nullptr || localAllocator->getGlobalAllocator() != globalAllocator)
-        localAllocator = new LocalAllocator(globalAllocator, tid);
+      if (localAllocators[tid] == nullptr)
+        localAllocators[tid] = new LocalAllocator(globalAllocator, tid);
+      localAllocator = localAllocators[tid];
       currEpoch = 0;
       rollbacks = 0;
 #if defined(MVCC_VBR_SKIPLIST)
@@ -897,8 +937,9 @@ public:
     }
 
     void deinitThread(const int tid) {
-      localAllocator->returnAllocCaches();
+      localAllocators[tid]->returnAllocCaches();
       totalRollbacks.fetch_add(rollbacks);
+      rollbacks = 0;
       
 #if defined(MVCC_VBR_SKIPLIST)
       index->deinitThread(tid);
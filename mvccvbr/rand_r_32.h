@@ -30,7 +30,7 @@
  *
  *    Cloned the function to handle the case where the seed is volatile
  */
-int
+inline int
 rand_r_32 (unsigned int *seed)
 {
     unsigned int next = *seed;
@@ -1,4 +1,6 @@
+import io
 import numpy as np
+import pandas as pd
 import argparse
 from plotly.subplots import make_subplots
 import math
@@ -64,6 +66,21 @@ flags.DEFINE_integer(
     36,
     "Number of dedicated RQ threads used in the 'rqthreads' experiment",
 )
+flags.DEFINE_bool(
+    "workloads_latency",
+    False,
+    "Also plot tail latencies when plotting the 'workloads' experiment",
+)
+flags.DEFINE_list(
+    "workloads_latency_columns",
+    ["u_p99", "u_p999", "rq_p99", "rq_p999"],
+    "Latency percentile columns (produced by make_csv.sh) to plot for the 'workloads' experiment",
+)
+flags.DEFINE_list(
+    "timeseries",
+    None,
+    "Time series files written by the microbenchmark's -samplefile option (or its output when sampling without one) to plot",
+)
 flags.DEFINE_list("experiments", None, "List of experiments to plot")
 flags.DEFINE_list("datastructures", None, "List of data structures to plot")
 flags.DEFINE_list("max_keys", None, "List of max keys to use while plotting")
@@ -224,6 +241,104 @@ def plot_workload(
         print("\n\n")
 
 
+def plot_workload_latency(
+    dirpath,
+    ds,
+    max_key,
+    u_rate,
+    rq_rate,
+    ntrials,
+    y_axis,
+    ylabel=False,
+    legend=False,
+    save=False,
+    save_dir="",
+):
+    """ Generates a plot showing a latency percentile (in microseconds) as a
+        function of number of threads for the given data structure. """
+    reset_base_config()
+    csvfile = CSVFile.get_or_gen_csv(os.path.join(dirpath, "workloads"), ds, ntrials)
+    csv = CSVFile(csvfile)
+
+    x_axis = "wrk_threads"
+
+    data = {}
+    ignore = ["ubundle"]
+    algos = [k for k in plotconfig.keys() if k not in ignore]
+
+    count = 0
+    for a in algos:
+        data[a] = csv.getdata(
+            x_axis,
+            y_axis,
+            ["list", "max_key", "u_rate", "rq_rate"],
+            [ds + "-" + a, max_key, u_rate, rq_rate],
+        )
+        count += len(data[a]["x"])
+        data[a]["y"] = data[a]["y"] / 1000  # Normalize data to us
+
+    if count == 0:
+        print("No data at given key range: ({}, {})".format(ds, max_key))
+        return  # If no data to ploy, then don't
+
+    # Plot layout configuration.
+    x_axis_layout_["title"] = None
+    x_axis_layout_["tickfont"]["size"] = 52
+    x_axis_layout_["nticks"] = 6
+    if ylabel:
+        y_axis_layout_["title"]["text"] = y_axis + " (us)"
+        y_axis_layout_["title"]["font"]["size"] = 50
+    else:
+        y_axis_layout_["title"] = None
+    y_axis_layout_["tickfont"]["size"] = 52
+    y_axis_layout_["type"] = "log"
+    legend_layout_ = (
+        {"font": legend_font_, "orientation": "v", "x": 0, "y": 1.15} if legend else {}
+    )
+    layout_["legend"] = legend_layout_
+    layout_["autosize"] = False
+    layout_["width"] = 750
+    layout_["height"] = 550
+
+    fig = go.Figure(layout=layout_)
+    for a in algos:
+        symbol_ = plotconfig[a]["symbol"]
+        color_ = update_opacity(plotconfig[a]["color"], 1)
+        marker_ = {
+            "symbol": symbol_,
+            "color": color_,
+            "size": 40,
+            "line": {"width": 5, "color": "black"},
+        }
+        line_ = {"width": 10}
+        name_ = "<b>" + plotconfig[a]["label"] + "</b>"
+        fig.add_scatter(
+            x=data[a]["x"],
+            y=data[a]["y"],
+            name=name_,
+            marker=marker_,
+            line=line_,
+            showlegend=legend,
+        )
+
+    if not save:
+        fig.show()
+    else:
+        save_dir = os.path.join(save_dir, "workloads/" + ds)
+        os.makedirs(save_dir, exist_ok=True)
+        filename = (
+            y_axis
+            + "_update"
+            + str(u_rate)
+            + "_rq"
+            + str(rq_rate)
+            + "_maxkey"
+            + str(max_key)
+            + ".html"
+        )
+        fig.write_html(os.path.join(save_dir, filename))
+
+
 def plot_rq_sizes(
     dirpath,
     dss,
@@ -632,6 +747,56 @@ def plot_macrobench(dirpath, ds, ylabel=False, legend=False, save=False, save_di
         fig.write_html(os.path.join(save_dir, filename))
 
 
+def read_timeseries(filepath):
+    """ Reads the samples of a microbenchmark run, either from the file given to
+        -samplefile or from the rows prefixed with "timeseries," in its output. """
+    with open(filepath) as f:
+        lines = [l.strip() for l in f]
+    if any(l.startswith("timeseries,") for l in lines):
+        lines = [l[len("timeseries,") :] for l in lines if l.startswith("timeseries,")]
+    return pd.read_csv(io.StringIO("\n".join(lines)))
+
+
+def plot_timeseries(filepaths, save=False, save_dir=""):
+    """ Generates one plot per time series file, with a subplot for each
+        sampled metric as a function of elapsed time. """
+    columns = [
+        ("tot_thruput", "Mops/s (total)", 1000000),
+        ("update_thruput", "Mops/s (updates)", 1000000),
+        ("rq_thruput", "Mops/s (rqs)", 1000000),
+        ("avg_bundle_size", "avg. bundle size", 1),
+        ("retired_records", "retired records", 1),
+        ("retired_mb", "retired (MB)", 1),
+        ("pooled_mb", "pooled (MB)", 1),
+        ("rss_mb", "RSS (MB)", 1),
+    ]
+    for filepath in filepaths:
+        data = read_timeseries(filepath)
+        fig = make_subplots(
+            rows=len(columns), cols=1, shared_xaxes=True,
+            subplot_titles=[c[1] for c in columns],
+        )
+        for i, (column, label, scale) in enumerate(columns):
+            fig.add_scatter(
+                x=data["elapsed_ms"],
+                y=data[column] / scale,
+                name=label,
+                showlegend=False,
+                row=i + 1,
+                col=1,
+            )
+        fig.update_xaxes(title_text="elapsed (ms)", row=len(columns), col=1)
+        fig.update_layout(height=300 * len(columns), width=900, plot_bgcolor="white")
+
+        if not save:
+            fig.show()
+        else:
+            save_dir_ = os.path.join(save_dir, "timeseries")
+            os.makedirs(save_dir_, exist_ok=True)
+            filename = os.path.splitext(os.path.basename(filepath))[0] + ".html"
+            fig.write_html(os.path.join(save_dir_, filename))
+
+
 def get_threads_config():
     nthreads = []
     if FLAGS.detect_threads:
@@ -710,6 +875,21 @@ def main(argv):
                             FLAGS.save_plots,
                             os.path.join(FLAGS.save_dir, "microbench"),
                         )
+                        if FLAGS.workloads_latency:
+                            for column in FLAGS.workloads_latency_columns:
+                                plot_workload_latency(
+                                    FLAGS.microbench_dir,
+                                    ds,
+                                    k,
+                                    u,
+                                    (FLAGS.workloads_rqrate if u != 100 else 0),
+                                    ntrials,
+                                    column,
+                                    True,
+                                    True,
+                                    FLAGS.save_plots,
+                                    os.path.join(FLAGS.save_dir, "microbench"),
+                                )
                         pass
 
                 if "run_rq_threads" in experiments:
@@ -743,6 +923,14 @@ def main(argv):
                 os.path.join(FLAGS.save_dir, "microbench"),
             )
 
+    # Plot time series of individual runs.
+    if FLAGS.timeseries is not None:
+        plot_timeseries(
+            FLAGS.timeseries,
+            FLAGS.save_plots,
+            os.path.join(FLAGS.save_dir, "microbench"),
+        )
+
     # Plot macrobench results (corresponds to Figure 4)
     if FLAGS.macrobench:
         save_dir = os.path.join(FLAGS.save_dir, "macrobench/skiplistlock")
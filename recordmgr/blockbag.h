@@ -268,6 +268,11 @@ class block;
         volatile char padding1[PREFETCH_SIZE_BYTES];
     public:
         int sizeInBlocks;
+        // blocks this bag has given to a shared bag minus the blocks it has
+        // taken from one. only written by the owner, so summing it over the
+        // bags of all threads gives the size of the shared bag without adding
+        // a shared counter to its push and pop.
+        long sharedBlocks;
     private:
         
         volatile char padding2[PREFETCH_SIZE_BYTES];
@@ -320,6 +325,7 @@ class block;
             reclaimCount = 0;
             debugFreed = 0;
             sizeInBlocks = 1;
+            sharedBlocks = 0;
             head = pool->allocateBlock(NULL);
             tail = head;
             DEBUG2 assert(computeSizeInBlocks() == sizeInBlocks);
@@ -396,6 +402,7 @@ class block;
                     block<T> *b = removeFullBlock(); // returns NULL if freeBag has < 2 full blocks
                     assert(b);
                     sharedBag->addBlock(b);
+                    ++sharedBlocks;
                     MEMORY_STATS alloc->debug->addGiven(tid, 1);
                     //DEBUG2 COUTATOMIC("  thread "<<this->tid<<" sharedBag("<<(sizeof(T)==sizeof(Node<long,long>)?"Node":"SCXRecord")<<") now contains "<<sharedBag->size()<<" blocks"<<endl);
                     DEBUG2 assert(oldsize + 1 - BLOCK_SIZE == computeSize());
@@ -511,6 +518,7 @@ class block;
                     block<T> *b = sharedBag->getBlock();
                     if (b) {
                         addFullBlock(b);
+                        --sharedBlocks;
                         MEMORY_STATS alloc->debug->addTaken(tid, 1);
                         //DEBUG2 COUTATOMIC("  thread "<<this->tid<<" took "<<b->computeSize()<<" objects from sharedBag"<<endl);
                         return remove(/*tid, sharedBag, alloc*/);
@@ -39,7 +39,9 @@ private:
 public:
     lockfreeblockbag() {
         VERBOSE DEBUG cout<<"constructor lockfreeblockbag lockfree="<<head.is_lock_free()<<endl;
-        assert(head.is_lock_free());
+        // no assert(head.is_lock_free()): gcc reports double-wide atomics as
+        // not lock free even when libatomic implements them with cmpxchg16b,
+        // and the bag is correct either way.
         head.store(tagged_ptr({NULL,0}));
     }
     ~lockfreeblockbag() {
@@ -39,6 +39,8 @@ public:
     
     string getSizeString() { return ""; }
 //    long long getSizeInNodes() { return 0; }
+    // may be called while other threads are using the pool
+    long long getApproxSizeInNodes() { return 0; }
     /**
      * if the pool contains any object, then remove one from the pool
      * and return a pointer to it. otherwise, return NULL.
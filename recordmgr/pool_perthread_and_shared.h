@@ -33,6 +33,7 @@ private:
             assert(b);
 //            if (b) {
                 sharedBag->addBlock(b);
+                ++freeBag[tid]->sharedBlocks;
                 MEMORY_STATS this->debug->addGiven(tid, 1);
                 //DEBUG2 COUTATOMIC("  thread "<<this->tid<<" sharedBag("<<(sizeof(T)==sizeof(Node<long,long>)?"Node":"SCXRecord")<<") now contains "<<sharedBag->size()<<" blocks"<<endl);
 //            }
@@ -77,6 +78,19 @@ public:
         ss<<infreebags<<" in free bags and "<<insharedbag<<" in the shared bag";
         return ss.str();
     }
+    // counts only the full blocks of each free bag (and the blocks of the
+    // shared bag, which are full), so it is a lower bound that is off by at
+    // most BLOCK_SIZE per free bag. unlike getSizeString(), it reads only the
+    // counters of the free bags (the shared bag's size is the sum of the
+    // blocks each free bag has given it minus those it has taken), so it may
+    // be called while other threads use the pool.
+    long long getApproxSizeInNodes() {
+        long long blocks = 0;
+        for (int tid=0;tid<this->NUM_PROCESSES;++tid) {
+            blocks += (freeBag[tid]->sizeInBlocks - 1) + freeBag[tid]->sharedBlocks;
+        }
+        return blocks * BLOCK_SIZE;
+    }
     
     /**
      * if the freebag contains any object, then remove one from the freebag
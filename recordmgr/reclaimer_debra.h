@@ -201,6 +201,19 @@ public:
         }
         return sum;
     }
+    // counts only the full blocks of each bag, so it is a lower bound that is
+    // off by at most BLOCK_SIZE per bag. unlike getSizeInNodes(), it reads a
+    // single counter per bag, so it may be called while other threads are
+    // retiring records.
+    long long getApproxSizeInNodes() {
+        long long sum = 0;
+        for (int tid=0;tid<this->NUM_PROCESSES;++tid) {
+            for (int j=0;j<NUMBER_OF_EPOCH_BAGS;++j) {
+                sum += (long long) (threadData[tid].epochbags[j]->sizeInBlocks - 1) * BLOCK_SIZE;
+            }
+        }
+        return sum;
+    }
     string getSizeString() {
         stringstream ss;
         ss<<getSizeInNodes()<<" in epoch bags";
@@ -213,6 +226,10 @@ public:
         return QUIESCENT(threadData[tid].announcedEpoch.load(memory_order_relaxed));
     }
 
+    inline long readEpoch() {
+        return epoch;
+    }
+
     inline static bool isProtected(const int tid, T * const obj) {
         return true;
     }
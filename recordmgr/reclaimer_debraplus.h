@@ -141,6 +141,10 @@ public:
         //COUTATOMICTID("IS QUIESCENT EXECUTED"<<endl);
         return QUIESCENT(announcedEpoch[tid*PREFETCH_SIZE_WORDS].load(memory_order_relaxed));
     }
+
+    inline long readEpoch() {
+        return epoch;
+    }
     
     inline static bool isProtected(const int tid, T * const obj) {
         return true;
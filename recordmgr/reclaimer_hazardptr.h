@@ -62,6 +62,9 @@ public:
     inline static bool isQuiescent(const int tid) {
         return true;
     }    
+    inline static long readEpoch() {
+        return -1;
+    }
     
     // for hazard pointers (and counting references from threads)
     inline bool protect(const int tid, T * const obj, CallbackType notRetiredCallback, CallbackArg callbackArg, bool memoryBarrier = true) {
@@ -45,6 +45,8 @@ public:
     };
     
     long long getSizeInNodes() { return 0; }
+    // may be called while other threads are retiring records
+    long long getApproxSizeInNodes() { return 0; }
     string getSizeString() { return ""; }
 
     inline static bool quiescenceIsPerRecordType() { return true; }
@@ -64,7 +66,10 @@ public:
     inline void qUnprotectAll(const int tid);
     
     // for epoch based reclamation (or, more generally, any quiescent state based reclamation)
-//    inline long readEpoch();
+    // returns the current epoch. records that a thread could access while it
+    // was not quiescent in an epoch cannot be reclaimed until the epoch changes.
+    // returns -1 if the scheme has no such epoch.
+    inline long readEpoch();
 //    inline long readAnnouncedEpoch(const int tid);
     /**
      * enterQuiescentState<T> must be idempotent,
@@ -35,6 +35,10 @@ public:
     inline static bool isQuiescent(const int tid) {
         return true;
     }
+    // nothing is ever reclaimed, so the epoch never changes
+    inline static long readEpoch() {
+        return 0;
+    }
     inline static bool isProtected(const int tid, T * const obj) {
         return true;
     }
@@ -140,6 +140,9 @@ public:
     inline bool isQuiescent(const int tid) {
         return false;
     }
+    inline static long readEpoch() {
+        return -1;
+    }
 
     inline static bool isProtected(const int tid, T * const obj) {
         return true;
@@ -48,6 +48,10 @@ public:
     void registerThread(const int tid) {}
     void unregisterThread(const int tid) {}
     void printStatus() {}
+    long long getApproxRetired() { return 0; }
+    long long getApproxRetiredBytes() { return 0; }
+    long long getApproxPooled() { return 0; }
+    long long getApproxPooledBytes() { return 0; }
     inline void qUnprotectAll(const int tid) {}
     inline void getReclaimers(const int tid, void ** const reclaimers, int index) {}
     inline void enterQuiescentState(const int tid) {}
@@ -101,6 +105,22 @@ public:
         mgr->printStatus();
         ((RecordManagerSet<Reclaim, Alloc, Pool, Rest...> *) this)->printStatus();
     }
+    long long getApproxRetired() {
+        return mgr->getApproxRetired()
+                + ((RecordManagerSet<Reclaim, Alloc, Pool, Rest...> *) this)->getApproxRetired();
+    }
+    long long getApproxRetiredBytes() {
+        return mgr->getApproxRetired() * (long long) sizeof(First)
+                + ((RecordManagerSet<Reclaim, Alloc, Pool, Rest...> *) this)->getApproxRetiredBytes();
+    }
+    long long getApproxPooled() {
+        return mgr->getApproxPooled()
+                + ((RecordManagerSet<Reclaim, Alloc, Pool, Rest...> *) this)->getApproxPooled();
+    }
+    long long getApproxPooledBytes() {
+        return mgr->getApproxPooled() * (long long) sizeof(First)
+                + ((RecordManagerSet<Reclaim, Alloc, Pool, Rest...> *) this)->getApproxPooledBytes();
+    }
     inline void qUnprotectAll(const int tid) {
         mgr->qUnprotectAll(tid);
         ((RecordManagerSet<Reclaim, Alloc, Pool, Rest...> *) this)->qUnprotectAll(tid);
@@ -171,6 +191,30 @@ public:
     void printStatus(void) {
         rmset->printStatus();
     }
+    // approximate number of retired records of all types that are waiting to
+    // be reclaimed. may be called while other threads operate.
+    long long getApproxRetired() {
+        return rmset->getApproxRetired();
+    }
+    long long getApproxRetiredBytes() {
+        return rmset->getApproxRetiredBytes();
+    }
+    // approximate number of records of all types that are held by the pools
+    // for reuse. may be called while other threads operate.
+    long long getApproxPooled() {
+        return rmset->getApproxPooled();
+    }
+    long long getApproxPooledBytes() {
+        return rmset->getApproxPooledBytes();
+    }
+    // epoch of the reclaimer for the first record type, which is the one that
+    // decides when records of every type are reclaimed (see
+    // RecordManagerSet::leaveQuiescentState). records a thread could access
+    // while it was not quiescent are not reclaimed until this changes. -1 if
+    // the reclaimer has no epochs.
+    inline long readEpoch() {
+        return rmset->get((RecordTypesFirst *) NULL)->readEpoch();
+    }
     template <typename T>
     debugInfo * getDebugInfo(T * const recordType) {
         return &rmset->get((T *) NULL)->debugInfoRecord;
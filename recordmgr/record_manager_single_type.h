@@ -134,6 +134,9 @@ public:
 //        assert(isQuiescent(tid));
         reclaim->leaveQuiescentState(tid, reclaimers, numReclaimers, readOnly);
     }
+    inline long readEpoch() {
+        return reclaim->readEpoch();
+    }
 
     // for all schemes except reference counting
     inline void retire(const int tid, record_pointer p) {
@@ -157,6 +160,17 @@ public:
         pool->add(tid, p);
     }
 
+    // number of retired records that are not yet reclaimed (see the
+    // reclaimer's getApproxSizeInNodes()).
+    long long getApproxRetired() {
+        return reclaim->getApproxSizeInNodes();
+    }
+    // number of records held by the pool for reuse (see the pool's
+    // getApproxSizeInNodes()).
+    long long getApproxPooled() {
+        return pool->getApproxSizeInNodes();
+    }
+
     void printStatus(void) {
         long long allocated = debugInfoRecord.getTotalAllocated();
         long long allocatedBytes = allocated * sizeof(Record);
@@ -12,23 +12,70 @@
 #ifndef BUNDLE_CLEANUP_SLEEP
 #error BUNDLE_CLEANUP_SLEEP NOT DEFINED
 #endif
+#include "bundle_cleaner.h"
+#endif
+
+// Thread ids reserved for background cleanup (see bundle_cleaner.h).
+#ifndef BUNDLE_CLEANUP_THREADS
+#define BUNDLE_CLEANUP_THREADS 1
+#endif
+
+// With update-driven cleanup, updates only trim bundles that hold more than
+// this many entries, which bounds how often an update pays for trimming.
+#ifdef BUNDLE_CLEANUP_UPDATE
+#ifndef BUNDLE_CLEANUP_UPDATE_THRESHOLD
+#define BUNDLE_CLEANUP_UPDATE_THRESHOLD 4
+#endif
+#endif
+
+// With BUNDLE_SAMPLE_LENGTHS, every this many bundles it prepares, an update
+// records the length of the bundle, so the average length can be monitored
+// while the benchmark runs. Without it, updates record nothing.
+#ifdef BUNDLE_SAMPLE_LENGTHS
+#ifndef BUNDLE_LENGTH_SAMPLE_PERIOD
+#define BUNDLE_LENGTH_SAMPLE_PERIOD 64
+#endif
+#endif
+
+// A range query that enters its range through a node newer than its timestamp
+// must restart. Its BUNDLE_RQ_MAX_RESTARTS-th restart instead enters the range
+// from the head of the data structure, following only bundles, which cannot
+// fail. This bounds the restarts of a range query however often updates
+// overtake it, at the cost of one traversal of the list below the range.
+#ifndef BUNDLE_RQ_MAX_RESTARTS
+#define BUNDLE_RQ_MAX_RESTARTS 4
 #endif
 
 #if defined BUNDLE_CIRCULAR_BUNDLE
 #include "circular_bundle.h"
+#ifndef BUNDLE_TYPE_DECL
+#define BUNDLE_TYPE_DECL CircularBundle
+#endif
 #elif defined BUNDLE_LINKED_BUNDLE
 #include "linked_bundle.h"
+#ifndef BUNDLE_TYPE_DECL
+#define BUNDLE_TYPE_DECL LinkedBundle
+#endif
+#elif defined BUNDLE_INLINE_BUNDLE
+#include "inline_bundle.h"
+#ifndef BUNDLE_TYPE_DECL
+#define BUNDLE_TYPE_DECL InlineBundle
+#endif
 #elif defined BUNDLE_UNSAFE_BUNDLE
 #include "unsafe_linked_bundle.h"
 #else
 #error NO BUNDLE TYPE DEFINED
 #endif
+#include "bundle_footprint.h"
+#include "rq_announcements.h"
+#include "timestamp_provider.h"
 
 // NOTES ON IMPLEMENTATION DETAILS.
 // --------------------------------
 // The active RQ array is the total number of processes to accomodate any
-// number of range query threads. Snapshots are still taken by iterating over
-// the list.
+// number of range query threads. Cleanup reads a cached snapshot of the oldest
+// active RQ, which a single thread at a time refreshes by iterating over the
+// list (see rq_announcements.h).
 
 // Ensures consistent view of data structure for range queries by augmenting
 // updates to keep track of their linearization points and observe any active
@@ -38,26 +85,11 @@ template <typename K, typename V, typename NodeType, typename DataStructure,
           bool canRetireNodesLogicallyDeletedByOtherProcesses>
 class RQProvider {
  private:
-#define __THREAD_DATA_SIZE 1024
-  // Used to announce an active range query and its linearization point.
-  union __rq_thread_data {
-    struct {
-      volatile timestamp_t rq_lin_time;
-      volatile char pad0[PREFETCH_SIZE_BYTES];
-      std::atomic<bool> rq_flag;
-#ifdef BUNDLE_TIMESTAMP_RELAXATION
-      volatile char pad1[PREFETCH_SIZE_BYTES];
-      volatile long local_timestamp;
-#endif
-    } data;
-    volatile char bytes[__THREAD_DATA_SIZE];
-  } __attribute__((aligned(__THREAD_DATA_SIZE)));
-
-  // Timestamp used by range queries to linearize accesses.
-  std::atomic<timestamp_t> curr_timestamp_;
-  volatile char pad0[PREFETCH_SIZE_BYTES];
-  // Array of RQ announcements. One per thread.
-  __rq_thread_data *rq_thread_data_;
+  // Source of the timestamps used by range queries to linearize accesses.
+  // Owned by this provider unless BUNDLE_SHARED_TIMESTAMPS is defined.
+  TimestampProvider *const timestamps_;
+  // RQ announcements. One per thread.
+  RQAnnouncements *const announcements_;
   // Number of processes concurrently operating on the data structure.
   const int num_processes_;
 
@@ -68,59 +100,84 @@ class RQProvider {
       0,
   };
 
-// Metadata for cleaning up with an independent thread.
+#ifdef BUNDLE_SAMPLE_LENGTHS
+  // Bundle lengths sampled by each thread's updates. Only written by its owner.
+  struct __length_samples_data {
+    long long prepared;  // Bundles prepared so far.
+    volatile long long sum;
+    volatile long long count;
+    volatile long long histogram[BUNDLE_LENGTH_HISTOGRAM_BUCKETS];
+  };
+  union __length_samples {
+    __length_samples_data data;
+    volatile char bytes[PREFETCH_SIZE_BYTES *
+                        ((sizeof(__length_samples_data) + PREFETCH_SIZE_BYTES -
+                          1) /
+                         PREFETCH_SIZE_BYTES)];
+  };
+
+  __length_samples length_samples_[MAX_TID_POW2];
+#endif
+
+// Metadata for cleaning up with independent threads.
 #ifdef BUNDLE_CLEANUP_BACKGROUND
-  struct cleanup_args {
-    std::atomic<bool> *const stop;
-    DataStructure *const ds;
-    int tid;
+  // Number of bundle entries created by each thread, which paces cleanup.
+  union __entries_created {
+    volatile long long count;
+    volatile char bytes[PREFETCH_SIZE_BYTES];
   };
 
-  pthread_t cleanup_thread_;
-  struct cleanup_args *cleanup_args_;
-  std::atomic<bool> stop_cleanup_;
+  __entries_created entries_created_[MAX_TID_POW2];
+  BundleCleaner<K, DataStructure, RQProvider> *cleaner_;
 #endif
 
  public:
   RQProvider(const int num_processes, DataStructure *ds, RecordManager *recmgr)
-      : num_processes_(num_processes), ds_(ds), recmgr_(recmgr) {
+#ifdef BUNDLE_SHARED_TIMESTAMPS
+      : timestamps_(&shared_bundle_timestamps()),
+        announcements_(&shared_bundle_announcements()),
+#else
+      : timestamps_(new TimestampProvider(default_timestamp_policy())),
+        announcements_(new RQAnnouncements(timestamps_, num_processes)),
+#endif
+        num_processes_(num_processes),
+        ds_(ds),
+        recmgr_(recmgr) {
     if (num_processes > MAX_TID_POW2) {
       cerr << "num_processes (" << num_processes << ") > maxthreads_pow2 ("
            << MAX_TID_POW2 << "): Please increase maxthreads_pow2 in config.mk";
       exit(1);
     }
-    rq_thread_data_ = new __rq_thread_data[num_processes];
-    for (int i = 0; i < num_processes; ++i) {
-      rq_thread_data_[i].data.rq_lin_time = BUNDLE_NULL_TIMESTAMP;
-      rq_thread_data_[i].data.rq_flag = false;
+#ifdef BUNDLE_SAMPLE_LENGTHS
+    for (int i = 0; i < MAX_TID_POW2; ++i) {
+      length_samples_[i].data.prepared = 0;
+      length_samples_[i].data.sum = 0;
+      length_samples_[i].data.count = 0;
+      for (int b = 0; b < BUNDLE_LENGTH_HISTOGRAM_BUCKETS; ++b) {
+        length_samples_[i].data.histogram[b] = 0;
+      }
     }
-    curr_timestamp_ = BUNDLE_MIN_TIMESTAMP;
+#endif
 
-// Launches a background thread to handle bundle entry cleanup.
+// Launches background threads to handle bundle entry cleanup. They use the
+// last thread ids.
 #ifdef BUNDLE_CLEANUP_BACKGROUND
-    cleanup_args_ = new cleanup_args{&stop_cleanup_, ds_, num_processes_ - 1};
-    if (pthread_create(&cleanup_thread_, nullptr, cleanup_run,
-                       (void *)cleanup_args_)) {
-      cerr << "ERROR: could not create thread" << endl;
-      exit(-1);
+    for (int i = 0; i < MAX_TID_POW2; ++i) {
+      entries_created_[i].count = 0;
     }
-    std::stringstream ss;
-    ss << "Cleanup started: 0x" << std::hex << cleanup_thread_ << std::endl;
-    std::cout << ss.str() << std::flush;
+    cleaner_ = new BundleCleaner<K, DataStructure, RQProvider>(
+        ds_, this, num_processes_ - BUNDLE_CLEANUP_THREADS);
 #endif
   }
 
   ~RQProvider() {
 #ifdef BUNDLE_CLEANUP_BACKGROUND
-    std::cout << "Stopping cleanup..." << std::endl << std::flush;
-    stop_cleanup_ = true;
-    if (pthread_join(cleanup_thread_, nullptr)) {
-      cerr << "ERROR: could not join thread" << endl;
-      exit(-1);
-    }
-    delete cleanup_args_;
+    delete cleaner_;
+#endif
+#ifndef BUNDLE_SHARED_TIMESTAMPS
+    delete announcements_;
+    delete timestamps_;
 #endif
-    delete[] rq_thread_data_;
   }
 
   void initThread(const int tid) {
@@ -157,88 +214,82 @@ class RQProvider {
 
 #define BUNDLE_INIT_CLEANUP(provider) \
   const timestamp_t ts = provider->get_oldest_active_rq();
-#define BUNDLE_CLEAN_BUNDLE(bundle) bundle->reclaimEntries(ts)
+#define BUNDLE_CLEAN_BUNDLE(bundle) rqProvider->clean_bundle(tid, &(bundle), ts)
 
-  // Creates a snapshot of the current state of active RQs.
-  inline timestamp_t get_oldest_active_rq() {
-    timestamp_t oldest_active = curr_timestamp_;
-    timestamp_t curr_rq;
-    for (int i = 0; i < num_processes_; ++i) {
-      while (rq_thread_data_[i].data.rq_flag == true)
-        ;  // Wait until RQ linearizes itself.
-      curr_rq = rq_thread_data_[i].data.rq_lin_time;
-      if (curr_rq != BUNDLE_NULL_TIMESTAMP && curr_rq < oldest_active) {
-        oldest_active = curr_rq;  // Update oldest.
-      }
+  // Trims the entries of bundle that are no longer needed by any range query
+  // active at or after ts.
+  inline void clean_bundle(const int tid, BUNDLE_TYPE_DECL<NodeType> *bundle,
+                           const timestamp_t ts) {
+#ifdef BUNDLE_CLEANUP_BACKGROUND
+    const int reclaimed = bundle->reclaimEntries(tid, ts, recmgr_);
+    if (cleaner_->isCleanupThread(tid)) {
+      cleaner_->record(tid, reclaimed, bundle->size());
     }
-    return oldest_active;
+#else
+    bundle->reclaimEntries(tid, ts, recmgr_);
+#endif
   }
 
 #ifdef BUNDLE_CLEANUP_BACKGROUND
-  static void *cleanup_run(void *args) {
-    std::cout << "Staring cleanup" << std::endl << std::flush;
-    struct cleanup_args *c = (struct cleanup_args *)args;
-    long i = 0;
-    while (!(*(c->stop))) {
-      usleep(BUNDLE_CLEANUP_SLEEP);
-      c->ds->cleanup(c->tid);
+  // [UNSAFE] Returns the number of bundle entries created so far.
+  long long get_entries_created() {
+    long long created = 0;
+    for (int i = 0; i < num_processes_; ++i) {
+      created += entries_created_[i].count;
     }
-    pthread_exit(nullptr);
+    return created;
   }
 #endif
 
-  // Atomically increments the global timestamp and returns the new value to the
-  // caller.
-  inline timestamp_t get_update_lin_time(int tid) {
-#ifdef BUNDLE_RQ_TS
-    return curr_timestamp_;
+  // Returns the sum and number of the bundle lengths sampled by updates so far
+  // (both zero without BUNDLE_SAMPLE_LENGTHS). Safe to call concurrently with
+  // updates, although the two values may be read at slightly different times.
+  void get_bundle_length_samples(long long &sum, long long &count) {
+    sum = 0;
+    count = 0;
+#ifdef BUNDLE_SAMPLE_LENGTHS
+    for (int i = 0; i < num_processes_; ++i) {
+      count += length_samples_[i].data.count;
+      sum += length_samples_[i].data.sum;
+    }
 #endif
+  }
 
-#ifndef BUNDLE_UNSAFE_BUNDLE
-#ifdef BUNDLE_TIMESTAMP_RELAXATION
-    if (((rq_thread_data_[tid].data.local_timestamp + 1) %
-         BUNDLE_TIMESTAMP_RELAXATION) == 0) {
-      ++rq_thread_data_[tid].data.local_timestamp;
-      return curr_timestamp_.fetch_add(1) + 1;
-    } else {
-      ++rq_thread_data_[tid].data.local_timestamp;
-      return curr_timestamp_;
-    }
-#elif defined(BUNDLE_UPDATE_USES_CAS)
-    timestamp_t ts = curr_timestamp_;
-    if (curr_timestamp_.compare_exchange_strong(ts, ts + 1)) {
-      return ts + 1;
-    } else {
-      return ts;
+  // Adds the histogram of the bundle lengths sampled by updates so far to
+  // histogram. Safe to call concurrently with updates.
+  void get_bundle_length_histogram(BundleLengthHistogram &histogram) {
+#ifdef BUNDLE_SAMPLE_LENGTHS
+    for (int i = 0; i < num_processes_; ++i) {
+      for (int b = 0; b < BUNDLE_LENGTH_HISTOGRAM_BUCKETS; ++b) {
+        histogram.counts[b] += length_samples_[i].data.histogram[b];
+      }
     }
-#else
-    return curr_timestamp_.fetch_add(1) + 1;
 #endif
-    // return curr_timestamp_;
+  }
+
+  // Creates a snapshot of the current state of active RQs. If another thread
+  // is already doing so, returns the last snapshot instead of waiting.
+  inline timestamp_t get_oldest_active_rq() {
+    return announcements_->refresh();
+  }
+
+  // Returns the timestamp of an update whose bundles are prepared. Its
+  // linearizing write must follow.
+  inline timestamp_t get_update_lin_time(int tid) {
+#ifndef BUNDLE_UNSAFE_BUNDLE
+    return timestamps_->update(tid);
 #else
     return BUNDLE_MIN_TIMESTAMP;
-#endif
 #endif
   }
 
+  timestamp_policy_t get_timestamp_policy() { return timestamps_->policy(); }
+
   // Write the range query linearization time so updates do not recycle any
   // edges needed by this range query.
   inline timestamp_t start_traversal(int tid) {
-#ifdef BUNDLE_RQTS
-#if defined(BUNDLE_UPDATE_USES_CAS)
-    timestamp_t ts = curr_timestamp_;
-    curr_timestamp_.compare_exchange_strong(ts, ts + 1);
-    return ts;
-#else
-    return curr_timestamp_.fetch_add(1);
-#endif
-#endif
-
 #ifndef BUNDLE_UNSAFE_BUNDLE
-    rq_thread_data_[tid].data.rq_flag = true;
-    rq_thread_data_[tid].data.rq_lin_time = curr_timestamp_;
-    rq_thread_data_[tid].data.rq_flag = false;
-    return rq_thread_data_[tid].data.rq_lin_time;
+    return announcements_->announce(tid);
 #else
     return BUNDLE_MIN_TIMESTAMP;
 #endif
@@ -270,28 +321,67 @@ class RQProvider {
 #endif
   }
 
+  // Records that a range query restarted restarts times before it succeeded.
+  // With GSTATS, the restarts of each range query that restarted are appended
+  // to rq_restarts (GSTATS ignore zeros), and range queries that entered their
+  // range from the head (see BUNDLE_RQ_MAX_RESTARTS) are counted in
+  // rq_fallbacks.
+  inline void count_restarts(const int tid, const int restarts) {
+#ifdef __HANDLE_STATS
+    if (restarts == 0) return;
+    GSTATS_APPEND(tid, rq_restarts, restarts);
+    if (restarts >= BUNDLE_RQ_MAX_RESTARTS) {
+      GSTATS_ADD(tid, rq_fallbacks, 1);
+    }
+#endif
+  }
+
   // Reset the range query linearization time so that updates may recycle an
   // edge we needed.
   inline void end_traversal(int tid) {
 #ifndef BUNDLE_UNSAFE_BUNDLE
-    rq_thread_data_[tid].data.rq_lin_time = BUNDLE_NULL_TIMESTAMP;
+    announcements_->retract(tid);
 #endif
   }
 
   // Prepares bundles by calling prepare on each provided bundle-pointer pair.
-  inline void prepare_bundles(BUNDLE_TYPE_DECL<NodeType> *bundles[],
+  // New bundle entries are taken from the calling thread's pool.
+  inline void prepare_bundles(const int tid,
+                              BUNDLE_TYPE_DECL<NodeType> *bundles[],
                               NodeType *const *const ptrs) {
     // PENDING_TIMESTAMP blocks all RQs that might see the update, ensuring that
     // the update is visible (i.e., get and RQ have the same linearization
     // point).
     SOFTWARE_BARRIER;
+#ifdef BUNDLE_CLEANUP_UPDATE
+    // Snapshot of the oldest active RQ, refreshed every few updates.
+    const timestamp_t oldest_rq = announcements_->oldest(tid);
+#endif
     int i = 0;
     BUNDLE_TYPE_DECL<NodeType> *curr_bundle = bundles[0];
     NodeType *curr_ptr = ptrs[0];
     while (curr_bundle != nullptr) {
-      curr_bundle->prepare(curr_ptr);
+      curr_bundle->prepare(tid, curr_ptr, recmgr_);
 #ifdef BUNDLE_CLEANUP_UPDATE
-      curr_bundle->reclaimEntries(get_oldest_active_rq());
+      if (curr_bundle->longerThan(BUNDLE_CLEANUP_UPDATE_THRESHOLD)) {
+        curr_bundle->reclaimEntries(tid, oldest_rq, recmgr_);
+      }
+#endif
+#ifdef BUNDLE_CLEANUP_BACKGROUND
+      ++entries_created_[tid].count;
+#endif
+#ifdef BUNDLE_SAMPLE_LENGTHS
+      if (unlikely(++length_samples_[tid].data.prepared %
+                       BUNDLE_LENGTH_SAMPLE_PERIOD ==
+                   0)) {
+        // Entries trimmed concurrently are only retired, so they stay
+        // allocated until this update finishes.
+        const int length = curr_bundle->size();
+        length_samples_[tid].data.sum += length;
+        ++length_samples_[tid].data.count;
+        ++length_samples_[tid].data.histogram[BundleLengthHistogram::bucketOf(
+            length)];
+      }
 #endif
       ++i;
       curr_bundle = bundles[i];
@@ -311,6 +401,16 @@ class RQProvider {
     SOFTWARE_BARRIER;
   }
 
+  // Gives the empty bundle of a node built by a bulk load its only entry.
+  // The node is not yet reachable from the data structure, so no lock is
+  // needed and the entry is labeled with the minimum timestamp, making it
+  // visible to every range query.
+  inline void init_bundle(const int tid, BUNDLE_TYPE_DECL<NodeType> *bundle,
+                          NodeType *const ptr) {
+    bundle->prepare(tid, ptr, recmgr_);
+    bundle->finalize(BUNDLE_MIN_TIMESTAMP);
+  }
+
   // Find and update the newest reference in the predecesor's bundle. If this
   // operation is an insert, then the new nodes bundle must also be
   // initialized. Any node whose bundle is passed here must be locked.
@@ -345,6 +445,8 @@ class RQProvider {
                                           NodeType *const *const deletedNodes) {
     int i;
     for (i = 0; deletedNodes[i]; ++i) {
+      // The node's bundle entries share its grace period.
+      ds_->retireBundles(tid, deletedNodes[i]);
       recmgr_->retire(tid, deletedNodes[i]);
     }
   }
@@ -382,4 +484,6 @@ class RQProvider {
 
     return res;
   }
-};
\ No newline at end of file
+};
+
+#endif  // BUNDLE_RQ_BUNDLE_H
@@ -18,14 +18,25 @@
 static thread_local int backoff_amt = 1;
 
 #ifdef NVCAS_OPTIMIZATION
-// Encodes a vCAS object
+// Every this many versions it installs, an update refreshes its cached copy of
+// the oldest timestamp announced by a range query. Versions older than the
+// newest one at or before that timestamp are unreachable by range queries, so
+// updates detach them from their vCAS object and retire them (see
+// truncate_vcas). Define VCAS_NO_TRUNCATE to keep every version instead.
+#ifndef VCAS_TRUNCATE_PERIOD
+#define VCAS_TRUNCATE_PERIOD 64
+#endif
+
+// Encodes a vCAS object. Versions are allocated from, and retired to, the
+// record manager of the data structure (see allocate_vcas), so its record
+// types must include vcas_obj_t<T> for every T the data structure versions.
 template <typename T>
 struct vcas_obj_t {
   T val;
   int ts;
+  // Set by the thread that retires this version (see retire_version).
+  volatile int retired;
   vcas_obj_t<T>* nextv;
-  vcas_obj_t(T val, vcas_obj_t<T>* nextv)
-      : val(val), nextv(nextv), ts(-1) {}  // TBD=-1
 };
 #endif
 
@@ -40,6 +51,10 @@ class RQProvider {
       struct {  // anonymous struct inside anonymous union means we don't need
                 // to type anything special to access these variables
         long long rq_lin_time;
+        // Cached oldest announced rq_lin_time, and the number of versions
+        // this thread may install before refreshing it.
+        long long oldest_rq_lin_time;
+        int versions_until_refresh;
       };
       char bytes[__RQ_THREAD_DATA_SIZE];  // avoid false sharing
     };
@@ -110,12 +125,40 @@ class RQProvider {
     }
   }
 
+  // Announces a lower bound on the snapshot before taking it, so that no
+  // update that missed the announcement can truncate a version it may need.
+  inline long long announceSnapshot(const int tid) {
+    threadData[tid].rq_lin_time = timestamp;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long ts = takeSnapshot(tid);
+    threadData[tid].rq_lin_time = ts;
+    return ts;
+  }
+
+  // Returns a timestamp that is no newer than the snapshot of any range query
+  // that is active, or that starts later (its snapshot is taken after its
+  // announcement, and the timestamp never decreases).
+  inline long long getOldestAnnouncedSnapshot() {
+    long long result = timestamp;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (int i = 0; i < NUM_PROCESSES; ++i) {
+      long long ts = threadData[i].rq_lin_time;
+      if (ts != TIMESTAMP_NOT_SET && ts < result) result = ts;
+    }
+    return result;
+  }
+
  public:
   static const int TBD = -1;
 
   RQProvider(const int numProcesses, DataStructure* ds, RecordManager* recmgr)
       : NUM_PROCESSES(numProcesses), ds(ds), recmgr(recmgr) {
     threadData = new __rq_thread_data[numProcesses];
+    for (int i = 0; i < numProcesses; ++i) {
+      threadData[i].rq_lin_time = TIMESTAMP_NOT_SET;
+      threadData[i].oldest_rq_lin_time = TIMESTAMP_NOT_SET;
+      threadData[i].versions_until_refresh = 0;
+    }
     DEBUG_INIT_RQPROVIDER(numProcesses);
   }
 
@@ -152,6 +195,67 @@ class RQProvider {
   // invoke whenever a new node is created/initialized
   inline void init_node(const int tid, NodeType* const node) {}
 
+  // Allocates a version holding val, with no timestamp yet and no older
+  // version. Used for the initial version of each vCAS object of a new node.
+  template <typename T>
+  inline vcas_obj_t<T>* allocate_vcas(const int tid, const T val) {
+    vcas_obj_t<T>* vcas_obj = recmgr->template allocate<vcas_obj_t<T>>(tid);
+    vcas_obj->val = val;
+    vcas_obj->ts = TBD;
+    vcas_obj->retired = 0;
+    vcas_obj->nextv = nullptr;
+    return vcas_obj;
+  }
+
+  // Retires a version, unless another thread already did. A thread that
+  // truncates a vCAS object can reach the same versions as another one
+  // truncating it, or retiring the node that holds it, at the same time.
+  template <typename T>
+  inline void retire_version(const int tid, vcas_obj_t<T>* const version) {
+    if (version->retired == 0 && CAS(&version->retired, 0, 1)) {
+      recmgr->retire(tid, version);
+    }
+  }
+
+  // Retires every version of a vCAS object of a node that is being retired.
+  // The versions stay linked, so range queries that are still traversing the
+  // node can follow them until the record manager recycles them.
+  template <typename T>
+  inline void retire_vcas(const int tid, vcas_obj_t<T>* vcas_obj) {
+    while (vcas_obj != nullptr) {
+      vcas_obj_t<T>* next = vcas_obj->nextv;
+      retire_version(tid, vcas_obj);
+      vcas_obj = next;
+    }
+  }
+
+  // Detaches and retires the versions of a vCAS object that are older than
+  // the newest version at or before the oldest announced snapshot. No range
+  // query can reach them, since each stops at the first version at or before
+  // its snapshot. head must have a timestamp.
+  template <typename T>
+  inline void truncate_vcas(const int tid, vcas_obj_t<T>* head) {
+#ifndef VCAS_NO_TRUNCATE
+    if (--threadData[tid].versions_until_refresh <= 0) {
+      threadData[tid].oldest_rq_lin_time = getOldestAnnouncedSnapshot();
+      threadData[tid].versions_until_refresh = VCAS_TRUNCATE_PERIOD;
+    }
+    const long long oldest = threadData[tid].oldest_rq_lin_time;
+    vcas_obj_t<T>* last = head;
+    while (last->ts > oldest) {
+      last = last->nextv;
+      if (last == nullptr) return;
+    }
+    if (last->nextv == nullptr) return;
+    vcas_obj_t<T>* curr = __sync_lock_test_and_set(&last->nextv, nullptr);
+    while (curr != nullptr) {
+      vcas_obj_t<T>* next = curr->nextv;
+      retire_version(tid, curr);
+      curr = next;
+    }
+#endif
+  }
+
   // for each address addr that is modified by rq_linearize_update_at_write
   // or rq_linearize_update_at_cas, you must replace any initialization of addr
   // with invocations of rq_write_addr
@@ -234,6 +338,7 @@ class RQProvider {
                                           NodeType* const* const deletedNodes) {
     int i;
     for (i = 0; deletedNodes[i]; ++i) {
+      ds->retireVersions(tid, deletedNodes[i]);
       recmgr->retire(tid, deletedNodes[i]);
     }
   }
@@ -279,12 +384,14 @@ class RQProvider {
     else if (lin_newval == lin_oldval)
       res = true;
     else {
-      vcas_obj_t<T>* new_head = new vcas_obj_t<T>(lin_newval, head);
+      vcas_obj_t<T>* new_head = allocate_vcas(tid, lin_newval);
+      new_head->nextv = head;
       res = CAS(lin_vcas_obj, head, new_head);
       if (res) {
         initTS(new_head);
+        truncate_vcas(tid, new_head);
       } else {
-        delete new_head;
+        recmgr->deallocate(tid, new_head);
         initTS(*lin_vcas_obj);
       }
     }
@@ -305,24 +412,7 @@ class RQProvider {
       announce_physical_deletion(tid, deletedNodes);
     }
 
-    long long ts = 1;
-    bool res;
-    vcas_obj_t<T>* head = *(lin_vcas_obj);
-    initTS(head);
-    if (head->val != lin_oldval)
-      res = false;
-    else if (lin_newval == lin_oldval)
-      res = true;
-    else {
-      vcas_obj_t<T>* new_head = new vcas_obj_t<T>(lin_newval, head);
-      res = CAS(lin_vcas_obj, head, new_head);
-      if (res) {
-        initTS(new_head);
-      } else {
-        delete new_head;
-        initTS(*lin_vcas_obj);
-      }
-    }
+    bool res = cas_vcas(tid, lin_vcas_obj, lin_oldval, lin_newval);
 
     if (res) {
       if (!logicalDeletion) {
@@ -342,7 +432,7 @@ class RQProvider {
   // invoke at the start of each traversal
   inline int traversal_start(const int tid) {
     // versionNodesTraversed = 0;
-    return takeSnapshot(tid);
+    return announceSnapshot(tid);
   }
 
   // invoke each time a traversal visits a node with a key in the desired range:
@@ -533,7 +623,7 @@ class RQProvider {
   // invoke at the start of each traversal
   inline int traversal_start(const int tid) {
     // versionNodesTraversed = 0;
-    return takeSnapshot(tid);
+    return announceSnapshot(tid);
   }
 
   // invoke each time a traversal visits a node with a key in the desired range:
@@ -574,6 +664,7 @@ class RQProvider {
     DEBUG_RECORD_RQ_SIZE(*startIndex);
     DEBUG_RECORD_RQ_CHECKSUM(tid, threadData[tid].rq_lin_time, rqResultKeys,
                              *startIndex);
+    threadData[tid].rq_lin_time = TIMESTAMP_NOT_SET;
   }
 };
 
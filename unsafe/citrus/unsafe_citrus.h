@@ -68,6 +68,13 @@ class unsafe_citrustree {
 #endif
 
   inline nodeptr newNode(const int tid, K key, V value);
+  // Builds a balanced subtree of nodes for the n sorted keys.
+  nodeptr bulkLoadSubtree(const int tid, const K* keys, const V* values,
+                          const int n);
+  // Joins subtrees[a..b] into a balanced tree using pivots[a+1..b], where
+  // pivots[i] separates subtrees[i-1] from subtrees[i].
+  nodeptr bulkLoadJoin(nodeptr* pivots, nodeptr* subtrees, const int a,
+                       const int b);
   long long debugKeySum(nodeptr root);
 
   bool validate(const int tid, nodeptr prev, int tag, nodeptr curr,
@@ -100,6 +107,17 @@ class unsafe_citrustree {
   int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
                  V* const resultValues);
   bool contains(const int tid, const K& key);
+  // Bulk loading of an empty tree that no other thread is using yet. Several
+  // threads may each build a part from a batch of sorted, distinct keys, then
+  // one thread joins the parts, given in increasing order of their keys, into
+  // a balanced tree (see bundle_citrus.h).
+  struct BulkLoadPart {
+    nodeptr pivot;
+    nodeptr subtree;
+  };
+  BulkLoadPart bulkLoadPart(const int tid, const K* keys, const V* values,
+                            const int n);
+  void bulkLoadFinish(const int tid, BulkLoadPart* parts, const int numParts);
   int size();  // warning: this is a linear time operation, and is not
                // linearizable
 
@@ -454,6 +454,72 @@ int unsafe_citrustree<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
   return cnt;
 }
 
+template <typename K, typename V, class RecManager>
+nodeptr unsafe_citrustree<K, V, RecManager>::bulkLoadSubtree(const int tid,
+                                                            const K* keys,
+                                                            const V* values,
+                                                            const int n) {
+  if (n == 0) return nullptr;
+  const int mid = n / 2;
+  nodeptr node = newNode(tid, keys[mid], values[mid]);
+  node->child[0] = bulkLoadSubtree(tid, keys, values, mid);
+  node->child[1] =
+      bulkLoadSubtree(tid, keys + mid + 1, values + mid + 1, n - mid - 1);
+  return node;
+}
+
+template <typename K, typename V, class RecManager>
+nodeptr unsafe_citrustree<K, V, RecManager>::bulkLoadJoin(nodeptr* pivots,
+                                                         nodeptr* subtrees,
+                                                         const int a,
+                                                         const int b) {
+  if (a == b) return subtrees[a];
+  const int mid = (a + b + 1) / 2;
+  pivots[mid]->child[0] = bulkLoadJoin(pivots, subtrees, a, mid - 1);
+  pivots[mid]->child[1] = bulkLoadJoin(pivots, subtrees, mid, b);
+  return pivots[mid];
+}
+
+template <typename K, typename V, class RecManager>
+typename unsafe_citrustree<K, V, RecManager>::BulkLoadPart
+unsafe_citrustree<K, V, RecManager>::bulkLoadPart(const int tid, const K* keys,
+                                                  const V* values,
+                                                  const int n) {
+  BulkLoadPart part = {nullptr, nullptr};
+  if (n > 0) {
+    part.pivot = newNode(tid, keys[0], values[0]);
+    part.subtree = bulkLoadSubtree(tid, keys + 1, values + 1, n - 1);
+  }
+  return part;
+}
+
+template <typename K, typename V, class RecManager>
+void unsafe_citrustree<K, V, RecManager>::bulkLoadFinish(const int tid,
+                                                         BulkLoadPart* parts,
+                                                         const int numParts) {
+  nodeptr rootchild = root->child[0];
+  assert(rootchild->child[0] == nullptr);
+  nodeptr* pivots = new nodeptr[numParts];
+  nodeptr* subtrees = new nodeptr[numParts];
+  int m = 0;
+  for (int i = 0; i < numParts; ++i) {
+    if (parts[i].pivot == nullptr) continue;
+    pivots[m] = parts[i].pivot;
+    subtrees[m] = parts[i].subtree;
+    ++m;
+  }
+  if (m > 0) {
+    // Nothing is smaller than the first pivot, so it heads its own subtree.
+    pivots[0]->child[1] = subtrees[0];
+    subtrees[0] = pivots[0];
+    nodeptr tree = bulkLoadJoin(pivots, subtrees, 0, m - 1);
+    SOFTWARE_BARRIER;
+    rootchild->child[0] = tree;
+  }
+  delete[] pivots;
+  delete[] subtrees;
+}
+
 template <typename K, typename V, class RecManager>
 long long unsafe_citrustree<K, V, RecManager>::debugKeySum(nodeptr root) {
   if (root == NULL) return 0;
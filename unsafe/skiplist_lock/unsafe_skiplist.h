@@ -103,6 +103,18 @@ class unsafe_skiplist {
   V erase(const int tid, const K& key);
   int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
                  V* const resultValues);
+  // Bulk loading of an empty skip-list that no other thread is using yet.
+  // Several threads may each build a part from a batch of sorted, distinct
+  // keys, drawing node heights as inserts do, then one thread links the parts,
+  // given in increasing order of their keys (see bundle_skiplist.h).
+  struct BulkLoadPart {
+    nodeptr first[SKIPLIST_MAX_LEVEL];
+    nodeptr last[SKIPLIST_MAX_LEVEL];
+  };
+  BulkLoadPart bulkLoadPart(const int tid, const K* keys, const V* values,
+                            const int n);
+  void bulkLoadFinish(const int tid, BulkLoadPart* parts, const int numParts);
+
   void initThread(const int tid);
   void deinitThread(const int tid);
 #ifdef USE_DEBUGCOUNTERS
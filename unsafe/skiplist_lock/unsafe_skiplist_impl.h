@@ -350,6 +350,55 @@ V unsafe_skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
   return ret;
 }
 
+template <typename K, typename V, class RecManager>
+typename unsafe_skiplist<K, V, RecManager>::BulkLoadPart
+unsafe_skiplist<K, V, RecManager>::bulkLoadPart(const int tid, const K* keys,
+                                                const V* values, const int n) {
+  BulkLoadPart part;
+  for (int level = 0; level < SKIPLIST_MAX_LEVEL; ++level) {
+    part.first[level] = nullptr;
+    part.last[level] = nullptr;
+  }
+  for (int i = 0; i < n; ++i) {
+    const int topLevel = sl_randomLevel(tid, threadRNGs);
+    nodeptr p_node = allocateNode(tid);
+    initNode(tid, p_node, keys[i], values[i], topLevel);
+    p_node->fullyLinked = 1;
+    for (int level = 0; level <= topLevel; ++level) {
+      if (part.last[level] == nullptr) {
+        part.first[level] = p_node;
+      } else {
+        part.last[level]->p_next[level] = p_node;
+      }
+      part.last[level] = p_node;
+    }
+  }
+  return part;
+}
+
+template <typename K, typename V, class RecManager>
+void unsafe_skiplist<K, V, RecManager>::bulkLoadFinish(const int tid,
+                                                       BulkLoadPart* parts,
+                                                       const int numParts) {
+  assert(p_head->p_next[0] == p_tail);
+  // Last node linked so far on each level (head until a part has one).
+  nodeptr p_preds[SKIPLIST_MAX_LEVEL];
+  for (int level = 0; level < SKIPLIST_MAX_LEVEL; ++level) {
+    p_preds[level] = p_head;
+  }
+  for (int i = 0; i < numParts; ++i) {
+    for (int level = 0; level < SKIPLIST_MAX_LEVEL; ++level) {
+      nodeptr p_node = parts[i].first[level];
+      if (p_node == nullptr) continue;
+      p_preds[level]->p_next[level] = p_node;
+      p_preds[level] = parts[i].last[level];
+    }
+  }
+  for (int level = 0; level < SKIPLIST_MAX_LEVEL; ++level) {
+    p_preds[level]->p_next[level] = p_tail;
+  }
+}
+
 template <typename K, typename V, class RecManager>
 V unsafe_skiplist<K, V, RecManager>::erase(const int tid, const K& key) {
   nodeptr p_preds[SKIPLIST_MAX_LEVEL] = {
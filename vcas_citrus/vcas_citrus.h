@@ -83,6 +83,7 @@ class citrustree {
     if (u->child[0]->val) dfsDeallocateBottomUp(u->child[0]->val, numNodes);
     if (u->child[1]->val) dfsDeallocateBottomUp(u->child[1]->val, numNodes);
     MEMORY_STATS++(*numNodes);
+    retireVersions(0 /* tid */, u);
     recordmgr->deallocate(0 /* tid */, u);
   }
 
@@ -107,6 +108,8 @@ class citrustree {
   bool contains(const int tid, const K& key);
   int size();  // warning: this is a linear time operation, and is not
                // linearizable
+  // Invoked by the RQProvider on each node it retires.
+  void retireVersions(const int tid, nodeptr node);
 
   node_t<K, V>* debug_getEntryPoint() { return root; }
 
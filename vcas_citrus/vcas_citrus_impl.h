@@ -50,9 +50,9 @@ nodeptr citrustree<K, V, RecManager>::newNode(const int tid, K key, V value) {
   nnode->marked = false;
 
   // Init vcas objects.
-  nnode->child[0] = new vcas_obj_t<nodeptr>(nullptr, nullptr);
+  nnode->child[0] = rqProvider->allocate_vcas(tid, (nodeptr)NULL);
   rqProvider->write_vcas(tid, nnode->child[0], (nodeptr)NULL);
-  nnode->child[1] = new vcas_obj_t<nodeptr>(nullptr, nullptr);
+  nnode->child[1] = rqProvider->allocate_vcas(tid, (nodeptr)NULL);
   rqProvider->write_vcas(tid, nnode->child[1], (nodeptr)NULL);
 
   nnode->tag[0] = 0;
@@ -68,6 +68,14 @@ nodeptr citrustree<K, V, RecManager>::newNode(const int tid, K key, V value) {
   return nnode;
 }
 
+// Retires the versions of the vcas objects of a node that is being retired.
+template <typename K, typename V, class RecManager>
+void citrustree<K, V, RecManager>::retireVersions(const int tid,
+                                                  nodeptr node) {
+  rqProvider->retire_vcas(tid, node->child[0]);
+  rqProvider->retire_vcas(tid, node->child[1]);
+}
+
 template <typename K, typename V, class RecManager>
 citrustree<K, V, RecManager>::citrustree(const K bigger_than_max_key,
                                          const V _NO_VALUE,
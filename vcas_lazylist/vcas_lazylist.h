@@ -60,6 +60,8 @@ class lazylist {
   V erase(const int tid, const K &key);
   int rangeQuery(const int tid, const K &lo, const K &hi, K *const resultKeys,
                  V *const resultValues);
+  // Invoked by the RQProvider on each node it retires.
+  void retireVersions(const int tid, nodeptr node);
 
   /**
    * This function must be called once by each thread that will
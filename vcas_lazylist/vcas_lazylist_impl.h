@@ -80,9 +80,11 @@ lazylist<K, V, RecManager>::~lazylist() {
   nodeptr curr = head;
   while (curr->key < KEY_MAX) {
     nodeptr next = curr->next->val;
+    retireVersions(dummyTid, curr);
     recordmgr->deallocate(dummyTid, curr);
     curr = next;
   }
+  retireVersions(dummyTid, curr);
   recordmgr->deallocate(dummyTid, curr);
   delete rqProvider;
   delete recordmgr;
@@ -124,9 +126,9 @@ nodeptr lazylist<K, V, RecManager>::new_node(const int tid, const K &key,
   rqProvider->init_node(tid, nnode);
   nnode->key = key;
   nnode->val = val;
-  nnode->marked = new vcas_obj_t<long long>(0LL, nullptr);
+  nnode->marked = rqProvider->allocate_vcas(tid, 0LL);
   rqProvider->write_vcas(tid, nnode->marked, 0LL);
-  nnode->next = new vcas_obj_t<nodeptr>(nullptr, nullptr);
+  nnode->next = rqProvider->allocate_vcas(tid, (nodeptr)nullptr);
   rqProvider->write_vcas(tid, nnode->next, next);
   nnode->lock = false;
 #ifdef __HANDLE_STATS
@@ -135,6 +137,13 @@ nodeptr lazylist<K, V, RecManager>::new_node(const int tid, const K &key,
   return nnode;
 }
 
+// Retires the versions of the vcas objects of a node that is being freed.
+template <typename K, typename V, class RecManager>
+void lazylist<K, V, RecManager>::retireVersions(const int tid, nodeptr node) {
+  rqProvider->retire_vcas(tid, node->marked);
+  rqProvider->retire_vcas(tid, node->next);
+}
+
 template <typename K, typename V, class RecManager>
 inline int lazylist<K, V, RecManager>::validateLinks(const int tid,
                                                      nodeptr pred,
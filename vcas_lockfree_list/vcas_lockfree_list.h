@@ -58,6 +58,7 @@ class list {
   nodeptr allocateNode(const int tid);
 
   void initNode(const int tid, nodeptr p_node, K key, V value);
+  void retireVersions(const int tid, nodeptr p_node);
   bool find_impl(const int tid, K key, nodeptr* p_pred, nodeptr* p_succ);
   V doInsert(const int tid, const K& key, const V& value, bool onlyIfAbsent);
 
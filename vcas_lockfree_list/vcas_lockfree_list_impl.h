@@ -59,7 +59,13 @@ void list<K, V, RecordMgr>::initNode(const int tid, nodeptr p_node, K key, V val
   rqProvider->init_node(tid, p_node);
   p_node->key = key;
   p_node->val = value;
-  p_node->p_next = new vcas_obj_t<nodeptr>(nullptr, nullptr);
+  p_node->p_next = rqProvider->allocate_vcas(tid, (nodeptr) nullptr);
+}
+
+// Retires the versions of the vcas object of a node that is being retired.
+template <typename K, typename V, class RecordMgr>
+void list<K, V, RecordMgr>::retireVersions(const int tid, nodeptr p_node) {
+  rqProvider->retire_vcas(tid, p_node->p_next);
 }
 
 template <typename K, typename V, class RecordMgr>
@@ -155,8 +161,10 @@ list<K, V, RecManager>::~list() {
   while (curr->key < KEY_MAX) {
     auto tmp = curr;
     curr = getUnmarked(rqProvider->read_vcas(dummyTid, curr->p_next));
+    retireVersions(dummyTid, tmp);
     recmgr->retire(dummyTid, tmp);
   }
+  retireVersions(dummyTid, curr);
   recmgr->retire(dummyTid, curr);
   delete rqProvider;
   recmgr->printStatus();
@@ -245,6 +253,7 @@ V list<K, V, RecManager>::doInsert(const int tid, const K& key, const V& value,
       
       rqProvider->write_vcas(tid, p_new_node->p_next, p_succ);
       if (!rqProvider->cas_vcas(tid, &(p_pred->p_next), p_succ, p_new_node)) {
+        retireVersions(tid, p_new_node);
         recmgr->retire(tid, p_new_node);
         recmgr->enterQuiescentState(tid);
         continue;
@@ -276,6 +285,7 @@ V list<K, V, RecManager>::erase(const int tid, const K& key) {
     if (result) {
       ret = victim->val;
       find_impl(tid, key, &p_pred, &p_succ);
+      retireVersions(tid, victim);
       recmgr->retire(tid, victim);
     }
     
@@ -65,6 +65,7 @@ class skiplist {
   nodeptr allocateNode(const int tid);
 
   void initNode(const int tid, nodeptr p_node, K key, V value, int height);
+  void retireVersions(const int tid, nodeptr p_node);
   int find_impl(const int tid, K key, nodeptr* p_preds, nodeptr* p_succs,
                 nodeptr* p_found);
   V doInsert(const int tid, const K& key, const V& value, bool onlyIfAbsent);
@@ -96,7 +96,15 @@ void skiplist<K, V, RecordMgr>::initNode(const int tid, nodeptr p_node, K key,
   p_node->fullyLinked = 0;
   //rqProvider->write_vcas(tid, p_node->fullyLinked, 0ll);
   for (int level = 0; level <= height; ++level) {
-    p_node->p_next[level] = new vcas_obj_t<nodeptr>(nullptr, nullptr);
+    p_node->p_next[level] = rqProvider->allocate_vcas(tid, (nodeptr) nullptr);
+  }
+}
+
+// Retires the versions of the vcas objects of a node that is being retired.
+template <typename K, typename V, class RecordMgr>
+void skiplist<K, V, RecordMgr>::retireVersions(const int tid, nodeptr p_node) {
+  for (int level = 0; level <= p_node->topLevel; ++level) {
+    rqProvider->retire_vcas(tid, p_node->p_next[level]);
   }
 }
 
@@ -203,8 +211,10 @@ skiplist<K, V, RecManager>::~skiplist() {
   while (curr->key < KEY_MAX) {
     auto tmp = curr;
     curr = getUnmarked(rqProvider->read_vcas(dummyTid, curr->p_next[0]));
+    retireVersions(dummyTid, tmp);
     recmgr->retire(dummyTid, tmp);
   }
+  retireVersions(dummyTid, curr);
   recmgr->retire(dummyTid, curr);
   delete rqProvider;
   recmgr->printStatus();
@@ -293,6 +303,7 @@ V skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
         if (lFound != -1) {
         
             if (allocated == true) {
+              retireVersions(tid, p_new_node);
               recmgr->retire(tid, p_new_node);
             }
 
@@ -351,6 +362,7 @@ V skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
         
         if (!BOOL_CAS(&(p_new_node->fullyLinked), 0, 1)) {
           find_impl(tid, key, p_preds, p_succs, NULL);
+          retireVersions(tid, p_new_node);
           recmgr->retire(tid, p_new_node);
         }
         
@@ -385,6 +397,7 @@ V skiplist<K, V, RecManager>::erase(const int tid, const K& key) {
       ret = p_victim->val;
       if (BOOL_CAS(&(p_victim->fullyLinked), 0, 1) == false) {
         find_impl(tid, key, p_preds, p_succs, NULL);
+        retireVersions(tid, p_victim);
         recmgr->retire(tid, p_victim);
       }
     }
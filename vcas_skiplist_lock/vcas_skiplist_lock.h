@@ -114,6 +114,8 @@ class skiplist {
   V erase(const int tid, const K& key);
   int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
                  V* const resultValues);
+  // Invoked by the RQProvider on each node it retires.
+  void retireVersions(const int tid, nodeptr p_node);
 
   void initThread(const int tid);
   void deinitThread(const int tid);
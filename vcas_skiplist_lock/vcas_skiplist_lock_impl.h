@@ -82,12 +82,22 @@ void skiplist<K, V, RecordMgr>::initNode(const int tid, nodeptr p_node, K key,
   p_node->lock = 0;
 
   // Allocate initial vcas objects, but leave as TBD
-  p_node->marked = new vcas_obj_t<long long>(0, nullptr);
+  p_node->marked = rqProvider->allocate_vcas(tid, 0ll);
   rqProvider->write_vcas(tid, p_node->marked, 0ll);
-  p_node->fullyLinked = new vcas_obj_t<long long>(0, nullptr);
+  p_node->fullyLinked = rqProvider->allocate_vcas(tid, 0ll);
   rqProvider->write_vcas(tid, p_node->fullyLinked, 0ll);
   for (int level = 0; level <= height; ++level) {
-    p_node->p_next[level] = new vcas_obj_t<nodeptr>(nullptr, nullptr);
+    p_node->p_next[level] = rqProvider->allocate_vcas(tid, (nodeptr) nullptr);
+  }
+}
+
+// Retires the versions of the vcas objects of a node that is being retired.
+template <typename K, typename V, class RecordMgr>
+void skiplist<K, V, RecordMgr>::retireVersions(const int tid, nodeptr p_node) {
+  rqProvider->retire_vcas(tid, p_node->marked);
+  rqProvider->retire_vcas(tid, p_node->fullyLinked);
+  for (int level = 0; level <= p_node->topLevel; ++level) {
+    rqProvider->retire_vcas(tid, p_node->p_next[level]);
   }
 }
 
@@ -175,8 +185,10 @@ skiplist<K, V, RecManager>::~skiplist() {
   while (curr->key < KEY_MAX) {
     auto tmp = curr;
     curr = rqProvider->read_vcas(dummyTid, curr->p_next[0]);
+    retireVersions(dummyTid, tmp);
     recmgr->retire(dummyTid, tmp);
   }
+  retireVersions(dummyTid, curr);
   recmgr->retire(dummyTid, curr);
   delete rqProvider;
   recmgr->printStatus();